@@ -48,6 +48,11 @@
 #ifdef ENABLE_LOCALES
 #include <locale.h>
 #endif
+#if !defined(CJSON_NO_SIMD) && defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#elif !defined(CJSON_NO_SIMD) && defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if defined(_MSC_VER)
 #pragma warning (pop)
@@ -237,949 +242,2387 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
-/* Internal constructor. */
-static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+/* Document arenas: every node and string of a parse comes out of a few big blocks, and the whole
+ * document goes away at once with cJSON_ResetArena/cJSON_DeleteArena instead of a free per node.
+ * Arena nodes are flagged cJSON_InArena and carry a pointer back to their arena just in front of
+ * them, so strings set on them later come from the same arena. */
+#define arena_alignment ((sizeof(double) > sizeof(void*)) ? sizeof(double) : sizeof(void*))
+#define arena_align(size) (((size) + arena_alignment - 1) & ~(arena_alignment - 1))
+#define arena_default_size 4096
+
+typedef struct arena_block
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
-    if (node)
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+} arena_block;
+
+#define arena_block_data(block) ((unsigned char*)(block) + arena_align(sizeof(arena_block)))
+
+struct cJSON_Arena
+{
+    internal_hooks hooks;
+    arena_block *blocks; /* newest first */
+    size_t block_size; /* size of a normal block */
+    size_t used; /* bytes handed out since the last reset, to size the block after it */
+};
+
+static arena_block *arena_new_block(cJSON_Arena * const arena, size_t size)
+{
+    arena_block *block = (arena_block*)arena->hooks.allocate(arena_align(sizeof(arena_block)) + size);
+    if (block == NULL)
     {
-        memset(node, '\0', sizeof(cJSON));
+        return NULL;
     }
+    block->next = arena->blocks;
+    block->size = size;
+    block->used = 0;
+    arena->blocks = block;
 
-    return node;
+    return block;
 }
 
-/* Delete a cJSON structure. */
-CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
 {
-    cJSON *next = NULL;
-    while (item != NULL)
+    arena_block *block = arena->blocks;
+    void *memory = NULL;
+
+    size = arena_align(size);
+    if ((block == NULL) || ((block->size - block->used) < size))
     {
-        next = item->next;
-        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
-        {
-            cJSON_Delete(item->child);
-        }
-        if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
-        {
-            global_hooks.deallocate(item->valuestring);
-        }
-        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+        block = arena_new_block(arena, (size > arena->block_size) ? size : arena->block_size);
+        if (block == NULL)
         {
-            global_hooks.deallocate(item->string);
+            return NULL;
         }
-        global_hooks.deallocate(item);
-        item = next;
     }
-}
 
-/* get the decimal point character of the current locale */
-static unsigned char get_decimal_point(void)
-{
-#ifdef ENABLE_LOCALES
-    struct lconv *lconv = localeconv();
-    return (unsigned char) lconv->decimal_point[0];
-#else
-    return '.';
-#endif
+    memory = arena_block_data(block) + block->used;
+    block->used += size;
+    arena->used += size;
+
+    return memory;
 }
 
-typedef struct
+static unsigned char *arena_strdup(cJSON_Arena * const arena, const unsigned char *string)
 {
-    const unsigned char *content;
-    size_t length;
-    size_t offset;
-    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
-    internal_hooks hooks;
-} parse_buffer;
+    size_t length = strlen((const char*)string) + sizeof("");
+    unsigned char *copy = (unsigned char*)arena_allocate(arena, length);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copy, string, length);
 
-/* check if the given size is left to read in a given parse buffer (starting with 1) */
-#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
-/* check if the buffer can be accessed at the given index (starting with 0) */
-#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
-#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
-/* get a pointer to the buffer at the position */
-#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+    return copy;
+}
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+static cJSON *arena_new_item(cJSON_Arena * const arena)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
-    size_t i = 0;
-
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    unsigned char *memory = (unsigned char*)arena_allocate(arena, arena_align(sizeof(cJSON_Arena*)) + sizeof(cJSON));
+    cJSON *node = NULL;
+    if (memory == NULL)
     {
-        return false;
+        return NULL;
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
-    {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
-
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
+    *(cJSON_Arena**)memory = arena;
+    node = (cJSON*)(memory + arena_align(sizeof(cJSON_Arena*)));
+    memset(node, '\0', sizeof(cJSON));
+    node->type = cJSON_InArena;
 
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    number_c_string[i] = '\0';
+    return node;
+}
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
-    {
-        return false; /* parse_error */
-    }
+/* the arena an item flagged cJSON_InArena came from */
+#define arena_of(item) (*(cJSON_Arena**)((unsigned char*)(item) - arena_align(sizeof(cJSON_Arena*))))
 
-    item->valuedouble = number;
+static void arena_free_blocks(cJSON_Arena * const arena)
+{
+    arena_block *block = arena->blocks;
+    arena_block *next = NULL;
 
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
+    while (block != NULL)
     {
-        item->valueint = INT_MAX;
+        next = block->next;
+        arena->hooks.deallocate(block);
+        block = next;
     }
-    else if (number <= (double)INT_MIN)
+    arena->blocks = NULL;
+}
+
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t size)
+{
+    cJSON_Arena *arena = (cJSON_Arena*)global_hooks.allocate(sizeof(cJSON_Arena));
+    if (arena == NULL)
     {
-        item->valueint = INT_MIN;
+        return NULL;
     }
-    else
+    memset(arena, '\0', sizeof(cJSON_Arena));
+    arena->hooks = global_hooks;
+    arena->block_size = (size > 0) ? arena_align(size) : arena_default_size;
+
+    if (arena_new_block(arena, arena->block_size) == NULL)
     {
-        item->valueint = (int)number;
+        arena->hooks.deallocate(arena);
+        return NULL;
     }
 
-    item->type = cJSON_Number;
-
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    return true;
+    return arena;
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
 {
-    if (number >= INT_MAX)
+    if (arena == NULL)
     {
-        object->valueint = INT_MAX;
+        return;
     }
-    else if (number <= (double)INT_MIN)
+
+    /* didn't fit in one block? swap them all for one big enough, so the next document does */
+    if ((arena->blocks == NULL) || (arena->blocks->next != NULL))
     {
-        object->valueint = INT_MIN;
+        arena_free_blocks(arena);
+        if (arena->used > arena->block_size)
+        {
+            arena->block_size = arena_align(arena->used);
+        }
+        arena_new_block(arena, arena->block_size);
     }
     else
     {
-        object->valueint = (int)number;
+        arena->blocks->used = 0;
     }
+    arena->used = 0;
+}
 
-    return object->valuedouble = number;
+CJSON_PUBLIC(size_t) cJSON_ArenaUsed(const cJSON_Arena *arena)
+{
+    return (arena != NULL) ? arena->used : 0;
 }
 
-CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena)
 {
-    char *copy = NULL;
-    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
-    if (!(object->type & cJSON_String) || (object->type & cJSON_IsReference))
-    {
-        return NULL;
-    }
-    if (strlen(valuestring) <= strlen(object->valuestring))
-    {
-        strcpy(object->valuestring, valuestring);
-        return object->valuestring;
-    }
-    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
-    if (copy == NULL)
-    {
-        return NULL;
-    }
-    if (object->valuestring != NULL)
+    if (arena == NULL)
     {
-        cJSON_free(object->valuestring);
+        return;
     }
-    object->valuestring = copy;
 
-    return copy;
+    arena_free_blocks(arena);
+    arena->hooks.deallocate(arena);
 }
 
-typedef struct
+/* Lookup table for big objects. It's built the first time a lookup has to walk past
+ * CJSON_INDEX_THRESHOLD members, kept up to date when members are appended, and dropped by anything
+ * else that changes the member list. Keys are hashed case folded so one table serves both kinds of
+ * lookup, and members with the same key sit in list order along their probe chain, so the first one
+ * still wins like it does in the list. */
+struct cJSON_Index
 {
-    unsigned char *buffer;
-    size_t length;
-    size_t offset;
-    size_t depth; /* current nesting depth (for formatted printing) */
-    cJSON_bool noalloc;
-    cJSON_bool format; /* is this print a formatted print */
-    internal_hooks hooks;
-} printbuffer;
+    size_t mask; /* slot count - 1 */
+    size_t count;
+    cJSON **slots;
+};
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static unsigned char* ensure(printbuffer * const p, size_t needed)
+static size_t index_hash(const unsigned char *key)
 {
-    unsigned char *newbuffer = NULL;
-    size_t newsize = 0;
-
-    if ((p == NULL) || (p->buffer == NULL))
+    /* FNV-1a */
+    size_t hash = 2166136261u;
+    for (; *key != '\0'; key++)
     {
-        return NULL;
+        hash ^= (size_t)tolower(*key);
+        hash *= 16777619u;
     }
 
-    if ((p->length > 0) && (p->offset >= p->length))
+    return hash;
+}
+
+static void index_put(struct cJSON_Index * const index, cJSON * const item)
+{
+    size_t slot = index_hash((const unsigned char*)item->string) & index->mask;
+    while (index->slots[slot] != NULL)
     {
-        /* make sure that offset is valid */
-        return NULL;
+        slot = (slot + 1) & index->mask;
     }
+    index->slots[slot] = item;
+    index->count++;
+}
 
-    if (needed > INT_MAX)
+static void index_drop(cJSON * const object)
+{
+    if (object->index == NULL)
     {
-        /* sizes bigger than INT_MAX are currently not supported */
-        return NULL;
+        return;
     }
-
-    needed += p->offset + 1;
-    if (needed <= p->length)
+    /* arena indexes go with the arena */
+    if (!(object->type & cJSON_InArena))
     {
-        return p->buffer + p->offset;
+        global_hooks.deallocate(object->index);
     }
+    object->index = NULL;
+}
 
-    if (p->noalloc) {
-        return NULL;
-    }
+static void index_build(cJSON * const object)
+{
+    struct cJSON_Index *index = NULL;
+    cJSON *child = NULL;
+    size_t members = 0;
+    size_t slots = 32;
+    size_t size = 0;
 
-    /* calculate new buffer size */
-    if (needed > (INT_MAX / 2))
+    for (child = object->child; child != NULL; child = child->next)
     {
-        /* overflow of int, use INT_MAX if possible */
-        if (needed <= INT_MAX)
-        {
-            newsize = INT_MAX;
-        }
-        else
+        /* a case sensitive walk stops at a nameless member, which the index can't do, so leave those linear */
+        if (child->string == NULL)
         {
-            return NULL;
+            return;
         }
+        members++;
     }
-    else
+    /* keep it at most half full so probes stay short */
+    while (slots < (members * 2))
     {
-        newsize = needed * 2;
+        slots *= 2;
     }
 
-    if (p->hooks.reallocate != NULL)
+    size = arena_align(sizeof(struct cJSON_Index)) + (slots * sizeof(cJSON*));
+    if (object->type & cJSON_InArena)
     {
-        /* reallocate with realloc if available */
-        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
-        if (newbuffer == NULL)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
-
-            return NULL;
-        }
+        index = (struct cJSON_Index*)arena_allocate(arena_of(object), size);
     }
     else
     {
-        /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
-        if (!newbuffer)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
+        index = (struct cJSON_Index*)global_hooks.allocate(size);
+    }
+    if (index == NULL)
+    {
+        return; /* lookups just stay linear */
+    }
 
-            return NULL;
-        }
+    index->mask = slots - 1;
+    index->count = 0;
+    index->slots = (cJSON**)((unsigned char*)index + arena_align(sizeof(struct cJSON_Index)));
+    memset(index->slots, '\0', slots * sizeof(cJSON*));
 
-        memcpy(newbuffer, p->buffer, p->offset + 1);
-        p->hooks.deallocate(p->buffer);
+    for (child = object->child; child != NULL; child = child->next)
+    {
+        index_put(index, child);
     }
-    p->length = newsize;
-    p->buffer = newbuffer;
-
-    return newbuffer + p->offset;
+    object->index = index;
 }
 
-/* calculate the new length of the string in a printbuffer and update the offset */
-static void update_offset(printbuffer * const buffer)
+/* a member was appended to object */
+static void index_append(cJSON * const object, cJSON * const item)
 {
-    const unsigned char *buffer_pointer = NULL;
-    if ((buffer == NULL) || (buffer->buffer == NULL))
+    if (object->index == NULL)
     {
         return;
     }
-    buffer_pointer = buffer->buffer + buffer->offset;
-
-    buffer->offset += strlen((const char*)buffer_pointer);
-}
-
-/* securely comparison of floating-point variables */
-static cJSON_bool compare_double(double a, double b)
-{
-    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
-    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+    if ((item->string == NULL) || (((object->index->count + 1) * 2) > (object->index->mask + 1)))
+    {
+        index_drop(object); /* full, or nameless (see index_build). The next long lookup rebuilds it if it can */
+        return;
+    }
+    index_put(object->index, item);
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* item is being swapped for replacement in object. Keeps the index if the key stays the same. */
+static void index_replace(cJSON * const object, const cJSON * const item, cJSON * const replacement)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
+    size_t slot = 0;
 
-    if (output_buffer == NULL)
+    if (object->index == NULL)
     {
-        return false;
+        return;
     }
-
-    /* This checks for NaN and Infinity */
-    if (isnan(d) || isinf(d))
+    if ((item->string == NULL) || (replacement->string == NULL) || (strcmp(item->string, replacement->string) != 0))
     {
-        length = sprintf((char*)number_buffer, "null");
+        index_drop(object);
+        return;
     }
-	else if(d == (double)item->valueint)
-	{
-		length = sprintf((char*)number_buffer, "%d", item->valueint);
-	}
-    else
+
+    slot = index_hash((const unsigned char*)item->string) & object->index->mask;
+    while (object->index->slots[slot] != NULL)
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
+        if (object->index->slots[slot] == item)
+        {
+            object->index->slots[slot] = replacement;
+            return;
+        }
+        slot = (slot + 1) & object->index->mask;
+    }
+    index_drop(object); /* wasn't in there, shouldn't happen */
+}
+
+static cJSON *index_lookup(const struct cJSON_Index * const index, const char * const name, const cJSON_bool case_sensitive)
+{
+    size_t slot = index_hash((const unsigned char*)name) & index->mask;
+    cJSON *item = NULL;
 
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
+    while ((item = index->slots[slot]) != NULL)
+    {
+        if (case_sensitive ? (strcmp(name, item->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)item->string) == 0))
         {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
+            return item;
         }
+        slot = (slot + 1) & index->mask;
     }
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    return NULL;
+}
+
+/* Internal constructor. */
+static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+{
+    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    if (node)
     {
-        return false;
+        memset(node, '\0', sizeof(cJSON));
     }
 
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
-    if (output_pointer == NULL)
+    return node;
+}
+
+/* In-situ nodes point into the buffer they were parsed from instead of owning their strings.
+ * Before one of them gets a string of its own, give it copies of the others so cJSON_Delete can free them all. */
+static cJSON_bool insitu_adopt(cJSON * const item, const internal_hooks * const hooks)
+{
+    unsigned char *string = NULL;
+    unsigned char *valuestring = NULL;
+
+    if (!(item->type & cJSON_InSitu))
     {
-        return false;
+        return true;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
     {
-        if (number_buffer[i] == decimal_point)
+        string = cJSON_strdup((const unsigned char*)item->string, hooks);
+        if (string == NULL)
         {
-            output_pointer[i] = '.';
-            continue;
+            return false;
+        }
+    }
+    if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
+    {
+        valuestring = cJSON_strdup((const unsigned char*)item->valuestring, hooks);
+        if (valuestring == NULL)
+        {
+            if (string != NULL)
+            {
+                hooks->deallocate(string);
+            }
+            return false;
         }
-
-        output_pointer[i] = number_buffer[i];
     }
-    output_pointer[i] = '\0';
 
-    output_buffer->offset += (size_t)length;
+    if (string != NULL)
+    {
+        item->string = (char*)string;
+    }
+    if (valuestring != NULL)
+    {
+        item->valuestring = (char*)valuestring;
+    }
+    item->type &= ~cJSON_InSitu;
 
     return true;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+/* Delete a cJSON structure. */
+CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
 {
-    unsigned int h = 0;
-    size_t i = 0;
-
-    for (i = 0; i < 4; i++)
+    cJSON *next = NULL;
+    while (item != NULL)
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
-        {
-            h += (unsigned int) input[i] - '0';
-        }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        next = item->next;
+        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
         {
-            h += (unsigned int) 10 + input[i] - 'A';
+            cJSON_Delete(item->child);
         }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        if (item->type & cJSON_InArena)
         {
-            h += (unsigned int) 10 + input[i] - 'a';
+            /* goes when the arena does */
+            item = next;
+            continue;
         }
-        else /* invalid */
+        index_drop(item);
+        if (!(item->type & (cJSON_IsReference | cJSON_InSitu)) && (item->valuestring != NULL))
         {
-            return 0;
+            global_hooks.deallocate(item->valuestring);
         }
-
-        if (i < 3)
+        if (!(item->type & (cJSON_StringIsConst | cJSON_InSitu)) && (item->string != NULL))
         {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
+            global_hooks.deallocate(item->string);
         }
+        global_hooks.deallocate(item);
+        item = next;
     }
+}
 
-    return h;
+/* get the decimal point character of the current locale */
+static unsigned char get_decimal_point(void)
+{
+#ifdef ENABLE_LOCALES
+    struct lconv *lconv = localeconv();
+    return (unsigned char) lconv->decimal_point[0];
+#else
+    return '.';
+#endif
 }
 
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+typedef struct
 {
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+    internal_hooks hooks;
+    cJSON_Arena *arena; /* nodes and strings come from here when set */
+    cJSON_bool in_situ; /* strings are unescaped in place, content is writable */
+} parse_buffer;
 
-    if ((input_end - first_sequence) < 6)
-    {
-        /* input ends unexpectedly */
-        goto fail;
-    }
+/* what a node keeps of its type when the parser sets it */
+#define parse_flags (cJSON_InArena | cJSON_InSitu)
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
+static void* cast_away_const(const void* string);
 
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+/* allocate a node or string for a parse, from the arena if there is one */
+static cJSON *parse_new_item(const parse_buffer * const input_buffer)
+{
+    cJSON *node = NULL;
+    if (input_buffer->arena != NULL)
     {
-        goto fail;
+        return arena_new_item(input_buffer->arena);
+    }
+    node = cJSON_New_Item(&input_buffer->hooks);
+    if ((node != NULL) && input_buffer->in_situ)
+    {
+        node->type = cJSON_InSitu;
     }
+    return node;
+}
 
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+static void *parse_allocate(const parse_buffer * const input_buffer, size_t size)
+{
+    if (input_buffer->arena != NULL)
     {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
+        return arena_allocate(input_buffer->arena, size);
+    }
+    return input_buffer->hooks.allocate(size);
+}
 
-        if ((input_end - second_sequence) < 6)
-        {
-            /* input ends unexpectedly */
-            goto fail;
-        }
+/* check if the given size is left to read in a given parse buffer (starting with 1) */
+#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+/* check if the buffer can be accessed at the given index (starting with 0) */
+#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
-        {
-            /* missing second half of the surrogate pair */
-            goto fail;
-        }
+/* Fast scanning: finds the next byte the parser has to look at, several bytes at a time.
+ * AVX2/SSE2 when the compiler targets them, word-at-a-time (SWAR) everywhere else, the Wii included.
+ * Hits are found in whole blocks and then pinned down by the byte loop at the end, so the result is
+ * the same whichever path ran. Build with CJSON_NO_SIMD for the plain byte loop. */
+#if !defined(CJSON_NO_SIMD) && defined(__GNUC__) && (defined(__AVX2__) || defined(__SSE2__))
+#define scan_sse 1
+#elif !defined(CJSON_NO_SIMD)
+#define scan_swar 1
+#define scan_ones ((size_t)-1 / 0xFF)
+#define scan_highs (scan_ones * 0x80)
+/* high bit set in some byte if any byte of word is zero / less than n / more than n (n < 128) */
+#define scan_has_zero(word) (((word) - scan_ones) & ~(word) & scan_highs)
+#define scan_has_less(word, n) (((word) - (scan_ones * (n))) & ~(word) & scan_highs)
+#define scan_has_more(word, n) ((((word) + (scan_ones * (127 - (n)))) | (word)) & scan_highs)
+#endif
 
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+/* first quote, backslash or control character (< 0x20) in [pointer, end) */
+static const unsigned char *scan_string(const unsigned char *pointer, const unsigned char * const end)
+{
+#if defined(scan_sse) && defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    while ((end - pointer) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)pointer);
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                       _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask != 0)
         {
-            /* invalid second half of the surrogate pair */
-            goto fail;
+            return pointer + __builtin_ctz(mask);
         }
-
-
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
-    }
-    else
-    {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
+        pointer += 32;
     }
-
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80)
+#endif
+#if defined(scan_sse)
     {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        while ((end - pointer) >= 16)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)pointer);
+            __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+            if (mask != 0)
+            {
+                return pointer + __builtin_ctz(mask);
+            }
+            pointer += 16;
+        }
     }
-    else if (codepoint < 0x800)
+#elif defined(scan_swar)
+    while ((size_t)(end - pointer) >= sizeof(size_t))
     {
-        /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
+        size_t word = 0;
+        size_t quotes = 0;
+        size_t backslashes = 0;
+        memcpy(&word, pointer, sizeof(word));
+        quotes = word ^ (scan_ones * '\"');
+        backslashes = word ^ (scan_ones * '\\');
+        if (scan_has_zero(quotes) | scan_has_zero(backslashes) | scan_has_less(word, 0x20))
+        {
+            break; /* it's in this word */
+        }
+        pointer += sizeof(size_t);
     }
-    else if (codepoint < 0x10000)
+#endif
+
+    while ((pointer < end) && (*pointer != '\"') && (*pointer != '\\') && (*pointer >= 0x20))
     {
-        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 3;
-        first_byte_mark = 0xE0; /* 11100000 */
+        pointer++;
     }
-    else if (codepoint <= 0x10FFFF)
+
+    return pointer;
+}
+
+/* first byte that isn't whitespace (> 32, like buffer_skip_whitespace) in [pointer, end).
+ * Byte at a time: runs between tokens are a few bytes even in pretty printed text, too
+ * short for a wide compare to pay for itself (see tools/jsonbench). */
+static const unsigned char *scan_whitespace(const unsigned char *pointer, const unsigned char * const end)
+{
+    /* most of the time there's none, or one space */
+    if ((pointer < end) && (*pointer > 32))
     {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
+        return pointer;
     }
-    else
+
+    while ((pointer < end) && (*pointer <= 32))
     {
-        /* invalid unicode codepoint */
-        goto fail;
+        pointer++;
     }
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    return pointer;
+}
+
+/* Parse the input text to generate a number, and populate the result into item. */
+/* Fast number paths. A decimal with at most 15 significant digits is exact as a double, and so is 10^n up
+ * to 10^22, so one multiply or divide of the two is correctly rounded (Clinger's fast path): the same double
+ * strtod would give, without strtod. Anything else (long mantissas, big exponents) still goes to the libc. */
+static const double exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define max_exact_power 22
+#define max_fast_digits 15
+
+#define is_digit(character) (((character) >= '0') && ((character) <= '9'))
+
+/* parse a plain JSON number from [pointer, end) if it can be done exactly, without strtod.
+ * false means use the slow path, which also does the error handling. */
+static cJSON_bool parse_number_fast(const unsigned char *pointer, const unsigned char * const end, const size_t max_length, double * const number, size_t * const length)
+{
+    const unsigned char * const start = pointer;
+    double mantissa = 0;
+    int digits = 0; /* significant digits in mantissa */
+    int exponent = 0;
+    int written_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool negative_exponent = false;
+
+    if ((pointer < end) && (*pointer == '-'))
     {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+        negative = true;
+        pointer++;
     }
-    /* encode first byte */
-    if (utf8_length > 1)
+    if ((pointer >= end) || !is_digit(*pointer))
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        return false;
     }
-    else
+    for (; (pointer < end) && is_digit(*pointer); pointer++)
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        if ((digits > 0) || (*pointer != '0'))
+        {
+            if (digits == max_fast_digits)
+            {
+                return false;
+            }
+            mantissa = (mantissa * 10) + (*pointer - '0');
+            digits++;
+        }
     }
 
-    *output_pointer += utf8_length;
+    if ((pointer < end) && (*pointer == '.'))
+    {
+        pointer++;
+        if ((pointer >= end) || !is_digit(*pointer))
+        {
+            return false;
+        }
+        for (; (pointer < end) && is_digit(*pointer); pointer++)
+        {
+            if ((digits > 0) || (*pointer != '0'))
+            {
+                if (digits == max_fast_digits)
+                {
+                    return false;
+                }
+                mantissa = (mantissa * 10) + (*pointer - '0');
+                digits++;
+            }
+            exponent--;
+        }
+    }
+
+    if ((pointer < end) && ((*pointer == 'e') || (*pointer == 'E')))
+    {
+        pointer++;
+        if ((pointer < end) && ((*pointer == '+') || (*pointer == '-')))
+        {
+            negative_exponent = (*pointer == '-');
+            pointer++;
+        }
+        if ((pointer >= end) || !is_digit(*pointer))
+        {
+            return false;
+        }
+        for (; (pointer < end) && is_digit(*pointer); pointer++)
+        {
+            if (written_exponent < 10000)
+            {
+                written_exponent = (written_exponent * 10) + (*pointer - '0');
+            }
+        }
+        exponent += negative_exponent ? -written_exponent : written_exponent;
+    }
+
+    /* the slow path only looks at this much */
+    if ((size_t)(pointer - start) > max_length)
+    {
+        return false;
+    }
+
+    if (mantissa == 0)
+    {
+        *number = 0;
+    }
+    else if ((exponent < -max_exact_power) || (exponent > max_exact_power))
+    {
+        return false;
+    }
+    else if (exponent < 0)
+    {
+        *number = mantissa / exact_powers_of_ten[-exponent];
+    }
+    else
+    {
+        *number = mantissa * exact_powers_of_ten[exponent];
+    }
+    if (negative)
+    {
+        *number = -*number;
+    }
+    *length = (size_t)(pointer - start);
+
+    return true;
+}
+
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    unsigned char *after_end = NULL;
+    unsigned char number_c_string[64];
+    unsigned char decimal_point = get_decimal_point();
+    size_t i = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
+    }
+
+    if (parse_number_fast(buffer_at_offset(input_buffer), input_buffer->content + input_buffer->length, sizeof(number_c_string) - 1, &number, &i))
+    {
+        input_buffer->offset += i;
+        goto number_done;
+    }
+
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    {
+        switch (buffer_at_offset(input_buffer)[i])
+        {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+                number_c_string[i] = buffer_at_offset(input_buffer)[i];
+                break;
+
+            case '.':
+                number_c_string[i] = decimal_point;
+                break;
+
+            default:
+                goto loop_end;
+        }
+    }
+loop_end:
+    number_c_string[i] = '\0';
+
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
+    {
+        return false; /* parse_error */
+    }
+    input_buffer->offset += (size_t)(after_end - number_c_string);
+
+number_done:
+    item->valuedouble = number;
+
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
+    {
+        item->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
+    {
+        item->valueint = (int)number;
+    }
+
+    item->type = cJSON_Number | (item->type & parse_flags);
+
+    return true;
+}
+
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+{
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+
+    return object->valuedouble = number;
+}
+
+CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+{
+    char *copy = NULL;
+    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
+    if (!(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    {
+        return NULL;
+    }
+    if (strlen(valuestring) <= strlen(object->valuestring))
+    {
+        strcpy(object->valuestring, valuestring);
+        return object->valuestring;
+    }
+    if (object->type & cJSON_InArena)
+    {
+        copy = (char*) arena_strdup(arena_of(object), (const unsigned char*)valuestring);
+        if (copy == NULL)
+        {
+            return NULL;
+        }
+        object->valuestring = copy;
+        return copy;
+    }
+    if (!insitu_adopt(object, &global_hooks))
+    {
+        return NULL;
+    }
+    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    if (object->valuestring != NULL)
+    {
+        cJSON_free(object->valuestring);
+    }
+    object->valuestring = copy;
+
+    return copy;
+}
+
+typedef struct
+{
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t depth; /* current nesting depth (for formatted printing) */
+    cJSON_bool noalloc;
+    cJSON_bool format; /* is this print a formatted print */
+    internal_hooks hooks;
+} printbuffer;
+
+/* realloc printbuffer if necessary to have at least "needed" bytes more */
+static unsigned char* ensure(printbuffer * const p, size_t needed)
+{
+    unsigned char *newbuffer = NULL;
+    size_t newsize = 0;
+
+    if ((p == NULL) || (p->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    if ((p->length > 0) && (p->offset >= p->length))
+    {
+        /* make sure that offset is valid */
+        return NULL;
+    }
+
+    if (needed > INT_MAX)
+    {
+        /* sizes bigger than INT_MAX are currently not supported */
+        return NULL;
+    }
+
+    needed += p->offset + 1;
+    if (needed <= p->length)
+    {
+        return p->buffer + p->offset;
+    }
+
+    if (p->noalloc) {
+        return NULL;
+    }
+
+    /* calculate new buffer size */
+    if (needed > (INT_MAX / 2))
+    {
+        /* overflow of int, use INT_MAX if possible */
+        if (needed <= INT_MAX)
+        {
+            newsize = INT_MAX;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        newsize = needed * 2;
+    }
+
+    if (p->hooks.reallocate != NULL)
+    {
+        /* reallocate with realloc if available */
+        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
+        if (newbuffer == NULL)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+    }
+    else
+    {
+        /* otherwise reallocate manually */
+        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
+        if (!newbuffer)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+
+        memcpy(newbuffer, p->buffer, p->offset + 1);
+        p->hooks.deallocate(p->buffer);
+    }
+    p->length = newsize;
+    p->buffer = newbuffer;
+
+    return newbuffer + p->offset;
+}
+
+/* calculate the new length of the string in a printbuffer and update the offset */
+static void update_offset(printbuffer * const buffer)
+{
+    const unsigned char *buffer_pointer = NULL;
+    if ((buffer == NULL) || (buffer->buffer == NULL))
+    {
+        return;
+    }
+    buffer_pointer = buffer->buffer + buffer->offset;
+
+    buffer->offset += strlen((const char*)buffer_pointer);
+}
+
+/* securely comparison of floating-point variables */
+static cJSON_bool compare_double(double a, double b)
+{
+    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+}
+
+/* write a whole number below 10^15 in decimal, returns how many digits */
+static int format_digits(double integer, unsigned char * const output)
+{
+    /* two halves that fit in 32 bits, a double this size isn't something to divide by 10 over and over */
+    unsigned long high = (unsigned long)floor(integer / 1e8);
+    unsigned long low = (unsigned long)(integer - ((double)high * 1e8));
+    unsigned char reversed[16];
+    int count = 0;
+    int i = 0;
+
+    do
+    {
+        reversed[count++] = (unsigned char)('0' + (low % 10));
+        low /= 10;
+    } while ((low > 0) || ((high > 0) && (count < 8)));
+    while (high > 0)
+    {
+        reversed[count++] = (unsigned char)('0' + (high % 10));
+        high /= 10;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        output[i] = reversed[count - 1 - i];
+    }
+
+    return count;
+}
+
+/* The shortest decimal that reads back as d, if it has at most 15 digits and %1.15g would print it without an
+ * exponent (so it's the same text, just no sprintf). Finds the smallest n where d * 10^n rounded to a whole m
+ * gives back d as m / 10^n, which is exact by the same argument as parse_number_fast. 0 if there isn't one. */
+static int format_number_fast(double d, unsigned char * const number_buffer)
+{
+    unsigned char digits[16];
+    double magnitude = fabs(d);
+    double scaled = 0;
+    int count = 0;
+    int power = 0;
+    int length = 0;
+    int i = 0;
+
+    if (!((magnitude >= 1e-4) && (magnitude < 1e15)))
+    {
+        return 0;
+    }
+    for (power = 0; power <= max_exact_power; power++)
+    {
+        scaled = floor((magnitude * exact_powers_of_ten[power]) + 0.5);
+        if (scaled >= 1e15)
+        {
+            return 0; /* needs more than 15 digits */
+        }
+        if ((scaled > 0) && ((scaled / exact_powers_of_ten[power]) == magnitude))
+        {
+            break;
+        }
+    }
+    if (power > max_exact_power)
+    {
+        return 0;
+    }
+
+    count = format_digits(scaled, digits);
+    if (d < 0)
+    {
+        number_buffer[length++] = '-';
+    }
+    if (count <= power)
+    {
+        /* 0.000ddd */
+        number_buffer[length++] = '0';
+        number_buffer[length++] = '.';
+        for (i = count; i < power; i++)
+        {
+            number_buffer[length++] = '0';
+        }
+        memcpy(number_buffer + length, digits, (size_t)count);
+        length += count;
+    }
+    else
+    {
+        memcpy(number_buffer + length, digits, (size_t)(count - power));
+        length += count - power;
+        if (power > 0)
+        {
+            number_buffer[length++] = '.';
+            memcpy(number_buffer + length, digits + count - power, (size_t)power);
+            length += power;
+        }
+    }
+    number_buffer[length] = '\0';
+
+    return length;
+}
+
+/* Render a number as JSON text into number_buffer (at least 26 bytes), returns its length or -1 */
+static int format_number(double d, int valueint, unsigned char * const number_buffer)
+{
+    int length = 0;
+    int i = 0;
+    unsigned char decimal_point = get_decimal_point();
+    double test = 0.0;
+
+    /* This checks for NaN and Infinity */
+    if (isnan(d) || isinf(d))
+    {
+        length = sprintf((char*)number_buffer, "null");
+    }
+	else if(d == (double)valueint)
+	{
+		/* whole numbers go through the fast path (as %d would print them), except 0 and -0 */
+		length = (valueint != 0) ? format_number_fast(d, number_buffer) : sprintf((char*)number_buffer, "0");
+	}
+    else
+    {
+        length = format_number_fast(d, number_buffer);
+        if (length == 0)
+        {
+            /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
+            length = sprintf((char*)number_buffer, "%1.15g", d);
+
+            /* Check whether the original double can be recovered, if not try 16 and then 17 (always enough).
+             * Not 16 between 1e16 and 1e17 though, that's where %1.16g goes to an exponent and %1.17g doesn't. */
+            if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || (test != d))
+            {
+                if ((fabs(d) < 1e16) || (fabs(d) >= 1e17))
+                {
+                    length = sprintf((char*)number_buffer, "%1.16g", d);
+                }
+                if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || (test != d))
+                {
+                    length = sprintf((char*)number_buffer, "%1.17g", d);
+                }
+            }
+        }
+    }
+
+    /* sprintf failed or buffer overrun occurred */
+    if ((length < 0) || (length > 25))
+    {
+        return -1;
+    }
+
+    /* replace locale dependent decimal point with '.' */
+    for (i = 0; i < length; i++)
+    {
+        if (number_buffer[i] == decimal_point)
+        {
+            number_buffer[i] = '.';
+        }
+    }
+
+    return length;
+}
+
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    int length = 0;
+    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    length = format_number(item->valuedouble, item->valueint, number_buffer);
+    if (length < 0)
+    {
+        return false;
+    }
+
+    /* reserve appropriate space in the output */
+    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    /* copy the printed number to the output */
+    memcpy(output_pointer, number_buffer, (size_t)length + sizeof(""));
+
+    output_buffer->offset += (size_t)length;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    unsigned int h = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9'))
+        {
+            h += (unsigned int) input[i] - '0';
+        }
+        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        {
+            h += (unsigned int) 10 + input[i] - 'A';
+        }
+        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        {
+            h += (unsigned int) 10 + input[i] - 'a';
+        }
+        else /* invalid */
+        {
+            return 0;
+        }
+
+        if (i < 3)
+        {
+            /* shift left to make place for the next nibble */
+            h = h << 4;
+        }
+    }
+
+    return h;
+}
+
+/* converts a UTF-16 literal to UTF-8
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+{
+    long unsigned int codepoint = 0;
+    unsigned int first_code = 0;
+    const unsigned char *first_sequence = input_pointer;
+    unsigned char utf8_length = 0;
+    unsigned char utf8_position = 0;
+    unsigned char sequence_length = 0;
+    unsigned char first_byte_mark = 0;
+
+    if ((input_end - first_sequence) < 6)
+    {
+        /* input ends unexpectedly */
+        goto fail;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = parse_hex4(first_sequence + 2);
+
+    /* check that the code is valid */
+    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    {
+        goto fail;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    {
+        const unsigned char *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+        sequence_length = 12; /* \uXXXX\uXXXX */
+
+        if ((input_end - second_sequence) < 6)
+        {
+            /* input ends unexpectedly */
+            goto fail;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        {
+            /* missing second half of the surrogate pair */
+            goto fail;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = parse_hex4(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        {
+            /* invalid second half of the surrogate pair */
+            goto fail;
+        }
+
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    }
+    else
+    {
+        sequence_length = 6; /* \uXXXX */
+        codepoint = first_code;
+    }
+
+    /* encode as UTF-8
+     * takes at maximum 4 bytes to encode:
+     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if (codepoint < 0x80)
+    {
+        /* normal ascii, encoding 0xxxxxxx */
+        utf8_length = 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        /* two bytes, encoding 110xxxxx 10xxxxxx */
+        utf8_length = 2;
+        first_byte_mark = 0xC0; /* 11000000 */
+    }
+    else if (codepoint < 0x10000)
+    {
+        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 3;
+        first_byte_mark = 0xE0; /* 11100000 */
+    }
+    else if (codepoint <= 0x10FFFF)
+    {
+        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 4;
+        first_byte_mark = 0xF0; /* 11110000 */
+    }
+    else
+    {
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+fail:
+    return 0;
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+    unsigned char *output_pointer = NULL;
+    unsigned char *output = NULL;
+
+    /* not a string */
+    if (buffer_at_offset(input_buffer)[0] != '\"')
+    {
+        goto fail;
+    }
+
+    {
+        /* calculate approximate size of the output (overestimate) */
+        size_t allocation_length = 0;
+        size_t skipped_bytes = 0;
+        const unsigned char *buffer_end = input_buffer->content + input_buffer->length;
+        for (;;)
+        {
+            /* jump to the next quote, backslash or control character */
+            input_end = scan_string(input_end, buffer_end);
+            if ((input_end >= buffer_end) || (*input_end == '\"'))
+            {
+                break;
+            }
+            /* is escape sequence */
+            if (input_end[0] == '\\')
+            {
+                if ((input_end + 1) >= buffer_end)
+                {
+                    /* prevent buffer overflow when last input character is a backslash */
+                    goto fail;
+                }
+                skipped_bytes++;
+                input_end++;
+            }
+            input_end++; /* the escaped character, or a control character (let through as is) */
+        }
+        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+        {
+            goto fail; /* string ended unexpectedly */
+        }
+
+        if (input_buffer->in_situ)
+        {
+            /* unescaping only ever shrinks the string, so it goes where it is, terminated at or before the closing quote */
+            output = (unsigned char*)cast_away_const(input_pointer);
+        }
+        else
+        {
+            /* This is at most how much we need for the output */
+            allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+            output = (unsigned char*)parse_allocate(input_buffer, allocation_length + sizeof(""));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
+        }
+    }
+
+    output_pointer = output;
+    /* loop through the string literal */
+    while (input_pointer < input_end)
+    {
+        if (*input_pointer != '\\')
+        {
+            /* copy up to the next escape sequence in one go */
+            const unsigned char *run_end = (const unsigned char*)memchr(input_pointer, '\\', (size_t)(input_end - input_pointer));
+            size_t run_length = (size_t)(((run_end != NULL) ? run_end : input_end) - input_pointer);
+            if (output_pointer != input_pointer)
+            {
+                memmove(output_pointer, input_pointer, run_length);
+            }
+            output_pointer += run_length;
+            input_pointer += run_length;
+        }
+        /* escape sequence */
+        else
+        {
+            unsigned char sequence_length = 2;
+            if ((input_end - input_pointer) < 1)
+            {
+                goto fail;
+            }
+
+            switch (input_pointer[1])
+            {
+                case 'b':
+                    *output_pointer++ = '\b';
+                    break;
+                case 'f':
+                    *output_pointer++ = '\f';
+                    break;
+                case 'n':
+                    *output_pointer++ = '\n';
+                    break;
+                case 'r':
+                    *output_pointer++ = '\r';
+                    break;
+                case 't':
+                    *output_pointer++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *output_pointer++ = input_pointer[1];
+                    break;
+
+                /* UTF-16 literal */
+                case 'u':
+                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
+                    if (sequence_length == 0)
+                    {
+                        /* failed to convert UTF16-literal to UTF-8 */
+                        goto fail;
+                    }
+                    break;
+
+                default:
+                    goto fail;
+            }
+            input_pointer += sequence_length;
+        }
+    }
+
+    /* zero terminate the output */
+    *output_pointer = '\0';
+
+    item->type = cJSON_String | (item->type & parse_flags);
+    item->valuestring = (char*)output;
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if ((output != NULL) && (input_buffer->arena == NULL) && !input_buffer->in_situ)
+    {
+        input_buffer->hooks.deallocate(output);
+    }
+
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
+}
+
+/* Render the cstring provided to an escaped version that can be printed. */
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    const unsigned char *input_pointer = NULL;
+    unsigned char *output = NULL;
+    unsigned char *output_pointer = NULL;
+    size_t output_length = 0;
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\""));
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+
+        return true;
+    }
+
+    /* set "flag" to 1 if something needs to be escaped */
+    for (input_pointer = input; *input_pointer; input_pointer++)
+    {
+        switch (*input_pointer)
+        {
+            case '\"':
+            case '\\':
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+                /* one character escape sequence */
+                escape_characters++;
+                break;
+            default:
+                if (*input_pointer < 32)
+                {
+                    /* UTF-16 escape sequence uXXXX */
+                    escape_characters += 5;
+                }
+                break;
+        }
+    }
+    output_length = (size_t)(input_pointer - input) + escape_characters;
+
+    output = ensure(output_buffer, output_length + sizeof("\"\""));
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    /* no characters have to be escaped */
+    if (escape_characters == 0)
+    {
+        output[0] = '\"';
+        memcpy(output + 1, input, output_length);
+        output[output_length + 1] = '\"';
+        output[output_length + 2] = '\0';
+
+        return true;
+    }
+
+    output[0] = '\"';
+    output_pointer = output + 1;
+    /* copy the string */
+    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    {
+        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        {
+            /* normal character, copy */
+            *output_pointer = *input_pointer;
+        }
+        else
+        {
+            /* character needs to be escaped */
+            *output_pointer++ = '\\';
+            switch (*input_pointer)
+            {
+                case '\\':
+                    *output_pointer = '\\';
+                    break;
+                case '\"':
+                    *output_pointer = '\"';
+                    break;
+                case '\b':
+                    *output_pointer = 'b';
+                    break;
+                case '\f':
+                    *output_pointer = 'f';
+                    break;
+                case '\n':
+                    *output_pointer = 'n';
+                    break;
+                case '\r':
+                    *output_pointer = 'r';
+                    break;
+                case '\t':
+                    *output_pointer = 't';
+                    break;
+                default:
+                    /* escape and print as unicode codepoint */
+                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
+                    output_pointer += 4;
+                    break;
+            }
+        }
+    }
+    output[output_length + 1] = '\"';
+    output[output_length + 2] = '\0';
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+{
+    return print_string_ptr((unsigned char*)item->valuestring, p);
+}
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+/* Utility to jump whitespace and cr/lf */
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return buffer;
+    }
+
+    buffer->offset = (size_t)(scan_whitespace(buffer_at_offset(buffer), buffer->content + buffer->length) - buffer->content);
+
+    if (buffer->offset == buffer->length)
+    {
+        buffer->offset--;
+    }
+
+    return buffer;
+}
+
+/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
+static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    {
+        return NULL;
+    }
+
+    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    {
+        buffer->offset += 3;
+    }
+
+    return buffer;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    size_t buffer_length;
+
+    if (NULL == value)
+    {
+        return NULL;
+    }
 
-    return sequence_length;
+    /* Adding null character size due to require_null_terminated. */
+    buffer_length = strlen(value) + sizeof("");
 
-fail:
-    return 0;
+    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+/* Parse an object - create a new root, and populate. */
+static cJSON *parse_with_length_opts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Arena *arena, cJSON_bool in_situ)
 {
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
-    unsigned char *output_pointer = NULL;
-    unsigned char *output = NULL;
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, NULL, false };
+    cJSON *item = NULL;
 
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"')
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+
+    if (value == NULL || 0 == buffer_length)
     {
         goto fail;
     }
 
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = global_hooks;
+    buffer.arena = arena;
+    buffer.in_situ = in_situ;
+
+    item = parse_new_item(&buffer);
+    if (item == NULL) /* memory fail */
     {
-        /* calculate approximate size of the output (overestimate) */
-        size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
-        {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
-            {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
-            }
-            input_end++;
-        }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
-        {
-            goto fail; /* string ended unexpectedly */
-        }
+        goto fail;
+    }
 
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
         {
-            goto fail; /* allocation failure */
+            goto fail;
         }
     }
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
 
-    output_pointer = output;
-    /* loop through the string literal */
-    while (input_pointer < input_end)
+    return item;
+
+fail:
+    if (item != NULL)
     {
-        if (*input_pointer != '\\')
+        cJSON_Delete(item);
+    }
+
+    if (value != NULL)
+    {
+        error local_error;
+        local_error.json = (const unsigned char*)value;
+        local_error.position = 0;
+
+        if (buffer.offset < buffer.length)
         {
-            *output_pointer++ = *input_pointer++;
+            local_error.position = buffer.offset;
         }
-        /* escape sequence */
-        else
+        else if (buffer.length > 0)
         {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1)
-            {
-                goto fail;
-            }
+            local_error.position = buffer.length - 1;
+        }
 
-            switch (input_pointer[1])
-            {
-                case 'b':
-                    *output_pointer++ = '\b';
-                    break;
-                case 'f':
-                    *output_pointer++ = '\f';
-                    break;
-                case 'n':
-                    *output_pointer++ = '\n';
-                    break;
-                case 'r':
-                    *output_pointer++ = '\r';
-                    break;
-                case 't':
-                    *output_pointer++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *output_pointer++ = input_pointer[1];
-                    break;
+        if (return_parse_end != NULL)
+        {
+            *return_parse_end = (const char*)local_error.json + local_error.position;
+        }
 
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
-                    if (sequence_length == 0)
-                    {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        goto fail;
-                    }
-                    break;
+        global_error = local_error;
+    }
 
-                default:
-                    goto fail;
-            }
-            input_pointer += sequence_length;
-        }
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_length_opts(value, buffer_length, return_parse_end, require_null_terminated, NULL, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value, size_t buffer_length)
+{
+    if (arena == NULL)
+    {
+        return NULL;
     }
+    return parse_with_length_opts(value, buffer_length, 0, 0, arena, false);
+}
 
-    /* zero terminate the output */
-    *output_pointer = '\0';
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse_with_length_opts(value, buffer_length, 0, 0, NULL, true);
+}
 
-    item->type = cJSON_String;
-    item->valuestring = (char*)output;
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
 
-    input_buffer->offset = (size_t) (input_end - input_buffer->content);
-    input_buffer->offset++;
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
 
-    return true;
+/* Streaming parser. Bytes are fed in whatever chunks they arrive in and the tree is built as they go,
+ * only the token being read (a string or number) is ever buffered. Strings and numbers are handed
+ * to parse_string/parse_number once complete, so the result is the same as cJSON_Parse. */
+typedef enum
+{
+    stream_value,           /* expecting a value */
+    stream_value_or_end,    /* expecting a value or ']' (right after '[') */
+    stream_key,             /* expecting a key (after ',' in an object) */
+    stream_key_or_end,      /* expecting a key or '}' (right after '{') */
+    stream_colon,           /* expecting ':' */
+    stream_after_value,     /* expecting ',' or the end of the container */
+    stream_in_string,
+    stream_in_number,
+    stream_in_literal,
+    stream_done,            /* root is complete, the rest is ignored (like cJSON_Parse) */
+    stream_failed
+} stream_state;
 
-fail:
-    if (output != NULL)
+typedef struct
+{
+    cJSON *container;
+    cJSON *last; /* last child, so appending doesn't walk the list */
+} stream_frame;
+
+struct cJSON_Stream
+{
+    internal_hooks hooks;
+    cJSON_Arena *arena; /* the tree comes from here when set */
+    stream_state state;
+    cJSON *root;
+    stream_frame *stack;
+    size_t depth;
+    size_t stack_size;
+    unsigned char *token; /* the string or number being read */
+    size_t token_length;
+    size_t token_size;
+    cJSON_bool token_is_key;
+    cJSON_bool escaped; /* last string byte was an unescaped backslash */
+    const char *literal; /* literal being matched, "\xEF\xBB\xBF" for the BOM */
+    size_t literal_offset;
+    size_t position; /* bytes fed so far */
+};
+
+static cJSON_bool stream_token_reserve(cJSON_Stream * const stream, size_t needed)
+{
+    unsigned char *token = NULL;
+    size_t new_size = 0;
+
+    if (needed <= stream->token_size)
     {
-        input_buffer->hooks.deallocate(output);
+        return true;
     }
 
-    if (input_pointer != NULL)
+    new_size = (stream->token_size > 0) ? stream->token_size : 64;
+    while (new_size < needed)
     {
-        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+        new_size *= 2;
     }
 
-    return false;
+    if (stream->hooks.reallocate != NULL)
+    {
+        token = (unsigned char*)stream->hooks.reallocate(stream->token, new_size);
+        if (token == NULL)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        token = (unsigned char*)stream->hooks.allocate(new_size);
+        if (token == NULL)
+        {
+            return false;
+        }
+        if (stream->token != NULL)
+        {
+            memcpy(token, stream->token, stream->token_length);
+            stream->hooks.deallocate(stream->token);
+        }
+    }
+
+    stream->token = token;
+    stream->token_size = new_size;
+    return true;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+static cJSON_bool stream_token_append(cJSON_Stream * const stream, const unsigned char *data, size_t length)
 {
-    const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
-
-    if (output_buffer == NULL)
+    if (!stream_token_reserve(stream, stream->token_length + length))
     {
         return false;
     }
+    memcpy(stream->token + stream->token_length, data, length);
+    stream->token_length += length;
+    return true;
+}
 
-    /* empty string */
-    if (input == NULL)
+/* Appends a new item to the innermost container. */
+static cJSON *stream_append_item(cJSON_Stream * const stream)
+{
+    stream_frame *frame = &stream->stack[stream->depth - 1];
+    cJSON *item = (stream->arena != NULL) ? arena_new_item(stream->arena) : cJSON_New_Item(&stream->hooks);
+    if (item == NULL)
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
-        {
-            return false;
-        }
-        strcpy((char*)output, "\"\"");
-
-        return true;
+        return NULL;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    if (frame->last == NULL)
     {
-        switch (*input_pointer)
-        {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
-                break;
-            default:
-                if (*input_pointer < 32)
-                {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
-                }
-                break;
-        }
+        frame->container->child = item;
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
+    else
+    {
+        frame->last->next = item;
+        item->prev = frame->last;
+    }
+    frame->last = item;
 
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
-    if (output == NULL)
+    return item;
+}
+
+/* The item the current value goes into: the root, or the newest member of the innermost container. */
+static cJSON *stream_current_item(cJSON_Stream * const stream)
+{
+    return (stream->depth == 0) ? stream->root : stream->stack[stream->depth - 1].last;
+}
+
+/* The item the next value goes into. Array elements get a new item, object members already have
+ * one (made when the key was read), and the first value is the root. */
+static cJSON *stream_value_target(cJSON_Stream * const stream)
+{
+    if ((stream->depth > 0) && ((stream->stack[stream->depth - 1].container->type & 0xFF) == cJSON_Array))
     {
-        return false;
+        return stream_append_item(stream);
     }
 
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
-    {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
+    return stream_current_item(stream);
+}
 
-        return true;
+static cJSON_bool stream_push(cJSON_Stream * const stream, cJSON * const container)
+{
+    stream_frame *stack = NULL;
+    size_t new_size = 0;
+
+    if (stream->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* to deeply nested */
     }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    if (stream->depth == stream->stack_size)
     {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        new_size = (stream->stack_size > 0) ? (stream->stack_size * 2) : 8;
+        stack = (stream_frame*)stream->hooks.allocate(new_size * sizeof(stream_frame));
+        if (stack == NULL)
         {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
+            return false;
         }
-        else
+        if (stream->stack != NULL)
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
-            }
+            memcpy(stack, stream->stack, stream->depth * sizeof(stream_frame));
+            stream->hooks.deallocate(stream->stack);
         }
+        stream->stack = stack;
+        stream->stack_size = new_size;
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
+
+    stream->stack[stream->depth].container = container;
+    stream->stack[stream->depth].last = NULL;
+    stream->depth++;
 
     return true;
 }
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+/* A value just finished, work out what comes next. */
+static void stream_value_done(cJSON_Stream * const stream)
 {
-    return print_string_ptr((unsigned char*)item->valuestring, p);
+    stream->state = (stream->depth == 0) ? stream_done : stream_after_value;
 }
 
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
-
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+/* Closes the innermost container if c is its closing bracket. */
+static cJSON_bool stream_pop(cJSON_Stream * const stream, unsigned char c)
 {
-    if ((buffer == NULL) || (buffer->content == NULL))
+    stream_frame *frame = &stream->stack[stream->depth - 1];
+    unsigned char expected = ((frame->container->type & 0xFF) == cJSON_Object) ? '}' : ']';
+
+    if (c != expected)
     {
-        return NULL;
+        return false;
     }
 
-    if (cannot_access_at_index(buffer, 0))
+    if (frame->container->child != NULL)
     {
-        return buffer;
+        frame->container->child->prev = frame->last;
     }
+    stream->depth--;
+    stream_value_done(stream);
+
+    return true;
+}
+
+/* Runs a finished string or number token through the normal parser. */
+static cJSON_bool stream_finish_token(cJSON_Stream * const stream, cJSON * const item, cJSON_bool is_string)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, NULL, false };
+
+    buffer.content = stream->token;
+    buffer.length = stream->token_length;
+    buffer.hooks = stream->hooks;
+    buffer.arena = stream->arena;
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    if (is_string)
     {
-       buffer->offset++;
+        if (!parse_string(item, &buffer))
+        {
+            return false;
+        }
     }
-
-    if (buffer->offset == buffer->length)
+    else
     {
-        buffer->offset--;
+        if (!parse_number(item, &buffer))
+        {
+            return false;
+        }
+        /* something like 1-2 is an error inside a container, but a root of 1 with junk after it (like cJSON_Parse) */
+        if ((buffer.offset != buffer.length) && (stream->depth > 0))
+        {
+            return false;
+        }
     }
+    stream->token_length = 0;
 
-    return buffer;
+    return true;
 }
 
-/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
-static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+/* Starts a value with its first byte. */
+static cJSON_bool stream_begin_value(cJSON_Stream * const stream, unsigned char c)
 {
-    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    cJSON *item = NULL;
+
+    if ((c == 0xEF) && (stream->position == 0))
     {
-        return NULL;
+        stream->literal = "\xEF\xBB\xBF";
+        stream->literal_offset = 1;
+        stream->state = stream_in_literal;
+        return true;
     }
 
-    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    item = stream_value_target(stream);
+    if (item == NULL)
     {
-        buffer->offset += 3;
+        return false;
     }
 
-    return buffer;
+    switch (c)
+    {
+        case '{':
+        case '[':
+            item->type = ((c == '{') ? cJSON_Object : cJSON_Array) | (item->type & parse_flags);
+            if (!stream_push(stream, item))
+            {
+                return false;
+            }
+            stream->state = (c == '{') ? stream_key_or_end : stream_value_or_end;
+            return true;
+
+        case '\"':
+            stream->token_is_key = false;
+            stream->escaped = false;
+            stream->state = stream_in_string;
+            return stream_token_append(stream, &c, 1);
+
+        case 'n':
+            stream->literal = "null";
+            break;
+        case 't':
+            stream->literal = "true";
+            break;
+        case 'f':
+            stream->literal = "false";
+            break;
+
+        default:
+            if ((c == '-') || ((c >= '0') && (c <= '9')))
+            {
+                stream->state = stream_in_number;
+                return stream_token_append(stream, &c, 1);
+            }
+            return false;
+    }
+
+    stream->literal_offset = 1;
+    stream->state = stream_in_literal;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Finishes a matched literal. */
+static void stream_end_literal(cJSON_Stream * const stream)
 {
-    size_t buffer_length;
+    cJSON *item = NULL;
 
-    if (NULL == value)
+    if (stream->literal[0] == '\xEF')
     {
-        return NULL;
+        stream->state = stream_value; /* that was the BOM, the root comes next */
+        return;
     }
 
-    /* Adding null character size due to require_null_terminated. */
-    buffer_length = strlen(value) + sizeof("");
-
-    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    /* the item was appended when the literal started */
+    item = stream_current_item(stream);
+    switch (stream->literal[0])
+    {
+        case 'n':
+            item->type = cJSON_NULL | (item->type & parse_flags);
+            break;
+        case 't':
+            item->type = cJSON_True | (item->type & parse_flags);
+            item->valueint = 1;
+            break;
+        default:
+            item->type = cJSON_False | (item->type & parse_flags);
+            break;
+    }
+    stream_value_done(stream);
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Reads the rest of a string out of the chunk. Returns how many bytes it used, or 0 on failure. */
+static size_t stream_read_string(cJSON_Stream * const stream, const unsigned char *data, size_t length)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    size_t i = 0;
     cJSON *item = NULL;
 
-    /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
+    /* find the closing quote */
+    if (stream->escaped)
+    {
+        /* the last chunk ended on a backslash */
+        stream->escaped = false;
+        i = 1;
+    }
+    while (i < length)
+    {
+        i = (size_t)(scan_string(data + i, data + length) - data);
+        if ((i == length) || (data[i] == '\"'))
+        {
+            break;
+        }
+        if (data[i] == '\\')
+        {
+            if ((i + 1) == length)
+            {
+                stream->escaped = true;
+                i = length;
+                break;
+            }
+            i++;
+        }
+        i++;
+    }
 
-    if (value == NULL || 0 == buffer_length)
+    if (i == length)
     {
-        goto fail;
+        /* string continues in the next chunk */
+        return stream_token_append(stream, data, length) ? length : 0;
     }
 
-    buffer.content = (const unsigned char*)value;
-    buffer.length = buffer_length;
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    if (!stream_token_append(stream, data, i + 1))
+    {
+        return 0;
+    }
 
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    item = stream_current_item(stream);
+    if (!stream_finish_token(stream, item, true))
     {
-        goto fail;
+        return 0;
     }
 
-    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    if (stream->token_is_key)
     {
-        /* parse failure. ep is set. */
-        goto fail;
+        /* swap valuestring and string, because we parsed the name */
+        item->string = item->valuestring;
+        item->valuestring = NULL;
+        stream->state = stream_colon;
+    }
+    else
+    {
+        stream_value_done(stream);
     }
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    return i + 1;
+}
+
+static cJSON_bool stream_is_number_char(unsigned char c)
+{
+    return ((c >= '0') && (c <= '9')) || (c == '+') || (c == '-') || (c == 'e') || (c == 'E') || (c == '.');
+}
+
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(void)
+{
+    return cJSON_CreateStreamInArena(NULL);
+}
+
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStreamInArena(cJSON_Arena *arena)
+{
+    cJSON_Stream *stream = (cJSON_Stream*)global_hooks.allocate(sizeof(cJSON_Stream));
+    if (stream == NULL)
     {
-        buffer_skip_whitespace(&buffer);
-        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
-        {
-            goto fail;
-        }
+        return NULL;
     }
-    if (return_parse_end)
+    memset(stream, '\0', sizeof(cJSON_Stream));
+    stream->hooks = global_hooks;
+    stream->arena = arena;
+    stream->state = stream_value;
+
+    stream->root = (arena != NULL) ? arena_new_item(arena) : cJSON_New_Item(&stream->hooks);
+    if (stream->root == NULL)
     {
-        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+        stream->hooks.deallocate(stream);
+        return NULL;
     }
 
-    return item;
+    return stream;
+}
 
-fail:
-    if (item != NULL)
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFeed(cJSON_Stream *stream, const char *data, size_t length)
+{
+    const unsigned char *input = (const unsigned char*)data;
+    size_t offset = 0;
+    size_t used = 0;
+    unsigned char c = 0;
+
+    if ((stream == NULL) || (stream->state == stream_failed) || ((data == NULL) && (length > 0)))
     {
-        cJSON_Delete(item);
+        return false;
     }
 
-    if (value != NULL)
+    while ((offset < length) && (stream->state != stream_done))
     {
-        error local_error;
-        local_error.json = (const unsigned char*)value;
-        local_error.position = 0;
+        c = input[offset];
 
-        if (buffer.offset < buffer.length)
-        {
-            local_error.position = buffer.offset;
-        }
-        else if (buffer.length > 0)
+        switch (stream->state)
         {
-            local_error.position = buffer.length - 1;
+            case stream_in_string:
+                used = stream_read_string(stream, input + offset, length - offset);
+                if (used == 0)
+                {
+                    goto fail;
+                }
+                offset += used;
+                stream->position += used;
+                continue;
+
+            case stream_in_number:
+                if (stream_is_number_char(c))
+                {
+                    if (!stream_token_append(stream, &c, 1))
+                    {
+                        goto fail;
+                    }
+                    break;
+                }
+                /* the number ended, finish it and look at c again */
+                if (!stream_finish_token(stream, stream_current_item(stream), false))
+                {
+                    goto fail;
+                }
+                stream_value_done(stream);
+                continue;
+
+            case stream_in_literal:
+                if (c != (unsigned char)stream->literal[stream->literal_offset])
+                {
+                    goto fail;
+                }
+                stream->literal_offset++;
+                if (stream->literal[stream->literal_offset] == '\0')
+                {
+                    stream_end_literal(stream);
+                }
+                break;
+
+            default:
+                if (c <= 32)
+                {
+                    break; /* whitespace */
+                }
+
+                switch (stream->state)
+                {
+                    case stream_value_or_end:
+                        if (c == ']')
+                        {
+                            if (!stream_pop(stream, c))
+                            {
+                                goto fail;
+                            }
+                            break;
+                        }
+                        /* fall through */
+                    case stream_value:
+                        if (!stream_begin_value(stream, c))
+                        {
+                            goto fail;
+                        }
+                        break;
+
+                    case stream_key_or_end:
+                        if (c == '}')
+                        {
+                            if (!stream_pop(stream, c))
+                            {
+                                goto fail;
+                            }
+                            break;
+                        }
+                        /* fall through */
+                    case stream_key:
+                        if (c != '\"')
+                        {
+                            goto fail;
+                        }
+                        /* members are appended at the key, the value fills them in */
+                        if (stream_append_item(stream) == NULL)
+                        {
+                            goto fail;
+                        }
+
+                        stream->token_is_key = true;
+                        stream->escaped = false;
+                        stream->state = stream_in_string;
+                        if (!stream_token_append(stream, &c, 1))
+                        {
+                            goto fail;
+                        }
+                        break;
+
+                    case stream_colon:
+                        if (c != ':')
+                        {
+                            goto fail;
+                        }
+                        stream->state = stream_value;
+                        break;
+
+                    case stream_after_value:
+                        if (c == ',')
+                        {
+                            stream->state = ((stream->stack[stream->depth - 1].container->type & 0xFF) == cJSON_Object) ? stream_key : stream_value;
+                        }
+                        else if (!stream_pop(stream, c))
+                        {
+                            goto fail;
+                        }
+                        break;
+
+                    default:
+                        goto fail;
+                }
+                break;
         }
 
-        if (return_parse_end != NULL)
+        offset++;
+        stream->position++;
+    }
+
+    return true;
+
+fail:
+    stream->state = stream_failed;
+    return false;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_StreamFinish(cJSON_Stream *stream)
+{
+    cJSON *root = NULL;
+
+    if ((stream == NULL) || (stream->root == NULL))
+    {
+        return NULL;
+    }
+
+    /* a number at the very end has nothing after it to end it */
+    if ((stream->state == stream_in_number) && (stream->depth == 0))
+    {
+        if (!stream_finish_token(stream, stream->root, false))
         {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
+            stream->state = stream_failed;
+            return NULL;
         }
+        stream->state = stream_done;
+    }
 
-        global_error = local_error;
+    if (stream->state != stream_done)
+    {
+        stream->state = stream_failed; /* ended in the middle of something */
+        return NULL;
     }
 
-    return NULL;
+    /* the caller owns the tree now */
+    root = stream->root;
+    stream->root = NULL;
+    return root;
 }
 
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+CJSON_PUBLIC(size_t) cJSON_StreamErrorOffset(const cJSON_Stream *stream)
 {
-    return cJSON_ParseWithOpts(value, 0, 0);
+    return (stream != NULL) ? stream->position : 0;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream)
 {
-    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+    if (stream == NULL)
+    {
+        return;
+    }
+
+    cJSON_Delete(stream->root);
+    if (stream->stack != NULL)
+    {
+        stream->hooks.deallocate(stream->stack);
+    }
+    if (stream->token != NULL)
+    {
+        stream->hooks.deallocate(stream->token);
+    }
+    stream->hooks.deallocate(stream);
 }
 
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
@@ -1308,6 +2751,347 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     return print_value(item, &p);
 }
 
+/* Streaming writer */
+#define writer_nesting_limit (sizeof(unsigned long) * CHAR_BIT - 1)
+#define writer_bit(depth) (1UL << (depth))
+
+CJSON_PUBLIC(void) cJSON_InitWriter(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *context)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+    memset(writer, '\0', sizeof(cJSON_Writer));
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->flush = flush;
+    writer->context = context;
+    writer->failed = (buffer == NULL) || (size == 0);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_FlushToFile(void *file, const char *data, size_t length)
+{
+    return fwrite(data, 1, length, (FILE*)file) == length;
+}
+
+static cJSON_bool writer_flush(cJSON_Writer * const writer)
+{
+    if ((writer->flush == NULL) || !writer->flush(writer->context, writer->buffer, writer->used))
+    {
+        writer->failed = true;
+        return false;
+    }
+    writer->flushed += writer->used;
+    writer->used = 0;
+
+    return true;
+}
+
+static void writer_put(cJSON_Writer * const writer, const unsigned char *data, size_t length)
+{
+    size_t room = 0;
+
+    while ((length > 0) && !writer->failed)
+    {
+        if ((writer->used == writer->size) && !writer_flush(writer))
+        {
+            return;
+        }
+        room = writer->size - writer->used;
+        if (room > length)
+        {
+            room = length;
+        }
+        memcpy(writer->buffer + writer->used, data, room);
+        writer->used += room;
+        data += room;
+        length -= room;
+    }
+}
+
+static void writer_put_string(cJSON_Writer * const writer, const unsigned char *string)
+{
+    const unsigned char *end = NULL;
+    const unsigned char *run_end = NULL;
+    unsigned char escape[7] = { '\\', 0, 0, 0, 0, 0, 0 };
+    size_t escape_length = 0;
+
+    writer_put(writer, (const unsigned char*)"\"", 1);
+    if (string != NULL)
+    {
+        end = string + strlen((const char*)string);
+        while (string < end)
+        {
+            /* everything up to the next character that needs escaping goes out as is */
+            run_end = scan_string(string, end);
+            writer_put(writer, string, (size_t)(run_end - string));
+            if (run_end == end)
+            {
+                break;
+            }
+
+            escape_length = 2;
+            switch (*run_end)
+            {
+                case '\"':
+                case '\\':
+                    escape[1] = *run_end;
+                    break;
+                case '\b':
+                    escape[1] = 'b';
+                    break;
+                case '\f':
+                    escape[1] = 'f';
+                    break;
+                case '\n':
+                    escape[1] = 'n';
+                    break;
+                case '\r':
+                    escape[1] = 'r';
+                    break;
+                case '\t':
+                    escape[1] = 't';
+                    break;
+                default:
+                    sprintf((char*)escape + 1, "u%04x", *run_end);
+                    escape_length = 6;
+                    break;
+            }
+            writer_put(writer, escape, escape_length);
+            string = run_end + 1;
+        }
+    }
+    writer_put(writer, (const unsigned char*)"\"", 1);
+}
+
+/* check a value can go here and write the comma before it if it needs one */
+static cJSON_bool writer_begin_value(cJSON_Writer * const writer)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+
+    if (writer->objects & writer_bit(writer->depth))
+    {
+        /* the comma came with the key */
+        if (!writer->after_key)
+        {
+            writer->failed = true;
+            return false;
+        }
+        writer->after_key = false;
+        return true;
+    }
+
+    if (writer->filled & writer_bit(writer->depth))
+    {
+        if (writer->depth == 0)
+        {
+            /* only one root */
+            writer->failed = true;
+            return false;
+        }
+        writer_put(writer, (const unsigned char*)",", 1);
+    }
+    writer->filled |= writer_bit(writer->depth);
+
+    return !writer->failed;
+}
+
+static cJSON_bool writer_start(cJSON_Writer * const writer, const cJSON_bool object)
+{
+    if (!writer_begin_value(writer))
+    {
+        return false;
+    }
+    if (writer->depth >= writer_nesting_limit)
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->depth++;
+    writer->filled &= ~writer_bit(writer->depth);
+    if (object)
+    {
+        writer->objects |= writer_bit(writer->depth);
+    }
+    else
+    {
+        writer->objects &= ~writer_bit(writer->depth);
+    }
+    writer_put(writer, (const unsigned char*)(object ? "{" : "["), 1);
+
+    return !writer->failed;
+}
+
+static cJSON_bool writer_end(cJSON_Writer * const writer, const cJSON_bool object)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+    if ((writer->depth == 0) || writer->after_key || (((writer->objects & writer_bit(writer->depth)) != 0) != object))
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->depth--;
+    writer_put(writer, (const unsigned char*)(object ? "}" : "]"), 1);
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteStartObject(cJSON_Writer *writer)
+{
+    return writer_start(writer, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteEndObject(cJSON_Writer *writer)
+{
+    return writer_end(writer, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteStartArray(cJSON_Writer *writer)
+{
+    return writer_start(writer, false);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteEndArray(cJSON_Writer *writer)
+{
+    return writer_end(writer, false);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteKey(cJSON_Writer *writer, const char *key)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+    if ((key == NULL) || writer->after_key || !(writer->objects & writer_bit(writer->depth)))
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    if (writer->filled & writer_bit(writer->depth))
+    {
+        writer_put(writer, (const unsigned char*)",", 1);
+    }
+    writer->filled |= writer_bit(writer->depth);
+    writer_put_string(writer, (const unsigned char*)key);
+    writer_put(writer, (const unsigned char*)":", 1);
+    writer->after_key = true;
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteString(cJSON_Writer *writer, const char *string)
+{
+    if (!writer_begin_value(writer))
+    {
+        return false;
+    }
+    writer_put_string(writer, (const unsigned char*)string);
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNumber(cJSON_Writer *writer, double number)
+{
+    unsigned char number_buffer[26] = {0};
+    int valueint = 0;
+    int length = 0;
+
+    if (!writer_begin_value(writer))
+    {
+        return false;
+    }
+
+    /* valueint the way cJSON_SetNumberHelper would set it, so it prints like an item */
+    if (number >= INT_MAX)
+    {
+        valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        valueint = INT_MIN;
+    }
+    else if (!isnan(number))
+    {
+        valueint = (int)number;
+    }
+
+    length = format_number(number, valueint, number_buffer);
+    if (length < 0)
+    {
+        writer->failed = true;
+        return false;
+    }
+    writer_put(writer, number_buffer, (size_t)length);
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteBool(cJSON_Writer *writer, cJSON_bool boolean)
+{
+    if (!writer_begin_value(writer))
+    {
+        return false;
+    }
+    if (boolean)
+    {
+        writer_put(writer, (const unsigned char*)"true", 4);
+    }
+    else
+    {
+        writer_put(writer, (const unsigned char*)"false", 5);
+    }
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNull(cJSON_Writer *writer)
+{
+    if (!writer_begin_value(writer))
+    {
+        return false;
+    }
+    writer_put(writer, (const unsigned char*)"null", 4);
+
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterFinish(cJSON_Writer *writer)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+    if ((writer->depth != 0) || !(writer->filled & writer_bit(0)))
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    if (writer->flush != NULL)
+    {
+        return (writer->used == 0) || writer_flush(writer);
+    }
+
+    /* fixed buffer, terminate it like a printed string */
+    if (writer->used == writer->size)
+    {
+        writer->failed = true;
+        return false;
+    }
+    writer->buffer[writer->used] = '\0';
+
+    return true;
+}
+
 /* Parser core - when encountering text, process appropriately. */
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -1320,21 +3104,21 @@ static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buf
     /* null */
     if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
     {
-        item->type = cJSON_NULL;
+        item->type = cJSON_NULL | (item->type & parse_flags);
         input_buffer->offset += 4;
         return true;
     }
     /* false */
     if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
     {
-        item->type = cJSON_False;
+        item->type = cJSON_False | (item->type & parse_flags);
         input_buffer->offset += 5;
         return true;
     }
     /* true */
     if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
     {
-        item->type = cJSON_True;
+        item->type = cJSON_True | (item->type & parse_flags);
         item->valueint = 1;
         input_buffer->offset += 4;
         return true;
@@ -1476,7 +3260,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1519,7 +3303,7 @@ success:
         head->prev = current_item;
     }
 
-    item->type = cJSON_Array;
+    item->type = cJSON_Array | (item->type & parse_flags);
     item->child = head;
 
     input_buffer->offset++;
@@ -1634,7 +3418,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1695,7 +3479,7 @@ success:
         head->prev = current_item;
     }
 
-    item->type = cJSON_Object;
+    item->type = cJSON_Object | (item->type & parse_flags);
     item->child = head;
 
     input_buffer->offset++;
@@ -1880,18 +3664,25 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    size_t walked = 0;
 
     if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
+    if (object->index != NULL)
+    {
+        return index_lookup(object->index, name, case_sensitive);
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
         while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
         {
             current_element = current_element->next;
+            walked++;
         }
     }
     else
@@ -1899,9 +3690,16 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
         {
             current_element = current_element->next;
+            walked++;
         }
     }
 
+    /* that was a long walk, index it for next time (references share someone else's list, so not those) */
+    if ((walked >= CJSON_INDEX_THRESHOLD) && ((object->type & 0xFF) == cJSON_Object) && !(object->type & cJSON_IsReference))
+    {
+        index_build((cJSON*)object);
+    }
+
     if ((current_element == NULL) || (current_element->string == NULL)) {
         return NULL;
     }
@@ -1909,6 +3707,14 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
     return current_element;
 }
 
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *object)
+{
+    if (object != NULL)
+    {
+        index_drop(object);
+    }
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string)
 {
     return get_object_item(object, string, false);
@@ -1948,8 +3754,9 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
-    reference->type |= cJSON_IsReference;
+    reference->type = (reference->type | cJSON_IsReference) & ~(cJSON_InArena | cJSON_InSitu); /* the reference itself is on the heap */
     reference->next = reference->prev = NULL;
+    reference->index = NULL;
     return reference;
 }
 
@@ -1982,6 +3789,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
             array->child->prev = item;
         }
     }
+    index_append(array, item);
 
     return true;
 }
@@ -2025,7 +3833,18 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
     }
     else
     {
-        new_key = (char*)cJSON_strdup((const unsigned char*)string, hooks);
+        if (!insitu_adopt(item, hooks))
+        {
+            return false;
+        }
+        if (item->type & cJSON_InArena)
+        {
+            new_key = (char*)arena_strdup(arena_of(item), (const unsigned char*)string);
+        }
+        else
+        {
+            new_key = (char*)cJSON_strdup((const unsigned char*)string, hooks);
+        }
         if (new_key == NULL)
         {
             return false;
@@ -2034,7 +3853,7 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
         new_type = item->type & ~cJSON_StringIsConst;
     }
 
-    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+    if (!(item->type & (cJSON_StringIsConst | cJSON_InArena | cJSON_InSitu)) && (item->string != NULL))
     {
         hooks->deallocate(item->string);
     }
@@ -2191,6 +4010,7 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         return NULL;
     }
 
+    index_drop(parent);
     if (item != parent->child)
     {
         /* not the first element */
@@ -2275,6 +4095,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
         return add_item_to_array(array, newitem);
     }
 
+    index_drop(array);
     newitem->next = after_inserted;
     newitem->prev = after_inserted->prev;
     after_inserted->prev = newitem;
@@ -2301,6 +4122,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         return true;
     }
 
+    index_replace(parent, item, replacement);
     replacement->next = item->next;
     replacement->prev = item->prev;
 
@@ -2355,12 +4177,24 @@ static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSO
         return false;
     }
 
+    if (!insitu_adopt(replacement, &global_hooks))
+    {
+        return false;
+    }
+
     /* replace the name in the replacement */
-    if (!(replacement->type & cJSON_StringIsConst) && (replacement->string != NULL))
+    if (!(replacement->type & (cJSON_StringIsConst | cJSON_InArena)) && (replacement->string != NULL))
     {
         cJSON_free(replacement->string);
     }
-    replacement->string = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+    if (replacement->type & cJSON_InArena)
+    {
+        replacement->string = (char*)arena_strdup(arena_of(replacement), (const unsigned char*)string);
+    }
+    else
+    {
+        replacement->string = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+    }
     if (replacement->string == NULL)
     {
         return false;
@@ -2722,7 +4556,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_InArena | cJSON_InSitu));
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
     if (item->valuestring)
@@ -0,0 +1,192 @@
+/**
+ * @file assets.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Refcounted cache for the built in textures and fonts, so screens stop
+ * decoding the same JPGs/PNGs/TTFs every time they open.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Wii Specific.
+#include <gctypes.h>
+#include <gccore.h>
+
+// Our #1 graphics library.
+#include <grrlib.h>
+
+// core.
+#include "rend/text.h"
+#include "rend/assets.h"
+#include "rend/coreEngine.h"
+
+typedef struct {
+    const u8* key;              // The embedded data the asset was made from.
+    GRRLIB_texImg* texture;     // Set if it's a texture.
+    GRRLIB_ttfFont* font;       // Set if it's a font.
+    int refs;
+} asset_t;
+
+asset_t __assets_cache[ASSETS_MAX];
+int __assets_count = 0;
+mutex_t __assets_lock = LWP_MUTEX_NULL;
+
+// Lazily makes the lock, the cache gets used before anything else is set up.
+static void __assets_lockCache() {
+    if(__assets_lock == LWP_MUTEX_NULL) {
+        LWP_MutexInit(&__assets_lock, false);
+    }
+    LWP_MutexLock(__assets_lock);
+}
+
+// Finds the entry for some embedded data. Lock must be held.
+static asset_t* __assets_find(const u8* key) {
+    for(int i = 0; i < __assets_count; i++) {
+        if(__assets_cache[i].key == key) {
+            return &__assets_cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Adds an entry. Lock must be held.
+static asset_t* __assets_add(const u8* key) {
+    if(__assets_count >= ASSETS_MAX) {
+        LWP_MutexUnlock(__assets_lock);
+        showErrorScreen("Asset cache is full, bump ASSETS_MAX.");
+        return NULL;
+    }
+    asset_t* asset = &__assets_cache[__assets_count++];
+    asset->key = key;
+    asset->texture = NULL;
+    asset->font = NULL;
+    asset->refs = 0;
+    return asset;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph agt_p0 Gets a texture from built in data, decoding it only the first time.
+ * 
+ * @param data The embedded image (ex: cursor_png).
+ * 
+ * @returns A shared texture. Don't free it, call Assets_Release when you're done.
+*/
+GRRLIB_texImg* Assets_GetTexture(const u8* data) {
+    __assets_lockCache();
+    asset_t* asset = __assets_find(data);
+    if(asset == NULL) {
+        asset = __assets_add(data);
+        asset->texture = GRRLIB_LoadTexture(data);
+    }
+    asset->refs++;
+    GRRLIB_texImg* texture = asset->texture;
+    LWP_MutexUnlock(__assets_lock);
+    return texture;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph agf_p0 Gets a font from built in data, loading it only the first time.
+ * 
+ * @param data The embedded TTF (ex: font_ttf).
+ * @param size Size of the TTF data.
+ * 
+ * @returns A shared font. Don't free it, call Assets_Release when you're done.
+*/
+GRRLIB_ttfFont* Assets_GetFont(const u8* data, s32 size) {
+    __assets_lockCache();
+    asset_t* asset = __assets_find(data);
+    if(asset == NULL) {
+        asset = __assets_add(data);
+        asset->font = GRRLIB_LoadTTF(data, size);
+    }
+    asset->refs++;
+    GRRLIB_ttfFont* font = asset->font;
+    LWP_MutexUnlock(__assets_lock);
+    return font;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph ar_p0 Drops a reference to a texture or font from the cache. It stays
+ * cached (so the next screen gets it for free) until Assets_Trim is called.
+ * Handles that didn't come from the cache are ignored.
+ * 
+ * @param handle The texture or font.
+*/
+void Assets_Release(const void* handle) {
+    if(handle == NULL) {
+        return;
+    }
+
+    __assets_lockCache();
+    for(int i = 0; i < __assets_count; i++) {
+        asset_t* asset = &__assets_cache[i];
+        if((asset->texture == handle || asset->font == handle) && asset->refs > 0) {
+            asset->refs--;
+            break;
+        }
+    }
+    LWP_MutexUnlock(__assets_lock);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph atr_p0 Frees every cached asset nobody holds a reference to.
+*/
+void Assets_Trim() {
+    __assets_lockCache();
+    int kept = 0;
+    for(int i = 0; i < __assets_count; i++) {
+        asset_t* asset = &__assets_cache[i];
+        if(asset->refs > 0) {
+            __assets_cache[kept++] = *asset;
+            continue;
+        }
+        if(asset->texture != NULL) GRRLIB_FreeTexture(asset->texture);
+        if(asset->font != NULL) {
+            Text_ForgetFont(asset->font); // Its glyph atlases go with it.
+            GRRLIB_FreeTTF(asset->font);
+        }
+    }
+    __assets_count = kept;
+    LWP_MutexUnlock(__assets_lock);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph ags_p0 Returns what's in the cache and how much memory it's using.
+*/
+assetstats_t Assets_GetStats() {
+    assetstats_t stats = { 0, 0, 0, 0 };
+
+    __assets_lockCache();
+    for(int i = 0; i < __assets_count; i++) {
+        asset_t* asset = &__assets_cache[i];
+        if(asset->texture != NULL) {
+            stats.textures++;
+            stats.textureBytes += (size_t)asset->texture->w * asset->texture->h * 4; // RGBA8
+        }
+        if(asset->font != NULL) {
+            stats.fonts++;
+        }
+        if(asset->refs > 0) {
+            stats.inUse++;
+        }
+    }
+    LWP_MutexUnlock(__assets_lock);
+    return stats;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph amu_p0 Returns the texture memory used by the cache, in bytes.
+*/
+size_t Assets_MemoryUsage() {
+    return Assets_GetStats().textureBytes;
+}
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 
 // Wii Specific.
@@ -23,7 +24,11 @@
 
 // core.
 #include "std_btn_png.h"
+#include "misc/carhorn_defs.h"
+#include "rend/assets.h"
 #include "rend/buttons.h"
+#include "rend/text.h"
+#include "rend/profiler.h"
 
 // Log.
 #ifdef DEBUG
@@ -66,6 +71,14 @@ spritedbtn_t CreateButton(int x, int y, char* str, spritedbtn_options_t options,
     newButton.settings = options;
     newButton.str = str;
 
+    // Label gets rendered on first draw.
+    newButton.label.texture = NULL;
+    newButton.label.width = 0;
+    newButton.label.str = NULL;
+    newButton.label.font = NULL;
+    newButton.label.fontSize = 0;
+    newButton.label.color = 0;
+
     // Return.
     return newButton;
 }
@@ -90,7 +103,7 @@ spritedbtn_assets_t GetStdBtnAssets(u32 bgColor, u32 txtColor, GRRLIB_ttfFont* f
     stdAssets.btnTexture = NULL;
     stdAssets.font = NULL;
 
-    stdAssets.btnTexture = GRRLIB_LoadTexture(std_btn_png);
+    stdAssets.btnTexture = Assets_GetTexture(std_btn_png);
     stdAssets.color = bgColor;
     stdAssets.textColor = txtColor;
     stdAssets.hoverColor = 0xAAAAAAFF;
@@ -141,45 +154,87 @@ Size GetButtonSize(spritedbtn_t btn) {
 
 /**
  * @author Dakota Thorpe.
- * @paragraph rsb_p0 Renders the button onto the screen.
+ * @paragraph db_p0 Frees the button's cached label and gives its texture back to the asset cache.
  * 
- * @param btn The button to render.
+ * @param btn The button you're done with.
 */
-void renderSpritedButton(spritedbtn_t btn) {
-    int textLengthInPixels;
-    int textHeightInPixels;
+void DestroyButton(spritedbtn_t* btn) {
+    if(btn->label.texture != NULL) {
+        GRRLIB_FreeTexture(btn->label.texture);
+        btn->label.texture = NULL;
+    }
+    free(btn->label.str);
+    btn->label.str = NULL;
+
+    Assets_Release(btn->assets.btnTexture);
+    btn->assets.btnTexture = NULL;
+}
+
+// Re-renders the label if the text, font, size or color changed since last time.
+static void __buttons_updateLabel(spritedbtn_t* btn) {
+    spritedbtn_label_t* label = &btn->label;
+    const char* str = btn->str ? btn->str : "";
+
+    if(label->str != NULL && strcmp(label->str, str) == 0 && label->font == btn->assets.font &&
+       label->fontSize == btn->settings.fontSize && label->color == btn->assets.textColor) {
+        return;
+    }
+
+    if(label->texture != NULL) {
+        GRRLIB_FreeTexture(label->texture);
+    }
+    free(label->str);
 
-    int generalBtnWidth = btn.assets.btnTexture->w;
-    int generalBtnHeight = btn.assets.btnTexture->h;
+    label->str = strdup(str);
+    label->font = btn->assets.font;
+    label->fontSize = btn->settings.fontSize;
+    label->color = btn->assets.textColor;
+    label->texture = Text_RenderToTexture(btn->assets.font, str, btn->settings.fontSize, btn->assets.textColor, &label->width);
+}
 
-    textLengthInPixels = GRRLIB_WidthTTF(btn.assets.font, btn.str, btn.settings.fontSize);
-    textHeightInPixels = btn.settings.fontSize;
+/**
+ * @author Dakota Thorpe.
+ * @paragraph rsb_p0 Renders the button onto the screen. The label is drawn from a cached
+ * texture, so a button whose text doesn't change never touches FreeType after the first frame.
+ * 
+ * @param btn The button to render.
+*/
+void renderSpritedButton(spritedbtn_t* btn) {
+    int generalBtnWidth = btn->assets.btnTexture->w;
+    int generalBtnHeight = btn->assets.btnTexture->h;
 
     // Draw sprite shit.
-    GRRLIB_DrawImg(btn.pnt.x,btn.pnt.y, btn.assets.btnTexture, 0, 1,1, btn.assets.color);
+    GRRLIB_DrawImg(btn->pnt.x,btn->pnt.y, btn->assets.btnTexture, 0, 1,1, btn->assets.color);
 
     // Draw other shit.
-    if(btn.settings.morethan1Texture) {
-        if(btn.settings.isHovering) {
-            GRRLIB_DrawImg(btn.pnt.x,btn.pnt.y, btn.assets.btnHoverTexture, 0, 1,1, btn.assets.color);    
+    if(btn->settings.morethan1Texture) {
+        if(btn->settings.isHovering) {
+            GRRLIB_DrawImg(btn->pnt.x,btn->pnt.y, btn->assets.btnHoverTexture, 0, 1,1, btn->assets.color);    
         }
-        if(btn.settings.isPressed) {
-            GRRLIB_DrawImg(btn.pnt.x,btn.pnt.y, btn.assets.btnDownTexture, 0, 1,1, btn.assets.color);    
+        if(btn->settings.isPressed) {
+            GRRLIB_DrawImg(btn->pnt.x,btn->pnt.y, btn->assets.btnDownTexture, 0, 1,1, btn->assets.color);    
         }
     } else { // No seperate textures.
-        if(btn.settings.isHovering) {
-            GRRLIB_DrawImg(btn.pnt.x,btn.pnt.y, btn.assets.btnTexture, 0, 1,1, btn.assets.hoverColor);    
+        if(btn->settings.isHovering) {
+            GRRLIB_DrawImg(btn->pnt.x,btn->pnt.y, btn->assets.btnTexture, 0, 1,1, btn->assets.hoverColor);    
         }
-        if(btn.settings.isPressed) {
-            GRRLIB_DrawImg(btn.pnt.x,btn.pnt.y, btn.assets.btnTexture, 0, 1,1, btn.assets.onclickColor);    
+        if(btn->settings.isPressed) {
+            GRRLIB_DrawImg(btn->pnt.x,btn->pnt.y, btn->assets.btnTexture, 0, 1,1, btn->assets.onclickColor);    
         }
     }
 
     // Place text in btn.
-    int txtX = btn.pnt.x + (generalBtnWidth / 2) - (textLengthInPixels / 2);
-    int txtY = btn.pnt.y + (generalBtnHeight / 2) - (textHeightInPixels / 2);
+    __buttons_updateLabel(btn);
+    if(btn->label.texture == NULL) {
+        return;
+    }
+
+    int textLengthInPixels = btn->label.width;
+    int textHeightInPixels = btn->settings.fontSize;
+    int txtX = btn->pnt.x + (generalBtnWidth / 2) - (textLengthInPixels / 2);
+    int txtY = btn->pnt.y + (generalBtnHeight / 2) - (textHeightInPixels / 2);
 
-    GRRLIB_PrintfTTF(txtX, txtY, btn.assets.font, btn.str, btn.settings.fontSize, btn.assets.textColor);
+    GRRLIB_DrawImg(txtX, txtY, btn->label.texture, 0, 1,1, COL_WHITE);
 }
 
 /**
@@ -193,6 +248,7 @@ void renderSpritedButton(spritedbtn_t btn) {
  * @param pressed The pressed state of the Wii Remote.
 */
 void checkButtonStatus(spritedbtn_t* btn, int mx, int my, Size cSize, s32 pressed) {
+    PROFILE_SCOPE("checkButtonStatus");
     // Calculate the boundaries of the cursor rectangle
     int cursorLeft = mx;
     int cursorRight = mx + cSize.w;
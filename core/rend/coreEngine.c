@@ -20,9 +20,13 @@
 
 // Our #1 graphics library.
 #include <grrlib.h>
+#include <pngu.h>
 
 // includes
+#include "rend/text.h"
 #include "rend/coreEngine.h"
+#include "rend/framearena.h"
+#include "rend/profiler.h"
 #include "misc/carhorn_defs.h"
 
 // Error bg.
@@ -62,6 +66,38 @@ void CoreEngine_Init() {
     #endif
 }
 
+/**
+ * @author Dakota Thorpe
+ * @paragraph cer_p0 Renders the frame, then frees everything that was allocated from the
+ * frame arena during it. Use this instead of GRRLIB_Render.
+*/
+void CoreEngine_Render() {
+    if(Profiler_OverlayVisible()) {
+        Profiler_DrawOverlay();
+    }
+
+    PROFILE_CALL("GRRLIB_Render", GRRLIB_Render());
+    Profiler_FrameMark();
+    FrameArena_Reset();
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph cesp_p0 Scans the Wiimotes. Use this instead of WPAD_ScanPads, it also
+ * handles the debug keys: 1 toggles the profiler overlay, 2 dumps a trace to the SD.
+*/
+void CoreEngine_ScanPads() {
+    PROFILE_CALL("WPAD_ScanPads", WPAD_ScanPads());
+
+    u32 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
+    if(pressed & WPAD_BUTTON_1) {
+        Profiler_SetOverlay(!Profiler_OverlayVisible());
+    }
+    if(pressed & WPAD_BUTTON_2) {
+        Profiler_DumpTrace(PROFILER_TRACE_PATH);
+    }
+}
+
 /**
  * @author Dakota Thorpe
  * @paragraph ses_p0 Shows the error screen.
@@ -74,13 +110,13 @@ void showErrorScreen(char* errorText) {
     GRRLIB_ttfFont* globalFont = GRRLIB_LoadTTF(font_ttf, font_ttf_size);
 
     while(true) {
-        WPAD_ScanPads();
+        CoreEngine_ScanPads();
         s32 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
 
         // Render.
         GRRLIB_DrawImg(0,0, error_background, 0, 1,1, COL_WHITE);
-        GRRLIB_PrintfTTF(0,0, globalFont, errorText, 28, COL_WHITE);
-        GRRLIB_Render();
+        Text_Draw(0,0, globalFont, errorText, 28, COL_WHITE);
+        CoreEngine_Render();
 
         // Check for home
         if(pressed & WPAD_BUTTON_HOME) {
@@ -89,4 +125,46 @@ void showErrorScreen(char* errorText) {
     }
 
     exit(0);
-}
\ No newline at end of file
+}
+/**
+ * @author Dakota Thorpe
+ * @paragraph celp_p0 Decodes a PNG that's already in memory into a texture.
+ * Works around GRRLIB_LoadTexture not liking some of the frames.
+ * 
+ * @param pngData The PNG file data.
+ * 
+ * @returns The texture, or NULL if it couldn't be decoded.
+*/
+GRRLIB_texImg* CoreEngine_LoadPNG(const void* pngData) {
+    PROFILE_SCOPE("PNG decode");
+    PNGUPROP imgProp;
+    IMGCTX ctx = PNGU_SelectImageFromBuffer(pngData);
+    if(ctx == NULL) {
+        return NULL;
+    }
+    if(PNGU_GetImageProperties(ctx, &imgProp) != PNGU_OK) {
+        PNGU_ReleaseImageContext(ctx);
+        return NULL;
+    }
+
+    GRRLIB_texImg *texture = calloc(1, sizeof(GRRLIB_texImg));
+    if (texture == NULL) {
+        PNGU_ReleaseImageContext(ctx);
+        return NULL;
+    }
+
+    int pngW = imgProp.imgWidth;
+    int pngH = imgProp.imgHeight;
+    texture->data = PNGU_DecodeTo4x4RGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &pngW, &pngH);
+    PNGU_ReleaseImageContext(ctx);
+    if (texture->data == NULL) {
+        free(texture);
+        return NULL;
+    }
+
+    texture->w = pngW;
+    texture->h = pngH;
+    GRRLIB_SetHandle( texture, 0, 0 );
+    GRRLIB_FlushTex( texture );
+    return texture;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file framearena.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Scratch memory that only lives until the end of the frame. The render loops used to
+ * malloc/free their strings every frame which chews up MEM1, now they bump a pointer
+ * and CoreEngine_Render throws the lot away.
+ * Only whoever is rendering should use it (there's no locking).
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+// core.
+#include "rend/framearena.h"
+
+#define FRAMEARENA_ALIGN 8
+
+// Allocations that didn't fit, freed on reset.
+typedef struct arenaoverflow_s {
+    struct arenaoverflow_s* next;
+} arenaoverflow_t;
+
+static uint8_t __framearena_buffer[FRAMEARENA_SIZE] __attribute__((aligned(FRAMEARENA_ALIGN)));
+static arenaoverflow_t* __framearena_overflow = NULL;
+static framearenastats_t __framearena_stats;
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph faa_p0 Gets memory that's good until the next CoreEngine_Render. Don't free it.
+ * If the arena is full it falls back to malloc (and counts it) so callers never get NULL
+ * unless the heap is gone too.
+ * 
+ * @param size Bytes wanted.
+ * 
+ * @returns The memory.
+*/
+void* FrameArena_Alloc(size_t size) {
+    size_t aligned = (size + FRAMEARENA_ALIGN - 1) & ~(size_t)(FRAMEARENA_ALIGN - 1);
+    __framearena_stats.allocs++;
+
+    if(aligned <= FRAMEARENA_SIZE - __framearena_stats.used) {
+        void* memory = &__framearena_buffer[__framearena_stats.used];
+        __framearena_stats.used += aligned;
+        if(__framearena_stats.used > __framearena_stats.peak) {
+            __framearena_stats.peak = __framearena_stats.used;
+        }
+        return memory;
+    }
+
+    // Out of arena, use the heap for this one.
+    arenaoverflow_t* overflow = malloc(sizeof(arenaoverflow_t) + FRAMEARENA_ALIGN + size);
+    if(overflow == NULL) {
+        return NULL;
+    }
+    overflow->next = __framearena_overflow;
+    __framearena_overflow = overflow;
+    __framearena_stats.heapFallbacks++;
+    __framearena_stats.totalHeapFallbacks++;
+    return (uint8_t*)overflow + ((sizeof(arenaoverflow_t) + FRAMEARENA_ALIGN - 1) & ~(size_t)(FRAMEARENA_ALIGN - 1));
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph fap_p0 sprintf into the frame arena.
+ * 
+ * @returns The string, good until the next CoreEngine_Render.
+*/
+char* FrameArena_Printf(const char* format, ...) {
+    va_list args;
+
+    // Try writing straight into what's left of the arena, most strings fit.
+    size_t left = FRAMEARENA_SIZE - __framearena_stats.used;
+    char* dest = (char*)&__framearena_buffer[__framearena_stats.used];
+    va_start(args, format);
+    int length = vsnprintf(dest, left, format, args);
+    va_end(args);
+    if(length < 0) {
+        return NULL;
+    }
+    if((size_t)length < left) {
+        return FrameArena_Alloc(length + 1); // Same spot, just claims it.
+    }
+
+    // Didn't fit, allocate the real size and print again.
+    dest = FrameArena_Alloc(length + 1);
+    if(dest == NULL) {
+        return NULL;
+    }
+    va_start(args, format);
+    vsnprintf(dest, length + 1, format, args);
+    va_end(args);
+    return dest;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph far_p0 Throws away everything allocated this frame. CoreEngine_Render calls this.
+*/
+void FrameArena_Reset() {
+    while(__framearena_overflow != NULL) {
+        arenaoverflow_t* next = __framearena_overflow->next;
+        free(__framearena_overflow);
+        __framearena_overflow = next;
+    }
+    __framearena_stats.lastFrame.used = __framearena_stats.used;
+    __framearena_stats.lastFrame.allocs = __framearena_stats.allocs;
+    __framearena_stats.lastFrame.heapFallbacks = __framearena_stats.heapFallbacks;
+    __framearena_stats.used = 0;
+    __framearena_stats.allocs = 0;
+    __framearena_stats.heapFallbacks = 0;
+    __framearena_stats.frames++;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph fags_p0 Returns the arena counters. used/allocs/heapFallbacks are for the frame
+ * so far, lastFrame has them for the whole of the frame before.
+*/
+framearenastats_t FrameArena_GetStats() {
+    return __framearena_stats;
+}
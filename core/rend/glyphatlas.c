@@ -0,0 +1,393 @@
+/**
+ * @file glyphatlas.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Packs glyphs into one texture (per font and size) the first time they're used,
+ * and lays strings out as quads into it. Plain C, so it builds and runs on a PC.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rend/glyphatlas.h"
+
+#define GLYPHATLAS_INITIAL_GLYPHS 128   // Hash table size to start with (power of 2).
+#define GLYPHATLAS_REPLACEMENT 0xFFFD   // Codepoint for broken UTF-8.
+
+// Hash for a codepoint.
+static uint32_t __glyphatlas_hash(uint32_t codepoint) {
+    codepoint ^= codepoint >> 16;
+    codepoint *= 0x7feb352d;
+    codepoint ^= codepoint >> 15;
+    return codepoint;
+}
+
+// Finds the slot for a codepoint (its entry or the empty slot it'd go in).
+static atlasglyph_t* __glyphatlas_slot(atlasglyph_t* glyphs, int capacity, uint32_t codepoint) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t i = __glyphatlas_hash(codepoint) & mask;
+    while(glyphs[i].state != GLYPH_EMPTY && glyphs[i].codepoint != codepoint) {
+        i = (i + 1) & mask;
+    }
+    return &glyphs[i];
+}
+
+// Doubles the glyph table.
+static bool __glyphatlas_grow(glyphatlas_t* atlas) {
+    int capacity = atlas->glyphCapacity * 2;
+    atlasglyph_t* glyphs = calloc(capacity, sizeof(atlasglyph_t));
+    if(glyphs == NULL) {
+        return false;
+    }
+
+    for(int i = 0; i < atlas->glyphCapacity; i++) {
+        if(atlas->glyphs[i].state != GLYPH_EMPTY) {
+            *__glyphatlas_slot(glyphs, capacity, atlas->glyphs[i].codepoint) = atlas->glyphs[i];
+        }
+    }
+
+    free(atlas->glyphs);
+    atlas->glyphs = glyphs;
+    atlas->glyphCapacity = capacity;
+    return true;
+}
+
+// Marks part of the atlas as changed.
+static void __glyphatlas_markDirty(glyphatlas_t* atlas, int x, int y, int w, int h) {
+    if(atlas->dirtyX1 <= atlas->dirtyX0) {
+        atlas->dirtyX0 = x;
+        atlas->dirtyY0 = y;
+        atlas->dirtyX1 = x + w;
+        atlas->dirtyY1 = y + h;
+        return;
+    }
+    if(x < atlas->dirtyX0) atlas->dirtyX0 = x;
+    if(y < atlas->dirtyY0) atlas->dirtyY0 = y;
+    if(x + w > atlas->dirtyX1) atlas->dirtyX1 = x + w;
+    if(y + h > atlas->dirtyY1) atlas->dirtyY1 = y + h;
+}
+
+// Finds room for a w x h bitmap. Returns false if the atlas is full.
+static bool __glyphatlas_pack(glyphatlas_t* atlas, int w, int h, int* x, int* y) {
+    int paddedW = w + GLYPHATLAS_PADDING;
+    int paddedH = h + GLYPHATLAS_PADDING;
+    if(paddedW > atlas->width || paddedH > atlas->height) {
+        return false;
+    }
+
+    // Start a new shelf if it doesn't fit on this one.
+    if(atlas->shelfX + paddedW > atlas->width) {
+        atlas->shelfY += atlas->shelfHeight;
+        atlas->shelfX = 0;
+        atlas->shelfHeight = 0;
+    }
+    if(atlas->shelfY + paddedH > atlas->height) {
+        return false;
+    }
+
+    *x = atlas->shelfX;
+    *y = atlas->shelfY;
+    atlas->shelfX += paddedW;
+    if(paddedH > atlas->shelfHeight) {
+        atlas->shelfHeight = paddedH;
+    }
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Sets up an atlas.
+ *
+ * @param atlas The atlas.
+ * @param width Atlas width in pixels.
+ * @param height Atlas height in pixels.
+ * @param source Where glyphs come from.
+ *
+ * @returns false if out of memory.
+*/
+bool GlyphAtlas_Init(glyphatlas_t* atlas, int width, int height, glyphsource_t source) {
+    memset(atlas, 0, sizeof(glyphatlas_t));
+    atlas->width = width;
+    atlas->height = height;
+    atlas->source = source;
+    atlas->pixels = calloc((size_t)width * height, 1);
+    atlas->glyphCapacity = GLYPHATLAS_INITIAL_GLYPHS;
+    atlas->glyphs = calloc(atlas->glyphCapacity, sizeof(atlasglyph_t));
+    if(atlas->pixels == NULL || atlas->glyphs == NULL) {
+        GlyphAtlas_Free(atlas);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Frees an atlas.
+*/
+void GlyphAtlas_Free(glyphatlas_t* atlas) {
+    free(atlas->pixels);
+    free(atlas->glyphs);
+    atlas->pixels = NULL;
+    atlas->glyphs = NULL;
+    atlas->glyphCapacity = 0;
+    atlas->glyphCount = 0;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Empties the atlas bitmap. Metrics are kept, glyphs get re-packed as they're used.
+*/
+void GlyphAtlas_Reset(glyphatlas_t* atlas) {
+    memset(atlas->pixels, 0, (size_t)atlas->width * atlas->height);
+    atlas->shelfX = 0;
+    atlas->shelfY = 0;
+    atlas->shelfHeight = 0;
+    for(int i = 0; i < atlas->glyphCapacity; i++) {
+        if(atlas->glyphs[i].state == GLYPH_PACKED) {
+            atlas->glyphs[i].state = GLYPH_METRICS;
+        }
+    }
+    __glyphatlas_markDirty(atlas, 0, 0, atlas->width, atlas->height);
+    atlas->resets++;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Gets a glyph's metrics without rasterising it.
+ *
+ * @returns The glyph, or NULL if the font doesn't have it.
+*/
+const atlasglyph_t* GlyphAtlas_GetMetrics(glyphatlas_t* atlas, uint32_t codepoint) {
+    atlasglyph_t* glyph = __glyphatlas_slot(atlas->glyphs, atlas->glyphCapacity, codepoint);
+    if(glyph->state == GLYPH_EMPTY) {
+        // Keep the table under 70% full.
+        if((atlas->glyphCount + 1) * 10 > atlas->glyphCapacity * 7) {
+            if(!__glyphatlas_grow(atlas)) {
+                return NULL;
+            }
+            glyph = __glyphatlas_slot(atlas->glyphs, atlas->glyphCapacity, codepoint);
+        }
+
+        memset(glyph, 0, sizeof(atlasglyph_t));
+        glyph->codepoint = codepoint;
+        glyph->state = atlas->source.metrics(atlas->source.ctx, codepoint, glyph) ? GLYPH_METRICS : GLYPH_MISSING;
+        glyph->codepoint = codepoint;
+        atlas->glyphCount++;
+    }
+    return glyph->state == GLYPH_MISSING ? NULL : glyph;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Gets a glyph, rasterising it into the atlas if it isn't there yet.
+ *
+ * @returns The glyph, or NULL if the font doesn't have it or the atlas is full.
+*/
+const atlasglyph_t* GlyphAtlas_GetGlyph(glyphatlas_t* atlas, uint32_t codepoint) {
+    atlasglyph_t* glyph = (atlasglyph_t*)GlyphAtlas_GetMetrics(atlas, codepoint);
+    if(glyph == NULL || glyph->state == GLYPH_PACKED) {
+        return glyph;
+    }
+
+    // Blank glyphs (spaces) don't need any room.
+    if(glyph->width <= 0 || glyph->height <= 0) {
+        glyph->atlasX = 0;
+        glyph->atlasY = 0;
+        glyph->state = GLYPH_PACKED;
+        return glyph;
+    }
+
+    int x, y;
+    if(!__glyphatlas_pack(atlas, glyph->width, glyph->height, &x, &y)) {
+        return NULL;
+    }
+
+    uint8_t* dst = atlas->pixels + (size_t)y * atlas->width + x;
+    if(!atlas->source.rasterize(atlas->source.ctx, glyph, dst, atlas->width)) {
+        glyph->state = GLYPH_MISSING;
+        return NULL;
+    }
+
+    glyph->atlasX = (int16_t)x;
+    glyph->atlasY = (int16_t)y;
+    glyph->state = GLYPH_PACKED;
+    __glyphatlas_markDirty(atlas, x, y, glyph->width, glyph->height);
+    return glyph;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Measures a string without rasterising anything. Same result as GRRLIB_WidthTTF.
+ *
+ * @returns Width in pixels.
+*/
+int GlyphAtlas_Measure(glyphatlas_t* atlas, const char* utf8) {
+    int penX = 0;
+    uint32_t previous = 0;
+    while(*utf8) {
+        uint32_t codepoint = GlyphAtlas_DecodeUTF8(&utf8);
+        const atlasglyph_t* glyph = GlyphAtlas_GetMetrics(atlas, codepoint);
+        if(glyph == NULL) {
+            continue;
+        }
+        if(previous && glyph->glyphIndex && atlas->source.kerning != NULL) {
+            penX += atlas->source.kerning(atlas->source.ctx, previous, glyph->glyphIndex);
+        }
+        penX += glyph->advance;
+        previous = glyph->glyphIndex;
+    }
+    return penX;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Lays a string out as quads, packing any glyphs that aren't in the atlas yet.
+ * Glyphs land where GRRLIB_PrintfTTF would put them.
+ *
+ * @param atlas The atlas.
+ * @param utf8 The text.
+ * @param x Left edge.
+ * @param y Top edge.
+ * @param baseline Distance from the top edge to the baseline (the font size, for GRRLIB parity).
+ * @param quads Gets the quads.
+ * @param maxQuads Size of quads. Extra glyphs are dropped.
+ * @param width Gets the string width, can be NULL.
+ *
+ * @returns Number of quads, or -1 if the atlas filled up (reset it and try again).
+*/
+int GlyphAtlas_Layout(glyphatlas_t* atlas, const char* utf8, float x, float y, int baseline, glyphquad_t* quads, int maxQuads, int* width) {
+    float invW = 1.0f / atlas->width;
+    float invH = 1.0f / atlas->height;
+    int count = 0;
+    int penX = 0;
+    uint32_t previous = 0;
+
+    while(*utf8) {
+        uint32_t codepoint = GlyphAtlas_DecodeUTF8(&utf8);
+        const atlasglyph_t* glyph = GlyphAtlas_GetMetrics(atlas, codepoint);
+        if(glyph == NULL) {
+            continue;
+        }
+        if(previous && glyph->glyphIndex && atlas->source.kerning != NULL) {
+            penX += atlas->source.kerning(atlas->source.ctx, previous, glyph->glyphIndex);
+        }
+
+        if(glyph->width > 0 && glyph->height > 0 && count < maxQuads) {
+            glyph = GlyphAtlas_GetGlyph(atlas, codepoint);
+            if(glyph == NULL) {
+                return -1;
+            }
+
+            glyphquad_t* quad = &quads[count++];
+            quad->x0 = x + penX + glyph->bearingX;
+            quad->y0 = y + baseline - glyph->bearingY;
+            quad->x1 = quad->x0 + glyph->width;
+            quad->y1 = quad->y0 + glyph->height;
+            quad->u0 = glyph->atlasX * invW;
+            quad->v0 = glyph->atlasY * invH;
+            quad->u1 = (glyph->atlasX + glyph->width) * invW;
+            quad->v1 = (glyph->atlasY + glyph->height) * invH;
+        }
+
+        penX += glyph->advance;
+        previous = glyph->glyphIndex;
+    }
+
+    if(width != NULL) {
+        *width = penX;
+    }
+    return count;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Gets (and clears) the part of the atlas that changed since the last call,
+ * so the renderer only re-uploads that.
+ *
+ * @returns false if nothing changed.
+*/
+bool GlyphAtlas_TakeDirty(glyphatlas_t* atlas, int* x, int* y, int* w, int* h) {
+    if(atlas->dirtyX1 <= atlas->dirtyX0) {
+        return false;
+    }
+    *x = atlas->dirtyX0;
+    *y = atlas->dirtyY0;
+    *w = atlas->dirtyX1 - atlas->dirtyX0;
+    *h = atlas->dirtyY1 - atlas->dirtyY0;
+    atlas->dirtyX0 = atlas->dirtyY0 = atlas->dirtyX1 = atlas->dirtyY1 = 0;
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Reads one codepoint from a UTF-8 string and moves the pointer past it.
+ * Broken sequences come back as U+FFFD.
+*/
+uint32_t GlyphAtlas_DecodeUTF8(const char** str) {
+    const unsigned char* s = (const unsigned char*)*str;
+    uint32_t codepoint;
+    int extra;
+
+    if(s[0] < 0x80) {
+        *str += 1;
+        return s[0];
+    } else if((s[0] & 0xE0) == 0xC0) {
+        codepoint = s[0] & 0x1F;
+        extra = 1;
+    } else if((s[0] & 0xF0) == 0xE0) {
+        codepoint = s[0] & 0x0F;
+        extra = 2;
+    } else if((s[0] & 0xF8) == 0xF0) {
+        codepoint = s[0] & 0x07;
+        extra = 3;
+    } else {
+        *str += 1;
+        return GLYPHATLAS_REPLACEMENT;
+    }
+
+    for(int i = 1; i <= extra; i++) {
+        if((s[i] & 0xC0) != 0x80) {
+            *str += i;
+            return GLYPHATLAS_REPLACEMENT;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+    *str += extra + 1;
+    return codepoint;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Writes a codepoint as UTF-8.
+ *
+ * @param codepoint The codepoint.
+ * @param out At least 5 bytes, gets NUL terminated.
+ *
+ * @returns Bytes written, not counting the NUL.
+*/
+int GlyphAtlas_EncodeUTF8(uint32_t codepoint, char* out) {
+    int length;
+    if(codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        length = 1;
+    } else if(codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        length = 2;
+    } else if(codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        length = 3;
+    } else {
+        out[0] = (char)(0xF0 | (codepoint >> 18));
+        out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (codepoint & 0x3F));
+        length = 4;
+    }
+    out[length] = '\0';
+    return length;
+}
@@ -14,6 +14,10 @@
 #include <math.h>
 
 #include "rend/audio.h"
+#include "rend/text.h"
+#include "rend/assets.h"
+#include "rend/framearena.h"
+#include "rend/coreEngine.h"
 #include "rend/buttons.h"
 #include "rend/osk.h"
 #include "misc/carhorn_defs.h"
@@ -70,16 +74,16 @@ int getNumInput(char* msg) {
     ir_t ir;
 
     // Cursor
-    GRRLIB_texImg* cursor = GRRLIB_LoadTexture(cursor_png);
+    GRRLIB_texImg* cursor = Assets_GetTexture(cursor_png);
     Size cSize;
     cSize.w = 1;
     cSize.h = cursor->h;
 
     // Background image.
-    GRRLIB_texImg* bgImg = GRRLIB_LoadTexture(wiibg_jpg);
+    GRRLIB_texImg* bgImg = Assets_GetTexture(wiibg_jpg);
 
     // Font.
-    GRRLIB_ttfFont* globalFont = GRRLIB_LoadTTF(font_ttf, font_ttf_size);
+    GRRLIB_ttfFont* globalFont = Assets_GetFont(font_ttf, font_ttf_size);
 
     // Create an incremental key.
     spritedbtn_t keybtn = CreateButton(0,0, "BN", GetStdBtnOptions(NULL, __osk_hoverFunction, 20), GetStdBtnAssets(COL_WHITE, COL_WHITE, globalFont));
@@ -87,7 +91,8 @@ int getNumInput(char* msg) {
     spritedbtn_t rightBtn = CreateButton(0,0, "", GetStdBtnOptions(__osk_num_onRightArrow, __osk_hoverFunction, 20), GetStdBtnAssets(COL_WHITE, COL_WHITE, globalFont));
 
     // Change key texture.
-    keybtn.assets.btnTexture = GRRLIB_LoadTexture(std_key_png);
+    Assets_Release(keybtn.assets.btnTexture);
+    keybtn.assets.btnTexture = Assets_GetTexture(std_key_png);
     keybtn.assets.w = keybtn.assets.btnTexture->w;
     keybtn.assets.h = keybtn.assets.btnTexture->h;
 
@@ -97,10 +102,12 @@ int getNumInput(char* msg) {
     keybtn.pnt.y = (SCREEN_HEIGHT / 2) - (keyBtnSize.h / 2);
 
     // Retexture the side keys.
-    leftBtn.assets.btnTexture = GRRLIB_LoadTexture(std_arrow_left_png);
+    Assets_Release(leftBtn.assets.btnTexture);
+    leftBtn.assets.btnTexture = Assets_GetTexture(std_arrow_left_png);
     leftBtn.assets.w = leftBtn.assets.btnTexture->w;
     leftBtn.assets.h = leftBtn.assets.btnTexture->h;
-    rightBtn.assets.btnTexture = GRRLIB_LoadTexture(std_arrow_right_png);
+    Assets_Release(rightBtn.assets.btnTexture);
+    rightBtn.assets.btnTexture = Assets_GetTexture(std_arrow_right_png);
     rightBtn.assets.w = rightBtn.assets.btnTexture->w;
     rightBtn.assets.h = rightBtn.assets.btnTexture->h;
 
@@ -118,7 +125,7 @@ int getNumInput(char* msg) {
     // main loop
     while(true) {
         // Scan for button presses.
-        WPAD_ScanPads();
+        CoreEngine_ScanPads();
         WPAD_IR(WPAD_CHAN_0, &ir);
         s32 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
 
@@ -132,18 +139,17 @@ int getNumInput(char* msg) {
         GRRLIB_DrawImg(0,0, bgImg, 0, 1,1, COL_WHITE);
 
         // Draw the message.
-        GRRLIB_PrintfTTF(0,0, globalFont, msg, 28, COL_WHITE);
+        Text_Draw(0,0, globalFont, msg, 28, COL_WHITE);
 
         // Change selected number text.
-        char* selKey = malloc(100);
-        //sprintf(selKey, "%c", validEntrys[__osk_num_selecInput]);
-        sprintf(selKey, "%d", __osk_num_selecInput);
+        //char* selKey = FrameArena_Printf("%c", validEntrys[__osk_num_selecInput]);
+        char* selKey = FrameArena_Printf("%d", __osk_num_selecInput);
         keybtn.str = selKey;
 
         // Render main key button.
-        renderSpritedButton(keybtn);
-        renderSpritedButton(leftBtn);
-        renderSpritedButton(rightBtn);
+        renderSpritedButton(&keybtn);
+        renderSpritedButton(&leftBtn);
+        renderSpritedButton(&rightBtn);
 
         // Check keys.
         checkButtonStatus(&keybtn, ir.x,ir.y, cSize, pressed);
@@ -152,10 +158,15 @@ int getNumInput(char* msg) {
 
         // Render.
         GRRLIB_DrawImg(ir.x,ir.y, cursor, 0, 1,1, COL_WHITE);
-        GRRLIB_Render();
-
-        // Free allocated mem.
-        free(selKey);
+        CoreEngine_Render();
     }
+
+    // Give the assets back to the cache.
+    DestroyButton(&keybtn);
+    DestroyButton(&leftBtn);
+    DestroyButton(&rightBtn);
+    Assets_Release(globalFont);
+    Assets_Release(bgImg);
+    Assets_Release(cursor);
     return __osk_num_selecInput;
 }
\ No newline at end of file
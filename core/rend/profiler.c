@@ -0,0 +1,303 @@
+/**
+ * @file profiler.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Scoped timers so we can see where the frame goes. Samples land in a ring buffer,
+ * the overlay shows a frame time graph and the most expensive scopes, and the buffer
+ * can be dumped as a Chrome trace (open it in chrome://tracing or Perfetto).
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Wii Specific.
+#include <gctypes.h>
+#include <gccore.h>
+#ifdef HW_RVL
+#include <ogc/lwp_watchdog.h>
+#endif
+
+// Our #1 graphics library.
+#include <grrlib.h>
+
+#include "cJSON.h"
+
+// core.
+#include "rend/profiler.h"
+#include "rend/text.h"
+#include "rend/assets.h"
+#include "rend/framearena.h"
+#include "misc/carhorn_defs.h"
+
+// Font.
+#include "font_ttf.h"
+
+#define PROFILER_WINDOW 60          // Frames the top scopes are averaged over.
+#define PROFILER_GRAPH_H 60         // Overlay graph height in pixels (= 30ms).
+#define PROFILER_TARGET_US 16667    // 60fps.
+#define PROFILER_TRACE_BUFFER 4096  // Trace dumps go out to the SD this much at a time.
+
+profsample_t __profiler_samples[PROFILER_MAX_SAMPLES];
+uint32_t __profiler_seq = 0;
+mutex_t __profiler_lock = LWP_MUTEX_NULL;
+uint64_t __profiler_epoch = 0;
+
+// Frame marks.
+uint64_t __profiler_frameMarks[PROFILER_FRAMES];
+uint32_t __profiler_frames = 0;
+
+bool __profiler_overlay = false;
+GRRLIB_ttfFont* __profiler_font = NULL;
+
+static void __profiler_lockSamples() {
+    if(__profiler_lock == LWP_MUTEX_NULL) {
+        LWP_MutexInit(&__profiler_lock, false);
+    }
+    LWP_MutexLock(__profiler_lock);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pn_p0 Microseconds since the profiler first got used. Uses the Wii's time
+ * base, or clock_gettime on a PC.
+*/
+uint64_t Profiler_Now() {
+#ifdef HW_RVL
+    uint64_t now = ticks_to_microsecs(gettime());
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+    if(__profiler_epoch == 0) {
+        __profiler_epoch = now - 1; // Keep 0 free for "not ended".
+    }
+    return now - __profiler_epoch;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pb_p0 Starts timing a scope. Safe from any thread.
+ * 
+ * @param name Scope name. Must be a string literal.
+ * 
+ * @returns Handle for Profiler_End.
+*/
+profscope_t Profiler_Begin(const char* name) {
+    uint64_t now = Profiler_Now();
+
+    __profiler_lockSamples();
+    uint32_t seq = ++__profiler_seq;
+    profsample_t* sample = &__profiler_samples[seq % PROFILER_MAX_SAMPLES];
+    sample->name = name;
+    sample->start = now;
+    sample->end = 0;
+    sample->seq = seq;
+    sample->thread = (uint32_t)LWP_GetSelf();
+    LWP_MutexUnlock(__profiler_lock);
+    return seq;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pe_p0 Stops timing a scope. Does nothing if the ring buffer already
+ * wrapped over it.
+*/
+void Profiler_End(profscope_t scope) {
+    uint64_t now = Profiler_Now();
+
+    __profiler_lockSamples();
+    profsample_t* sample = &__profiler_samples[scope % PROFILER_MAX_SAMPLES];
+    if(sample->seq == scope) {
+        sample->end = now;
+    }
+    LWP_MutexUnlock(__profiler_lock);
+}
+
+// Cleanup function for PROFILE_SCOPE.
+void Profiler_EndScope(profscope_t* scope) {
+    Profiler_End(*scope);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pfm_p0 Marks the end of a frame. CoreEngine_Render calls this.
+*/
+void Profiler_FrameMark() {
+    __profiler_frameMarks[__profiler_frames % PROFILER_FRAMES] = Profiler_Now();
+    __profiler_frames++;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph plfm_p0 How long the last frame took.
+*/
+float Profiler_LastFrameMs() {
+    if(__profiler_frames < 2) {
+        return 0;
+    }
+    uint64_t last = __profiler_frameMarks[(__profiler_frames - 1) % PROFILER_FRAMES];
+    uint64_t previous = __profiler_frameMarks[(__profiler_frames - 2) % PROFILER_FRAMES];
+    return (last - previous) / 1000.0f;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pso_p0 Shows or hides the overlay.
+*/
+void Profiler_SetOverlay(bool visible) {
+    __profiler_overlay = visible;
+}
+
+bool Profiler_OverlayVisible() {
+    return __profiler_overlay;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pdo_p0 Draws the overlay: frame time graph and the scopes that took the
+ * most time per frame, averaged over the last second. Only the main thread should call
+ * this (CoreEngine_Render does when it's visible).
+*/
+void Profiler_DrawOverlay() {
+    if(__profiler_font == NULL) {
+        __profiler_font = Assets_GetFont(font_ttf, font_ttf_size);
+    }
+
+    int frames = __profiler_frames < PROFILER_FRAMES ? (int)__profiler_frames : PROFILER_FRAMES;
+    int x = SCREEN_WIDTH - PROFILER_FRAMES * 2 - 10;
+    int y = 40;
+
+    // Frame time graph, one bar per frame.
+    GRRLIB_Rectangle(x - 4, y - 4, PROFILER_FRAMES * 2 + 8, PROFILER_GRAPH_H + 48 + PROFILER_TOP_SCOPES * 16, 0x000000B0, true);
+    for(int i = 1; i < frames; i++) {
+        uint32_t frame = __profiler_frames - frames + i;
+        uint64_t us = __profiler_frameMarks[frame % PROFILER_FRAMES] - __profiler_frameMarks[(frame - 1) % PROFILER_FRAMES];
+        int h = (int)(us * PROFILER_GRAPH_H / (PROFILER_TARGET_US * 2));
+        if(h > PROFILER_GRAPH_H) h = PROFILER_GRAPH_H;
+        GRRLIB_Rectangle(x + i * 2, y + PROFILER_GRAPH_H - h, 2, h, us > PROFILER_TARGET_US + 500 ? COL_RED : COL_GREEN, true);
+    }
+    GRRLIB_Line(x, y + PROFILER_GRAPH_H / 2, x + PROFILER_FRAMES * 2, y + PROFILER_GRAPH_H / 2, COL_YELLOW); // 16.7ms
+    y += PROFILER_GRAPH_H + 4;
+
+    Text_Draw(x, y, __profiler_font, FrameArena_Printf("Frame: %.2f ms", Profiler_LastFrameMs()), 14, COL_WHITE);
+    y += 18;
+
+    // Frame arena use over the last whole frame, red if anything spilled to the heap.
+    framearenaframe_t arena = FrameArena_GetStats().lastFrame;
+    Text_Draw(x, y, __profiler_font, FrameArena_Printf("Arena: %u allocs, %.1f KB, %u heap", arena.allocs, arena.used / 1024.0f, arena.heapFallbacks), 14,
+        arena.heapFallbacks > 0 ? COL_RED : COL_WHITE);
+    y += 18;
+
+    // Add up every scope that finished within the window.
+    int windowFrames = frames - 1 < PROFILER_WINDOW ? frames - 1 : PROFILER_WINDOW;
+    if(windowFrames <= 0) {
+        return;
+    }
+    uint64_t windowStart = __profiler_frameMarks[(__profiler_frames - 1 - windowFrames) % PROFILER_FRAMES];
+    uint64_t windowEnd = __profiler_frameMarks[(__profiler_frames - 1) % PROFILER_FRAMES];
+
+    typedef struct { const char* name; uint64_t total; } scopetotal_t;
+    scopetotal_t totals[32];
+    int count = 0;
+
+    __profiler_lockSamples();
+    for(int i = 0; i < PROFILER_MAX_SAMPLES; i++) {
+        profsample_t* sample = &__profiler_samples[i];
+        if(sample->name == NULL || sample->end == 0 || sample->start < windowStart || sample->end > windowEnd) {
+            continue;
+        }
+        int j;
+        for(j = 0; j < count && totals[j].name != sample->name; j++);
+        if(j == count) {
+            if(count == 32) continue;
+            totals[count].name = sample->name;
+            totals[count].total = 0;
+            count++;
+        }
+        totals[j].total += sample->end - sample->start;
+    }
+    LWP_MutexUnlock(__profiler_lock);
+
+    // Biggest first (it's at most 32, a selection sort is fine).
+    for(int i = 0; i < count && i < PROFILER_TOP_SCOPES; i++) {
+        int best = i;
+        for(int j = i + 1; j < count; j++) {
+            if(totals[j].total > totals[best].total) best = j;
+        }
+        scopetotal_t swap = totals[i];
+        totals[i] = totals[best];
+        totals[best] = swap;
+
+        char* line = FrameArena_Printf("%s: %.2f ms", totals[i].name, totals[i].total / 1000.0f / windowFrames);
+        Text_Draw(x, y, __profiler_font, line, 14, COL_WHITE);
+        y += 16;
+    }
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph pdt_p0 Writes everything in the ring buffer out as a Chrome trace.
+ * 
+ * @param path Where to write it.
+ * 
+ * @returns false if the file couldn't be written.
+*/
+bool Profiler_DumpTrace(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if(fp == NULL) {
+        return false;
+    }
+
+    // Straight to the file, no tree (there can be thousands of samples).
+    char buffer[PROFILER_TRACE_BUFFER];
+    cJSON_Writer writer;
+    cJSON_InitWriter(&writer, buffer, sizeof(buffer), cJSON_FlushToFile, fp);
+
+    cJSON_WriteStartObject(&writer);
+    cJSON_WriteKey(&writer, "displayTimeUnit");
+    cJSON_WriteString(&writer, "ms");
+    cJSON_WriteKey(&writer, "traceEvents");
+    cJSON_WriteStartArray(&writer);
+
+    // Frame boundaries.
+    int frames = __profiler_frames < PROFILER_FRAMES ? (int)__profiler_frames : PROFILER_FRAMES;
+    for(int i = 0; i < frames; i++) {
+        uint32_t frame = __profiler_frames - frames + i;
+        cJSON_WriteStartObject(&writer);
+        cJSON_WriteKey(&writer, "name"); cJSON_WriteString(&writer, "Frame");
+        cJSON_WriteKey(&writer, "ph"); cJSON_WriteString(&writer, "i");
+        cJSON_WriteKey(&writer, "s"); cJSON_WriteString(&writer, "g");
+        cJSON_WriteKey(&writer, "pid"); cJSON_WriteNumber(&writer, 0);
+        cJSON_WriteKey(&writer, "tid"); cJSON_WriteNumber(&writer, 0);
+        cJSON_WriteKey(&writer, "ts"); cJSON_WriteNumber(&writer, (double)__profiler_frameMarks[frame % PROFILER_FRAMES]);
+        cJSON_WriteEndObject(&writer);
+    }
+
+    // Scopes, oldest first.
+    __profiler_lockSamples();
+    for(uint32_t i = 1; i <= PROFILER_MAX_SAMPLES; i++) {
+        profsample_t* sample = &__profiler_samples[(__profiler_seq + i) % PROFILER_MAX_SAMPLES];
+        if(sample->name == NULL || sample->end == 0) {
+            continue;
+        }
+        cJSON_WriteStartObject(&writer);
+        cJSON_WriteKey(&writer, "name"); cJSON_WriteString(&writer, sample->name);
+        cJSON_WriteKey(&writer, "ph"); cJSON_WriteString(&writer, "X");
+        cJSON_WriteKey(&writer, "pid"); cJSON_WriteNumber(&writer, 0);
+        cJSON_WriteKey(&writer, "tid"); cJSON_WriteNumber(&writer, sample->thread);
+        cJSON_WriteKey(&writer, "ts"); cJSON_WriteNumber(&writer, (double)sample->start);
+        cJSON_WriteKey(&writer, "dur"); cJSON_WriteNumber(&writer, (double)(sample->end - sample->start));
+        cJSON_WriteEndObject(&writer);
+    }
+    LWP_MutexUnlock(__profiler_lock);
+
+    cJSON_WriteEndArray(&writer);
+    cJSON_WriteEndObject(&writer);
+    bool ok = cJSON_WriterFinish(&writer);
+    return (fclose(fp) == 0) && ok;
+}
@@ -0,0 +1,489 @@
+/**
+ * @file text.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Text helpers. GRRLIB_PrintfTTF rasterises (and plots every pixel of) every glyph on every
+ * call, so all text goes through here instead: Text_Draw keeps a glyph atlas per font and
+ * size (see glyphatlas.c) and draws strings as quads out of it, and Text_RenderToTexture
+ * bakes a string into its own texture for things that hardly ever change.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <malloc.h>
+
+// Wii Specific.
+#include <gctypes.h>
+#include <gccore.h>
+
+// Our #1 graphics library.
+#include <grrlib.h>
+
+// core.
+#include "rend/text.h"
+#include "rend/glyphatlas.h"
+#include "rend/profiler.h"
+
+/* Glyph atlas renderer */
+
+#define TEXT_MAX_FACES 8            // Font/size pairs with an atlas at once.
+#define TEXT_MAX_QUADS 256          // Glyphs per draw call.
+#define TEXT_SMALL_ATLAS 256        // Atlas size for font sizes up to TEXT_SMALL_SIZE.
+#define TEXT_LARGE_ATLAS 512        // And for everything bigger.
+#define TEXT_SMALL_SIZE 32
+
+// One font at one size, with its atlas and the GX texture it's uploaded to.
+typedef struct {
+    GRRLIB_ttfFont* font;
+    unsigned int fontSize;
+    glyphatlas_t atlas;
+    u8* texture;                    // IA8, 4x4 tiles.
+    unsigned int lastUsed;
+    bool pinned;                    // Made by Text_ReserveAtlas, never kicked out.
+} textface_t;
+
+textface_t __text_faces[TEXT_MAX_FACES];
+unsigned int __text_clock = 0;
+glyphquad_t __text_quads[TEXT_MAX_QUADS];
+mutex_t __text_lock = LWP_MUTEX_NULL;
+
+// Only the main thread draws, but Text_Width and Text_RenderToTexture don't touch GX, so
+// nothing stops a worker calling them. FreeType faces aren't thread safe, and uncontended
+// this costs next to nothing.
+static void __text_lockFaces() {
+    if(__text_lock == LWP_MUTEX_NULL) {
+        LWP_MutexInit(&__text_lock, false);
+    }
+    LWP_MutexLock(__text_lock);
+}
+
+// glyphsource_t: metrics from FreeType without rendering.
+static bool __text_ftMetrics(void* ctx, uint32_t codepoint, atlasglyph_t* glyph) {
+    textface_t* face = ctx;
+    FT_Face ftFace = face->font->face;
+    if(FT_Set_Pixel_Sizes(ftFace, 0, face->fontSize)) {
+        FT_Set_Pixel_Sizes(ftFace, 0, 12);
+    }
+
+    FT_UInt glyphIndex = FT_Get_Char_Index(ftFace, codepoint);
+    if(FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+
+    FT_Glyph_Metrics* metrics = &ftFace->glyph->metrics;
+    glyph->glyphIndex = glyphIndex;
+    glyph->bearingX = metrics->horiBearingX >> 6;
+    glyph->bearingY = metrics->horiBearingY >> 6;
+    glyph->width = (metrics->width + 63) >> 6;
+    glyph->height = (metrics->height + 63) >> 6;
+    glyph->advance = ftFace->glyph->advance.x >> 6;
+    return true;
+}
+
+// glyphsource_t: renders a glyph into the atlas.
+static bool __text_ftRasterize(void* ctx, const atlasglyph_t* glyph, uint8_t* dst, int pitch) {
+    textface_t* face = ctx;
+    FT_Face ftFace = face->font->face;
+    if(FT_Set_Pixel_Sizes(ftFace, 0, face->fontSize)) {
+        FT_Set_Pixel_Sizes(ftFace, 0, 12);
+    }
+    if(FT_Load_Glyph(ftFace, glyph->glyphIndex, FT_LOAD_RENDER)) {
+        return false;
+    }
+
+    // The rendered bitmap can be a pixel off from the metrics, clip to what we packed.
+    FT_GlyphSlot slot = ftFace->glyph;
+    FT_Bitmap* bitmap = &slot->bitmap;
+    int offX = slot->bitmap_left - glyph->bearingX;
+    int offY = glyph->bearingY - slot->bitmap_top;
+    for(unsigned int row = 0; row < bitmap->rows; row++) {
+        int y = (int)row + offY;
+        if(y < 0 || y >= glyph->height) continue;
+        for(unsigned int col = 0; col < bitmap->width; col++) {
+            int x = (int)col + offX;
+            if(x < 0 || x >= glyph->width) continue;
+            dst[y * pitch + x] = bitmap->buffer[row * bitmap->pitch + col];
+        }
+    }
+    return true;
+}
+
+// glyphsource_t: kerning.
+static int __text_ftKerning(void* ctx, uint32_t leftIndex, uint32_t rightIndex) {
+    textface_t* face = ctx;
+    if(!face->font->kerning) {
+        return 0;
+    }
+    FT_Vector delta;
+    FT_Get_Kerning(face->font->face, leftIndex, rightIndex, FT_KERNING_DEFAULT, &delta);
+    return delta.x >> 6;
+}
+
+// Frees a face's atlas and texture.
+static void __text_freeFace(textface_t* face) {
+    GlyphAtlas_Free(&face->atlas);
+    free(face->texture);
+    memset(face, 0, sizeof(textface_t));
+}
+
+// Sets up a free face slot with a width x height atlas.
+static textface_t* __text_makeFace(textface_t* face, GRRLIB_ttfFont* font, unsigned int fontSize, int width, int height) {
+    face->font = font;
+    face->fontSize = fontSize;
+    face->texture = memalign(32, width * height * 2);
+    glyphsource_t source = { face, __text_ftMetrics, __text_ftRasterize, __text_ftKerning };
+    if(face->texture == NULL || !GlyphAtlas_Init(&face->atlas, width, height, source)) {
+        __text_freeFace(face);
+        return NULL;
+    }
+    memset(face->texture, 0, width * height * 2);
+    face->lastUsed = ++__text_clock;
+    return face;
+}
+
+// Finds the atlas for a font and size, or the slot to make it in (free, or the least recently used).
+static textface_t* __text_findFace(GRRLIB_ttfFont* font, unsigned int fontSize, bool* found) {
+    textface_t* oldest = NULL;
+    for(int i = 0; i < TEXT_MAX_FACES; i++) {
+        textface_t* face = &__text_faces[i];
+        if(face->font == font && face->fontSize == fontSize) {
+            *found = true;
+            return face;
+        }
+        if(face->pinned) {
+            continue;
+        }
+        if(oldest == NULL || face->font == NULL || (oldest->font != NULL && face->lastUsed < oldest->lastUsed)) {
+            oldest = face;
+        }
+    }
+    *found = false;
+    return oldest;
+}
+
+// Finds (or makes) the atlas for a font and size.
+static textface_t* __text_getFace(GRRLIB_ttfFont* font, unsigned int fontSize) {
+    bool found;
+    textface_t* face = __text_findFace(font, fontSize, &found);
+    if(found) {
+        face->lastUsed = ++__text_clock;
+        return face;
+    }
+    if(face == NULL) {
+        return NULL;    // Every slot is pinned.
+    }
+
+    // Kick out the least recently used one if we're full.
+    if(face->font != NULL) {
+        __text_freeFace(face);
+    }
+    int size = fontSize <= TEXT_SMALL_SIZE ? TEXT_SMALL_ATLAS : TEXT_LARGE_ATLAS;
+    return __text_makeFace(face, font, fontSize, size, size);
+}
+
+// Copies the changed part of the atlas into the IA8 texture.
+static void __text_upload(textface_t* face) {
+    int x0, y0, w, h;
+    if(!GlyphAtlas_TakeDirty(&face->atlas, &x0, &y0, &w, &h)) {
+        return;
+    }
+
+    // IA8 is 4x4 tiles of 2 byte texels (alpha, intensity). Intensity is always white,
+    // the vertex color tints it.
+    int width = face->atlas.width;
+    int tilesPerRow = width / 4;
+    for(int y = y0; y < y0 + h; y++) {
+        const u8* src = face->atlas.pixels + y * width;
+        for(int x = x0; x < x0 + w; x++) {
+            u8* texel = face->texture + ((((y >> 2) * tilesPerRow) + (x >> 2)) << 5) + ((((y & 3) << 2) + (x & 3)) << 1);
+            texel[0] = src[x];
+            texel[1] = 0xFF;
+        }
+    }
+
+    // Flush the tile rows we touched and make GX forget the old texels.
+    int rowBytes = tilesPerRow * 32;
+    int firstRow = y0 >> 2;
+    int lastRow = (y0 + h - 1) >> 2;
+    DCFlushRange(face->texture + firstRow * rowBytes, (lastRow - firstRow + 1) * rowBytes);
+    GX_InvalidateTexAll();
+}
+
+// Sends a batch of glyph quads to GX.
+static void __text_drawQuads(textface_t* face, int count, u32 color) {
+    GXTexObj texObj;
+    GX_InitTexObj(&texObj, face->texture, face->atlas.width, face->atlas.height, GX_TF_IA8, GX_CLAMP, GX_CLAMP, GX_FALSE);
+    GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
+    GX_LoadTexObj(&texObj, GX_TEXMAP0);
+
+    GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+    GX_LoadPosMtxImm(GXmodelView2D, GX_PNMTX0);
+
+    GX_Begin(GX_QUADS, GX_VTXFMT0, count * 4);
+    for(int i = 0; i < count; i++) {
+        const glyphquad_t* quad = &__text_quads[i];
+        GX_Position3f32(quad->x0, quad->y0, 0);
+        GX_Color1u32(color);
+        GX_TexCoord2f32(quad->u0, quad->v0);
+
+        GX_Position3f32(quad->x1, quad->y0, 0);
+        GX_Color1u32(color);
+        GX_TexCoord2f32(quad->u1, quad->v0);
+
+        GX_Position3f32(quad->x1, quad->y1, 0);
+        GX_Color1u32(color);
+        GX_TexCoord2f32(quad->u1, quad->v1);
+
+        GX_Position3f32(quad->x0, quad->y1, 0);
+        GX_Color1u32(color);
+        GX_TexCoord2f32(quad->u0, quad->v1);
+    }
+    GX_End();
+
+    // Put things back how GRRLIB expects them.
+    GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph td_p0 Drop in replacement for GRRLIB_PrintfTTF. Glyphs get rasterised once
+ * into an atlas for the font and size, then every call is one batch of textured quads.
+ * 
+ * @param x Left edge.
+ * @param y Top edge.
+ * @param font The font.
+ * @param str The text (UTF-8).
+ * @param fontSize Font size.
+ * @param color Text color.
+*/
+void Text_Draw(int x, int y, GRRLIB_ttfFont* font, const char* str, unsigned int fontSize, u32 color) {
+    PROFILE_SCOPE("Text_Draw");
+    if(font == NULL || str == NULL || str[0] == '\0') {
+        return;
+    }
+
+    __text_lockFaces();
+    textface_t* face = __text_getFace(font, fontSize);
+    if(face == NULL) {
+        LWP_MutexUnlock(__text_lock);
+        return;
+    }
+
+    int count = GlyphAtlas_Layout(&face->atlas, str, x, y, fontSize, __text_quads, TEXT_MAX_QUADS, NULL);
+    if(count < 0) {
+        // Atlas is full, start it again with just what this string needs.
+        GlyphAtlas_Reset(&face->atlas);
+        count = GlyphAtlas_Layout(&face->atlas, str, x, y, fontSize, __text_quads, TEXT_MAX_QUADS, NULL);
+    }
+    if(count > 0) {
+        __text_upload(face);
+        __text_drawQuads(face, count, color);
+    }
+    LWP_MutexUnlock(__text_lock);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph tw_p0 Drop in replacement for GRRLIB_WidthTTF. Only needs glyph metrics,
+ * so nothing gets rasterised.
+ * 
+ * @param font The font.
+ * @param str The text (UTF-8).
+ * @param fontSize Font size.
+ * 
+ * @returns Width in pixels.
+*/
+unsigned int Text_Width(GRRLIB_ttfFont* font, const char* str, unsigned int fontSize) {
+    if(font == NULL || str == NULL) {
+        return 0;
+    }
+
+    __text_lockFaces();
+    textface_t* face = __text_getFace(font, fontSize);
+    int width = face != NULL ? GlyphAtlas_Measure(&face->atlas, str) : 0;
+    LWP_MutexUnlock(__text_lock);
+    return width > 0 ? width : 0;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph tra_p0 Gives a font and size its own atlas of the given size, kept until
+ * Text_ForgetFont. For text that cycles through more glyphs than the default atlas
+ * holds (the wait screen spinner), which would otherwise clear it over and over.
+ *
+ * @param font The font.
+ * @param fontSize Font size.
+ * @param width Atlas width in pixels (a multiple of 4, up to 1024).
+ * @param height Atlas height in pixels (a multiple of 4, up to 1024).
+ *
+ * @returns false if out of memory, or every atlas slot is already reserved.
+*/
+bool Text_ReserveAtlas(GRRLIB_ttfFont* font, unsigned int fontSize, int width, int height) {
+    if(font == NULL) {
+        return false;
+    }
+
+    __text_lockFaces();
+    bool found;
+    textface_t* face = __text_findFace(font, fontSize, &found);
+    if(found && face->atlas.width == width && face->atlas.height == height) {
+        face->pinned = true;
+        LWP_MutexUnlock(__text_lock);
+        return true;
+    }
+    if(face != NULL && face->font != NULL) {
+        __text_freeFace(face);
+    }
+    face = face != NULL ? __text_makeFace(face, font, fontSize, width, height) : NULL;
+    if(face != NULL) {
+        face->pinned = true;
+    }
+    LWP_MutexUnlock(__text_lock);
+    return face != NULL;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph tff_p0 Throws away every atlas made from a font. Call before freeing the font.
+ * 
+ * @param font The font.
+*/
+void Text_ForgetFont(GRRLIB_ttfFont* font) {
+    __text_lockFaces();
+    for(int i = 0; i < TEXT_MAX_FACES; i++) {
+        if(__text_faces[i].font == font) {
+            __text_freeFace(&__text_faces[i]);
+        }
+    }
+    LWP_MutexUnlock(__text_lock);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @paragraph trtt_p0 Renders a string into a new texture. Glyphs land in the same place
+ * GRRLIB_PrintfTTF would put them relative to (0,0), so the texture can be drawn where
+ * the text would have been printed.
+ * 
+ * @param font The font.
+ * @param str The text.
+ * @param fontSize Font size.
+ * @param color Text color.
+ * @param width Gets the text width (same as GRRLIB_WidthTTF), can be NULL.
+ * 
+ * @returns The texture (free it with GRRLIB_FreeTexture), or NULL if there's nothing to draw.
+*/
+GRRLIB_texImg* Text_RenderToTexture(GRRLIB_ttfFont* font, const char* str, unsigned int fontSize, u32 color, int* width) {
+    if(width != NULL) {
+        *width = 0;
+    }
+    if(font == NULL || str == NULL || str[0] == '\0') {
+        return NULL;
+    }
+
+    // Same conversion GRRLIB_PrintfTTF does.
+    size_t length = strlen(str);
+    wchar_t* utf32 = malloc((length + 1) * sizeof(wchar_t));
+    if(utf32 == NULL) {
+        return NULL;
+    }
+    size_t chars = mbstowcs(utf32, str, length + 1);
+    if(chars == (size_t)-1) {
+        free(utf32);
+        return NULL;
+    }
+
+    __text_lockFaces();
+    FT_Face face = font->face;
+    if(FT_Set_Pixel_Sizes(face, 0, fontSize)) {
+        FT_Set_Pixel_Sizes(face, 0, 12);
+    }
+
+    // Pass 1: measure.
+    int penX = 0;
+    int bottom = fontSize;
+    FT_UInt previousGlyph = 0;
+    for(size_t i = 0; i < chars; i++) {
+        FT_UInt glyphIndex = FT_Get_Char_Index(face, utf32[i]);
+        if(font->kerning && previousGlyph && glyphIndex) {
+            FT_Vector delta;
+            FT_Get_Kerning(face, previousGlyph, glyphIndex, FT_KERNING_DEFAULT, &delta);
+            penX += delta.x >> 6;
+        }
+        if(FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT)) {
+            continue;
+        }
+        int glyphBottom = (int)fontSize - (face->glyph->metrics.horiBearingY >> 6) + (face->glyph->metrics.height >> 6);
+        if(glyphBottom > bottom) {
+            bottom = glyphBottom;
+        }
+        penX += face->glyph->advance.x >> 6;
+        previousGlyph = glyphIndex;
+    }
+
+    if(width != NULL) {
+        *width = penX;
+    }
+    if(penX <= 0) {
+        LWP_MutexUnlock(__text_lock);
+        free(utf32);
+        return NULL;
+    }
+
+    // RGBA8 textures are made of 4x4 tiles.
+    u32 texW = (penX + 3) & ~3;
+    u32 texH = (bottom + 1 + 3) & ~3;
+    GRRLIB_texImg* texture = GRRLIB_CreateEmptyTexture(texW, texH);
+    if(texture == NULL) {
+        LWP_MutexUnlock(__text_lock);
+        free(utf32);
+        return NULL;
+    }
+    memset(texture->data, 0, texW * texH * 4);
+
+    // Pass 2: rasterise into the texture.
+    u32 rgb = color & 0xFFFFFF00;
+    u32 alpha = color & 0xFF;
+    penX = 0;
+    previousGlyph = 0;
+    for(size_t i = 0; i < chars; i++) {
+        FT_UInt glyphIndex = FT_Get_Char_Index(face, utf32[i]);
+        if(font->kerning && previousGlyph && glyphIndex) {
+            FT_Vector delta;
+            FT_Get_Kerning(face, previousGlyph, glyphIndex, FT_KERNING_DEFAULT, &delta);
+            penX += delta.x >> 6;
+        }
+        if(FT_Load_Glyph(face, glyphIndex, FT_LOAD_RENDER)) {
+            continue;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        FT_Bitmap* bitmap = &slot->bitmap;
+        int left = penX + slot->bitmap_left;
+        int top = (int)fontSize - slot->bitmap_top;
+        for(unsigned int row = 0; row < bitmap->rows; row++) {
+            int y = top + (int)row;
+            if(y < 0 || y >= (int)texH) continue;
+            for(unsigned int col = 0; col < bitmap->width; col++) {
+                int x = left + (int)col;
+                if(x < 0 || x >= (int)texW) continue;
+                u32 coverage = bitmap->buffer[row * bitmap->pitch + col];
+                if(coverage == 0) continue;
+                GRRLIB_SetPixelTotexImg(x, y, texture, rgb | ((coverage * alpha) / 255));
+            }
+        }
+
+        penX += slot->advance.x >> 6;
+        previousGlyph = glyphIndex;
+    }
+    LWP_MutexUnlock(__text_lock);
+    free(utf32);
+
+    GRRLIB_FlushTex(texture);
+    return texture;
+}
@@ -37,6 +37,11 @@
 #include "miniz.h"
 #include "zip.h"
 
+#ifdef ZIP_ENABLE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #ifdef _MSC_VER
 #include <io.h>
 
@@ -93,12 +98,18 @@ struct zip_entry_t {
   tdefl_compressor comp;
   mz_uint32 external_attr;
   time_t m_time;
+  // Read mode: zip_entry_readchunk's inflate state, made on the first call.
+  mz_zip_reader_extract_iter_state *iter;
 };
 
 struct zip_t {
   mz_zip_archive archive;
   mz_uint level;
   struct zip_entry_t entry;
+  // Entry names in read mode: open addressing, entry index + 1 per slot (0 is
+  // empty), hashed without case so both kinds of lookup can use it.
+  mz_uint32 *name_index;
+  mz_uint32 name_index_mask;
 };
 
 enum zip_modify_t {
@@ -114,7 +125,7 @@ struct zip_entry_mark_t {
   size_t lf_length;
 };
 
-static const char *const zip_errlist[33] = {
+static const char *const zip_errlist[36] = {
     NULL,
     "not initialized\0",
     "invalid entry name\0",
@@ -148,11 +159,14 @@ static const char *const zip_errlist[33] = {
     "cannot initialize reader\0",
     "cannot initialize writer\0",
     "cannot initialize writer from reader\0",
+    "entry is not stored in memory\0",
+    "crc32 mismatch\0",
+    "cannot inflate entry\0",
 };
 
 const char *zip_strerror(int errnum) {
   errnum = -errnum;
-  if (errnum <= 0 || errnum >= 33) {
+  if (errnum <= 0 || errnum >= 36) {
     return NULL;
   }
 
@@ -310,12 +324,318 @@ static int zip_archive_truncate(mz_zip_archive *pzip) {
   return 0;
 }
 
+static int zip_archive_is_symlink(const mz_zip_archive_file_stat *info) {
+  // if zip is produced on Unix or macOS (3 and 19 from section 4.4.2.2 of zip
+  // standard) and has sym link attribute (0x80 is file, 0x40 is directory)
+  return (((info->m_version_made_by >> 8) == 3) ||
+          ((info->m_version_made_by >> 8) == 19)) &&
+         (info->m_external_attr & (0x20 << 24));
+}
+
+#ifdef ZIP_ENABLE_THREADS
+
+#define ZIP_EXTRACT_MAX_THREADS 16
+
+enum {
+  ZIP_EXTRACT_SKIP = 0, // extracted straight to disk by the caller
+  ZIP_EXTRACT_QUEUED,
+  ZIP_EXTRACT_RUNNING,
+  ZIP_EXTRACT_DONE
+};
+
+struct zip_extract_job {
+  void *buf;
+  size_t size;
+  int state;
+  int ok;
+};
+
+// Inflates regular entries on worker threads into buffers allocated up front,
+// in archive order and ahead of the writer by at most max_memory bytes.
+struct zip_extract_pool {
+  mz_zip_archive *zip_archive;
+  mz_zip_archive_file_stat info;
+  // the archive's reader, wrapped so the workers can share one FILE
+  mz_file_read_func read;
+  void *io_opaque;
+  pthread_mutex_t io_lock;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t threads[ZIP_EXTRACT_MAX_THREADS];
+  int nthreads;
+  struct zip_extract_job *jobs;
+  mz_uint njobs;
+  mz_uint queued; // jobs below this have been looked at by the writer
+  mz_uint next;   // next job for a worker
+  size_t in_flight;
+  size_t max_memory;
+  int stop;
+};
+
+static size_t zip_extract_pool_read(void *opaque, mz_uint64 ofs, void *buf,
+                                    size_t n) {
+  struct zip_extract_pool *pool = (struct zip_extract_pool *)opaque;
+  size_t read;
+  pthread_mutex_lock(&pool->io_lock);
+  read = pool->read(pool->io_opaque, ofs, buf, n);
+  pthread_mutex_unlock(&pool->io_lock);
+  return read;
+}
+
+static void *zip_extract_pool_worker(void *arg) {
+  struct zip_extract_pool *pool = (struct zip_extract_pool *)arg;
+  struct zip_extract_job *job;
+  mz_uint index;
+  int ok, stop;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (pool->next < pool->queued &&
+           pool->jobs[pool->next].state != ZIP_EXTRACT_QUEUED) {
+      pool->next++;
+    }
+    if (pool->next == pool->queued) {
+      if (pool->stop) {
+        break;
+      }
+      pthread_cond_wait(&pool->cond, &pool->lock);
+      continue;
+    }
+
+    index = pool->next++;
+    job = &pool->jobs[index];
+    job->state = ZIP_EXTRACT_RUNNING;
+    stop = pool->stop;
+    pthread_mutex_unlock(&pool->lock);
+
+    ok = !stop && mz_zip_reader_extract_to_mem_no_alloc(
+                      pool->zip_archive, index, job->buf, job->size, 0, NULL,
+                      0);
+
+    pthread_mutex_lock(&pool->lock);
+    job->ok = ok;
+    job->state = ZIP_EXTRACT_DONE;
+    pthread_cond_broadcast(&pool->cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+// Queues entries until the next one would go over max_memory. Only called by
+// the writer, which owns in_flight.
+static void zip_extract_pool_fill(struct zip_extract_pool *pool) {
+  mz_zip_archive_file_stat *info = &pool->info;
+  struct zip_extract_job *job;
+  mz_uint queued = pool->queued;
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->queued < pool->njobs) {
+    job = &pool->jobs[pool->queued];
+    if (!mz_zip_reader_file_stat(pool->zip_archive, pool->queued, info) ||
+        info->m_is_directory || !info->m_is_supported ||
+        zip_archive_is_symlink(info) ||
+        info->m_uncomp_size > (mz_uint64)pool->max_memory) {
+      job->state = ZIP_EXTRACT_SKIP;
+      pool->queued++;
+      continue;
+    }
+
+    job->size = (size_t)info->m_uncomp_size;
+    if (pool->in_flight > 0 && job->size > pool->max_memory - pool->in_flight) {
+      break;
+    }
+    job->buf = malloc(job->size ? job->size : 1);
+    job->state = job->buf ? ZIP_EXTRACT_QUEUED : ZIP_EXTRACT_SKIP;
+    if (job->buf) {
+      pool->in_flight += job->size;
+    }
+    pool->queued++;
+  }
+
+  if (pool->queued != queued) {
+    pthread_cond_broadcast(&pool->cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void zip_extract_pool_stop(struct zip_extract_pool *pool) {
+  mz_uint i;
+  int t;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+  for (t = 0; t < pool->nthreads; t++) {
+    pthread_join(pool->threads[t], NULL);
+  }
+
+  pool->zip_archive->m_pRead = pool->read;
+  pool->zip_archive->m_pIO_opaque = pool->io_opaque;
+  for (i = 0; i < pool->queued; i++) {
+    CLEANUP(pool->jobs[i].buf);
+  }
+  CLEANUP(pool->jobs);
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->io_lock);
+  free(pool);
+}
+
+// ZIP_EXTRACT_AUTO_THREADS: one inflating thread per online CPU, so a single
+// core machine extracts serially.
+static int zip_extract_threads(int threads) {
+  if (threads != ZIP_EXTRACT_AUTO_THREADS) {
+    return threads;
+  }
+#ifdef _SC_NPROCESSORS_ONLN
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > ZIP_EXTRACT_MAX_THREADS ? ZIP_EXTRACT_MAX_THREADS
+                                          : (int)cpus;
+  }
+#else
+  return 1;
+#endif
+}
+
+static struct zip_extract_pool *
+zip_extract_pool_start(mz_zip_archive *zip_archive, int threads,
+                       size_t max_memory) {
+  struct zip_extract_pool *pool = NULL;
+  mz_uint n = mz_zip_reader_get_num_files(zip_archive);
+
+  threads = zip_extract_threads(threads);
+  if (threads < 2 || n < 2) {
+    return NULL;
+  }
+  if (threads > ZIP_EXTRACT_MAX_THREADS) {
+    threads = ZIP_EXTRACT_MAX_THREADS;
+  }
+
+  pool = (struct zip_extract_pool *)calloc(1, sizeof(struct zip_extract_pool));
+  if (!pool) {
+    return NULL;
+  }
+  pool->jobs =
+      (struct zip_extract_job *)calloc(n, sizeof(struct zip_extract_job));
+  if (!pool->jobs) {
+    free(pool);
+    return NULL;
+  }
+
+  pool->zip_archive = zip_archive;
+  pool->njobs = n;
+  pool->max_memory = max_memory ? max_memory : ZIP_EXTRACT_DEFAULT_MEMORY;
+  pthread_mutex_init(&pool->io_lock, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+
+  pool->read = zip_archive->m_pRead;
+  pool->io_opaque = zip_archive->m_pIO_opaque;
+  zip_archive->m_pRead = zip_extract_pool_read;
+  zip_archive->m_pIO_opaque = pool;
+
+  for (pool->nthreads = 0; pool->nthreads < threads; pool->nthreads++) {
+    if (pthread_create(&pool->threads[pool->nthreads], NULL,
+                       zip_extract_pool_worker, pool) != 0) {
+      break;
+    }
+  }
+  if (pool->nthreads == 0) {
+    zip_extract_pool_stop(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+// Waits for entry i. Returns 1 with its data, 0 if it wasn't queued (so the
+// caller extracts it itself) or -1 if it couldn't be inflated.
+static int zip_extract_pool_take(struct zip_extract_pool *pool, mz_uint i,
+                                 void **buf, size_t *size) {
+  struct zip_extract_job *job = &pool->jobs[i];
+
+  zip_extract_pool_fill(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  if (i >= pool->queued || job->state == ZIP_EXTRACT_SKIP) {
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+  }
+  while (job->state != ZIP_EXTRACT_DONE) {
+    pthread_cond_wait(&pool->cond, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  *buf = job->buf;
+  *size = job->size;
+  return job->ok ? 1 : -1;
+}
+
+// Hands entry i's buffer back once it has been written.
+static void zip_extract_pool_release(struct zip_extract_pool *pool,
+                                     mz_uint i) {
+  struct zip_extract_job *job = &pool->jobs[i];
+  if (job->state == ZIP_EXTRACT_DONE) {
+    CLEANUP(job->buf);
+    pool->in_flight -= job->size;
+  }
+}
+
+static int zip_extract_write(const char *path, const void *buf, size_t size,
+                             const mz_zip_archive_file_stat *info) {
+  MZ_FILE *file = MZ_FOPEN(path, "wb");
+  int ok;
+  if (!file) {
+    return 0;
+  }
+  ok = MZ_FWRITE(buf, 1, size, file) == size;
+  if (MZ_FCLOSE(file) == EOF) {
+    ok = 0;
+  }
+#if !defined(MINIZ_NO_TIME) && !defined(MINIZ_NO_STDIO)
+  if (ok) {
+    mz_zip_set_file_times(path, info->m_time, info->m_time);
+  }
+#else
+  (void)info;
+#endif
+  return ok;
+}
+
+#else
+struct zip_extract_pool;
+#endif
+
+// Extracts a regular entry to path, using what the pool inflated if it did.
+static int zip_archive_extract_file(mz_zip_archive *zip_archive,
+                                    struct zip_extract_pool *pool, mz_uint i,
+                                    const char *path,
+                                    const mz_zip_archive_file_stat *info) {
+#ifdef ZIP_ENABLE_THREADS
+  void *data = NULL;
+  size_t size = 0;
+  int ok = pool ? zip_extract_pool_take(pool, i, &data, &size) : 0;
+  if (ok != 0) {
+    ok = ok > 0 && zip_extract_write(path, data, size, info);
+    zip_extract_pool_release(pool, i);
+    return ok;
+  }
+#else
+  (void)pool;
+  (void)info;
+#endif
+  return mz_zip_reader_extract_to_file(zip_archive, i, path, 0);
+}
+
 static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
+                               int threads, size_t max_memory,
                                int (*on_extract)(const char *filename,
                                                  void *arg),
                                void *arg) {
   int err = 0;
   mz_uint i, n;
+  struct zip_extract_pool *pool = NULL;
   char path[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
   char symlink_to[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
   mz_zip_archive_file_stat info;
@@ -350,6 +670,13 @@ static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
   if (filename_size > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen) {
     filename_size = MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen;
   }
+#ifdef ZIP_ENABLE_THREADS
+  pool = zip_extract_pool_start(zip_archive, threads, max_memory);
+#else
+  (void)threads;
+  (void)max_memory;
+#endif
+
   // Get and print information about each file in the archive.
   n = mz_zip_reader_get_num_files(zip_archive);
   for (i = 0; i < n; ++i) {
@@ -377,13 +704,7 @@ static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
       goto out;
     }
 
-    if ((((info.m_version_made_by >> 8) == 3) ||
-         ((info.m_version_made_by >> 8) ==
-          19)) // if zip is produced on Unix or macOS (3 and 19 from
-               // section 4.4.2.2 of zip standard)
-        && info.m_external_attr &
-               (0x20 << 24)) { // and has sym link attribute (0x80 is file, 0x40
-                               // is directory)
+    if (zip_archive_is_symlink(&info)) {
 #if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
     defined(__MINGW32__)
 #else
@@ -402,7 +723,7 @@ static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
 #endif
     } else {
       if (!mz_zip_reader_is_file_a_directory(zip_archive, i)) {
-        if (!mz_zip_reader_extract_to_file(zip_archive, i, path, 0)) {
+        if (!zip_archive_extract_file(zip_archive, pool, i, path, &info)) {
           // Cannot extract zip archive to file
           err = ZIP_ENOFILE;
           goto out;
@@ -430,6 +751,11 @@ static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
   }
 
 out:
+#ifdef ZIP_ENABLE_THREADS
+  if (pool) {
+    zip_extract_pool_stop(pool);
+  }
+#endif
   // Close the archive, freeing any resources it was using
   if (!mz_zip_reader_end(zip_archive)) {
     // Cannot end zip reader
@@ -937,6 +1263,98 @@ static ssize_t zip_entries_delete_mark(struct zip_t *zip,
   return (ssize_t)deleted_entry_num;
 }
 
+static const char *zip_central_dir_name(mz_zip_internal_state *pState,
+                                        mz_uint32 index, mz_uint *len) {
+  const mz_uint8 *header = &MZ_ZIP_ARRAY_ELEMENT(
+      &pState->m_central_dir, mz_uint8,
+      MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, index));
+  *len = MZ_READ_LE16(header + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  return (const char *)header + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
+}
+
+static mz_uint32 zip_name_hash(const char *name, size_t len) {
+  // FNV-1a, lower case so "A.png" and "a.png" land in the same chain.
+  mz_uint32 hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash ^= (mz_uint8)MZ_TOLOWER(name[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static void zip_name_index_build(struct zip_t *zip) {
+  mz_zip_archive *pzip = &(zip->archive);
+  mz_uint32 n = pzip->m_total_files;
+  mz_uint32 slots = 16;
+  mz_uint32 i, slot;
+  mz_uint len;
+  const char *name;
+
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING || n == 0 || n > 0x40000000) {
+    return;
+  }
+  // At most half full, so probes stay short.
+  while (slots < n * 2) {
+    slots *= 2;
+  }
+  zip->name_index = (mz_uint32 *)calloc((size_t)slots, sizeof(mz_uint32));
+  if (!zip->name_index) {
+    // Lookups fall back to miniz.
+    return;
+  }
+  zip->name_index_mask = slots - 1;
+
+  // In central directory order, so a name that's in there twice is found at
+  // its first index, like a linear search would.
+  for (i = 0; i < n; i++) {
+    name = zip_central_dir_name(pzip->m_pState, i, &len);
+    slot = zip_name_hash(name, len) & zip->name_index_mask;
+    while (zip->name_index[slot]) {
+      slot = (slot + 1) & zip->name_index_mask;
+    }
+    zip->name_index[slot] = i + 1;
+  }
+}
+
+static ssize_t zip_name_index_find(struct zip_t *zip, const char *entryname,
+                                   int case_sensitive) {
+  size_t entrylen = strlen(entryname);
+  mz_uint32 slot = zip_name_hash(entryname, entrylen) & zip->name_index_mask;
+  mz_uint32 index;
+  mz_uint len, i;
+  const char *name;
+
+  while ((index = zip->name_index[slot]) != 0) {
+    name = zip_central_dir_name(zip->archive.m_pState, index - 1, &len);
+    if (len == entrylen) {
+      if (case_sensitive) {
+        if (memcmp(name, entryname, len) == 0) {
+          return (ssize_t)(index - 1);
+        }
+      } else {
+        for (i = 0; i < len; i++) {
+          if (MZ_TOLOWER(name[i]) != MZ_TOLOWER(entryname[i])) {
+            break;
+          }
+        }
+        if (i == len) {
+          return (ssize_t)(index - 1);
+        }
+      }
+    }
+    slot = (slot + 1) & zip->name_index_mask;
+  }
+  return -1;
+}
+
+static void zip_entry_iter_free(struct zip_t *zip) {
+  if (zip->entry.iter) {
+    mz_zip_reader_extract_iter_free(zip->entry.iter);
+    zip->entry.iter = NULL;
+  }
+}
+
 struct zip_t *zip_open(const char *zipname, int level, char mode) {
   int errnum = 0;
   return zip_openwitherror(zipname, level, mode, &errnum);
@@ -990,6 +1408,7 @@ struct zip_t *zip_openwitherror(const char *zipname, int level, char mode,
       *errnum = ZIP_ERINIT;
       goto cleanup;
     }
+    zip_name_index_build(zip);
     break;
 
   case 'a':
@@ -1039,9 +1458,11 @@ void zip_close(struct zip_t *zip) {
       mz_zip_writer_end(pZip);
     }
     if (pZip->m_zip_mode == MZ_ZIP_MODE_READING) {
+      zip_entry_iter_free(zip);
       mz_zip_reader_end(pZip);
     }
 
+    CLEANUP(zip->name_index);
     CLEANUP(zip);
   }
 }
@@ -1088,15 +1509,21 @@ static int _zip_entry_open(struct zip_t *zip, const char *entryname,
 
   pzip = &(zip->archive);
   if (pzip->m_zip_mode == MZ_ZIP_MODE_READING) {
+    zip_entry_iter_free(zip);
     zip->entry.name = zip_strclone(entryname, entrylen);
     if (!zip->entry.name) {
       // Cannot parse zip entry name
       return ZIP_EINVENTNAME;
     }
 
-    zip->entry.index = (ssize_t)mz_zip_reader_locate_file(
-        pzip, zip->entry.name, NULL,
-        case_sensitive ? MZ_ZIP_FLAG_CASE_SENSITIVE : 0);
+    if (zip->name_index) {
+      zip->entry.index =
+          zip_name_index_find(zip, zip->entry.name, case_sensitive);
+    } else {
+      zip->entry.index = (ssize_t)mz_zip_reader_locate_file(
+          pzip, zip->entry.name, NULL,
+          case_sensitive ? MZ_ZIP_FLAG_CASE_SENSITIVE : 0);
+    }
     if (zip->entry.index < (ssize_t)0) {
       err = ZIP_ENOENT;
       goto cleanup;
@@ -1304,6 +1731,7 @@ int zip_entry_openbyindex(struct zip_t *zip, size_t index) {
   if (zip->entry.name) {
     CLEANUP(zip->entry.name);
   }
+  zip_entry_iter_free(zip);
 
   zip->entry.name = zip_strclone(pFilename, namelen);
   if (!zip->entry.name) {
@@ -1419,6 +1847,7 @@ int zip_entry_close(struct zip_t *zip) {
 
 cleanup:
   if (zip) {
+    zip_entry_iter_free(zip);
     zip->entry.m_time = 0;
     zip->entry.index = -1;
     CLEANUP(zip->entry.name);
@@ -1639,6 +2068,134 @@ ssize_t zip_entry_noallocread(struct zip_t *zip, void *buf, size_t bufsize) {
   return (ssize_t)zip->entry.uncomp_size;
 }
 
+ssize_t zip_entry_readchunk(struct zip_t *zip, void *buf, size_t bufsize) {
+  mz_zip_archive *pzip = NULL;
+  mz_zip_reader_extract_iter_state *iter = NULL;
+  size_t n;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  if (!buf || bufsize == 0) {
+    return (ssize_t)ZIP_ECAPSIZE;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return (ssize_t)ZIP_ENOENT;
+  }
+
+  if (!zip->entry.iter) {
+    if (mz_zip_reader_is_file_a_directory(pzip, (mz_uint)zip->entry.index)) {
+      // the entry is a directory
+      return (ssize_t)ZIP_EINVENTTYPE;
+    }
+    zip->entry.iter =
+        mz_zip_reader_extract_iter_new(pzip, (mz_uint)zip->entry.index, 0);
+    if (!zip->entry.iter) {
+      return (ssize_t)ZIP_ERINIT;
+    }
+  }
+
+  iter = zip->entry.iter;
+  if (bufsize > (size_t)((size_t)-1 >> 1)) {
+    bufsize = (size_t)-1 >> 1;
+  }
+  n = mz_zip_reader_extract_iter_read(iter, buf, bufsize);
+  if (iter->status < TINFL_STATUS_DONE) {
+    return (ssize_t)ZIP_EINFLATE;
+  }
+
+  if (iter->out_buf_ofs == iter->file_stat.m_uncomp_size) {
+#ifndef MINIZ_DISABLE_ZIP_READER_CRC32_CHECKS
+    // all of it has been handed out, so the crc can be checked now rather
+    // than when the entry gets closed
+    if (iter->file_crc32 != iter->file_stat.m_crc32) {
+      return (ssize_t)ZIP_ECRC;
+    }
+#endif
+  } else if (n == 0) {
+    // the data ran out before the entry did
+    return (ssize_t)ZIP_EINFLATE;
+  }
+
+  return (ssize_t)n;
+}
+
+ssize_t zip_entry_noallocptr(struct zip_t *zip, const void **buf,
+                             int check_crc) {
+  mz_zip_archive *pzip = NULL;
+  mz_zip_internal_state *pState = NULL;
+  const mz_uint8 *mem = NULL;
+  const mz_uint8 *header = NULL;
+  mz_uint16 bit_flag;
+  mz_uint64 data_ofs;
+
+  if (!zip || !buf) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return (ssize_t)ZIP_ENOENT;
+  }
+
+  pState = pzip->m_pState;
+  if (pzip->m_zip_type != MZ_ZIP_TYPE_MEMORY || !pState->m_pMem ||
+      zip->entry.method != 0 ||
+      zip->entry.comp_size != zip->entry.uncomp_size) {
+    // only stored entries of an archive opened with zip_stream_open can be
+    // handed out as they are
+    return (ssize_t)ZIP_ENOTSTORED;
+  }
+
+  header = &MZ_ZIP_ARRAY_ELEMENT(
+      &pState->m_central_dir, mz_uint8,
+      MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32,
+                           (mz_uint32)zip->entry.index));
+  bit_flag = MZ_READ_LE16(header + MZ_ZIP_CDH_BIT_FLAG_OFS);
+  if (bit_flag & (MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_IS_ENCRYPTED |
+                  MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_USES_STRONG_ENCRYPTION)) {
+    return (ssize_t)ZIP_ENOTSTORED;
+  }
+
+  // the data starts after the local header, whose name and extra field
+  // lengths don't have to match the central directory
+  mem = (const mz_uint8 *)pState->m_pMem;
+  if (zip->entry.header_offset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE >
+      pzip->m_archive_size) {
+    return (ssize_t)ZIP_ENOHDR;
+  }
+  header = mem + zip->entry.header_offset;
+  if (MZ_READ_LE32(header) != MZ_ZIP_LOCAL_DIR_HEADER_SIG) {
+    return (ssize_t)ZIP_ENOHDR;
+  }
+  data_ofs = zip->entry.header_offset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE +
+             MZ_READ_LE16(header + MZ_ZIP_LDH_FILENAME_LEN_OFS) +
+             MZ_READ_LE16(header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
+  if (data_ofs > pzip->m_archive_size ||
+      zip->entry.uncomp_size > pzip->m_archive_size - data_ofs ||
+      zip->entry.uncomp_size > (mz_uint64)((size_t)-1 >> 1)) {
+    return (ssize_t)ZIP_ENOHDR;
+  }
+
+  if (check_crc &&
+      mz_crc32(MZ_CRC32_INIT, mem + data_ofs,
+               (size_t)zip->entry.uncomp_size) != zip->entry.uncomp_crc32) {
+    return (ssize_t)ZIP_ECRC;
+  }
+
+  *buf = mem + data_ofs;
+  return (ssize_t)zip->entry.uncomp_size;
+}
+
 int zip_entry_fread(struct zip_t *zip, const char *filename) {
   mz_zip_archive *pzip = NULL;
   mz_uint idx;
@@ -1794,6 +2351,15 @@ ssize_t zip_entries_deletebyindex(struct zip_t *zip, size_t entries[],
 int zip_stream_extract(const char *stream, size_t size, const char *dir,
                        int (*on_extract)(const char *filename, void *arg),
                        void *arg) {
+  return zip_stream_extract_parallel(stream, size, dir, 1, 0, on_extract, arg);
+}
+
+int zip_stream_extract_parallel(const char *stream, size_t size,
+                                const char *dir, int threads,
+                                size_t max_memory,
+                                int (*on_extract)(const char *filename,
+                                                  void *arg),
+                                void *arg) {
   mz_zip_archive zip_archive;
   if (!stream || !dir) {
     // Cannot parse zip archive stream
@@ -1808,7 +2374,8 @@ int zip_stream_extract(const char *stream, size_t size, const char *dir,
     return ZIP_ENOINIT;
   }
 
-  return zip_archive_extract(&zip_archive, dir, on_extract, arg);
+  return zip_archive_extract(&zip_archive, dir, threads, max_memory,
+                             on_extract, arg);
 }
 
 struct zip_t *zip_stream_open(const char *stream, size_t size, int level,
@@ -1841,6 +2408,7 @@ struct zip_t *zip_stream_openwitherror(const char *stream, size_t size,
       *errnum = ZIP_ERINIT;
       goto cleanup;
     }
+    zip_name_index_build(zip);
   } else if ((stream == NULL) && (size == 0) && (mode == 'w')) {
     // Create a new archive.
     if (!mz_zip_writer_init_heap(&(zip->archive), 0, 1024)) {
@@ -1882,8 +2450,10 @@ ssize_t zip_stream_copy(struct zip_t *zip, void **buf, size_t *bufsize) {
 
 void zip_stream_close(struct zip_t *zip) {
   if (zip) {
+    zip_entry_iter_free(zip);
     mz_zip_writer_end(&(zip->archive));
     mz_zip_reader_end(&(zip->archive));
+    CLEANUP(zip->name_index);
     CLEANUP(zip);
   }
 }
@@ -1939,6 +2509,7 @@ struct zip_t *zip_cstream_openwitherror(FILE *stream, int level, char mode,
       *errnum = ZIP_ERINIT;
       goto cleanup;
     }
+    zip_name_index_build(zip);
     break;
 
   case 'a':
@@ -2059,6 +2630,13 @@ int zip_create(const char *zipname, const char *filenames[], size_t len) {
 
 int zip_extract(const char *zipname, const char *dir,
                 int (*on_extract)(const char *filename, void *arg), void *arg) {
+  return zip_extract_parallel(zipname, dir, 1, 0, on_extract, arg);
+}
+
+int zip_extract_parallel(const char *zipname, const char *dir, int threads,
+                         size_t max_memory,
+                         int (*on_extract)(const char *filename, void *arg),
+                         void *arg) {
   mz_zip_archive zip_archive;
 
   if (!zipname || !dir) {
@@ -2077,5 +2655,6 @@ int zip_extract(const char *zipname, const char *dir,
     return ZIP_ENOINIT;
   }
 
-  return zip_archive_extract(&zip_archive, dir, on_extract, arg);
+  return zip_archive_extract(&zip_archive, dir, threads, max_memory,
+                             on_extract, arg);
 }
\ No newline at end of file
@@ -98,6 +98,8 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_InArena 1024 /* node and its strings belong to a cJSON_Arena */
+#define cJSON_InSitu 2048 /* node's strings point into the buffer it was parsed from */
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -120,6 +122,10 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Hash index of a big object's members, built by GetObjectItem on demand. Only the cJSON functions keep it
+     * in step with the member list, so if you link items by hand call cJSON_InvalidateIndex afterwards. */
+    struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -137,6 +143,12 @@ typedef int cJSON_bool;
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* Objects whose lookups walk at least this many members get a hash index, so later lookups are O(1).
+ * Building it changes the object, so lookups on one shared object from several threads need a lock. */
+#ifndef CJSON_INDEX_THRESHOLD
+#define CJSON_INDEX_THRESHOLD 16
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
@@ -151,6 +163,36 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Streaming parse: feed the JSON in chunks as it arrives (e.g. from a curl write callback), then call cJSON_StreamFinish for the tree.
+ * Only the string or number being read is buffered, never the whole document. Feed returns false once the input is known to be bad,
+ * Finish returns NULL if the document is bad or incomplete. Anything after the root value is ignored, like cJSON_Parse does.
+ * The caller owns the tree Finish returns, and must still free the stream with cJSON_DeleteStream. */
+typedef struct cJSON_Stream cJSON_Stream;
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(void);
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFeed(cJSON_Stream *stream, const char *data, size_t length);
+CJSON_PUBLIC(cJSON *) cJSON_StreamFinish(cJSON_Stream *stream);
+/* Bytes accepted before the stream went bad. */
+CJSON_PUBLIC(size_t) cJSON_StreamErrorOffset(const cJSON_Stream *stream);
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream);
+
+/* Arena documents: every node and string of the parse comes from the arena, so freeing the document is one
+ * cJSON_ResetArena (keep the memory for the next one) or cJSON_DeleteArena, not a free per node. size is the
+ * block size (0 for the default); a reset after a document that outgrew it makes the next block big enough.
+ * Arena items can be read, edited and moved like any others, and cJSON_Delete on them frees nothing but heap
+ * items added to them. Heap items still attached when the arena is reset are leaked, detach them first. */
+typedef struct cJSON_Arena cJSON_Arena;
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t size);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value, size_t buffer_length);
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStreamInArena(cJSON_Arena *arena);
+/* Bytes handed out since the last reset. */
+CJSON_PUBLIC(size_t) cJSON_ArenaUsed(const cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena);
+
+/* In-situ parse: strings are unescaped where they are in value (which gets overwritten) and the items point at
+ * them instead of at copies, so only the nodes are allocated. value has to outlive the result, and is garbage
+ * afterwards whether the parse worked or not. cJSON_Delete the result as usual (before freeing value). */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -161,6 +203,41 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
 /* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
+
+/* Streaming writer: JSON is written straight into the caller's buffer as you go, no tree and no allocations.
+ * Whenever the buffer fills up it is handed to flush(context, data, length), so it can be small; without a flush
+ * the whole document has to fit (plus its '\0', added by cJSON_WriterFinish) and used is its length.
+ * Write keys only inside objects, each followed by one value. Anything out of place, or a failed flush, fails
+ * the writer for good and the rest of the calls do nothing. Unformatted output, numbers as cJSON_Print does. */
+typedef cJSON_bool (*cJSON_WriterFlush)(void *context, const char *data, size_t length);
+typedef struct cJSON_Writer
+{
+    char *buffer;
+    size_t size;
+    size_t used; /* bytes in buffer not flushed yet */
+    size_t flushed;
+    cJSON_WriterFlush flush;
+    void *context;
+    size_t depth;
+    unsigned long objects; /* bit per depth: 1 is an object, 0 an array */
+    unsigned long filled; /* bit per depth: something was written at it already */
+    cJSON_bool after_key;
+    cJSON_bool failed;
+} cJSON_Writer;
+CJSON_PUBLIC(void) cJSON_InitWriter(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *context);
+/* flush for writing to a file, pass the FILE* as context. */
+CJSON_PUBLIC(cJSON_bool) cJSON_FlushToFile(void *file, const char *data, size_t length);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteStartObject(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteEndObject(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteStartArray(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteEndArray(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteKey(cJSON_Writer *writer, const char *key);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteString(cJSON_Writer *writer, const char *string);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNumber(cJSON_Writer *writer, double number);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteBool(cJSON_Writer *writer, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNull(cJSON_Writer *writer);
+/* Checks the document is complete and flushes the rest. false if anything went wrong along the way. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterFinish(cJSON_Writer *writer);
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
@@ -172,6 +249,8 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Drops an object's member index, after changing its members without the cJSON functions. */
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *object);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
@@ -0,0 +1,34 @@
+#ifndef JSONBIND_H
+#define JSONBIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cJSON.h"
+
+#define JSONBIND_MAX_FIELDS 32  // Per table, so "seen" fits in one bitmask.
+
+// What a field is in C. The JSON value has to match or it's an error.
+typedef enum {
+    JSONBIND_INT,       // int. JSON number, must be whole and fit.
+    JSONBIND_INT64,     // long long. JSON number, must be whole (ms timestamps and such).
+    JSONBIND_FLOAT,     // float. JSON number.
+    JSONBIND_DOUBLE,    // double. JSON number.
+    JSONBIND_BOOL,      // bool. JSON true/false.
+    JSONBIND_STRING     // char*, a malloc'd copy (free it). JSON string.
+} jsonbind_type_t;
+
+// One field of a struct, and the key it comes from.
+typedef struct {
+    const char* name;       // JSON key (case sensitive).
+    jsonbind_type_t type;
+    size_t offset;          // offsetof the member.
+    bool required;          // Missing = error. Otherwise the member is left alone.
+} jsonbind_field_t;
+
+// Field whose JSON key is the member's name.
+#define JSONBIND_FIELD(structType, member, type, required) { #member, type, offsetof(structType, member), required }
+
+bool JsonBind_Object(const cJSON* object, const jsonbind_field_t* fields, size_t count, void* out, char* errText, size_t errSize);
+
+#endif
@@ -2,26 +2,55 @@
 #define NETWORKING_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
-#define API_BASE "https://ponyguessr.com/api"
+#define API_BASE "https://ponyguessr.com/api"   // Default API location.
+#define API_BASE_ENV "PONII_API_BASE"            // Environment variable that overrides it (host build).
+#define API_BASE_FILE "sd:/ponii/api.txt"        // Or a file on the SD with the base URL on the first line.
 
 struct MemoryStruct {
     char *memory;
     size_t size;
+    size_t capacity; // Bytes allocated for memory.
 };
 
 typedef struct {
     int season;
     int episode;
     float seekTime;
-    int expiryTs;
+    long long expiryTs;     // ms timestamp.
     bool correct;
 } response_t;
 
+// A networking session. Keeps one curl handle (and its connection) alive between requests.
+typedef struct netsession_s netsession_t;
+
+// What the network is up to, for the wait screen.
+typedef struct {
+    const char* stage;      // What the newest request is doing, NULL if nothing is downloading.
+    size_t bytesNow;        // Bytes received, all sessions added up.
+    size_t bytesTotal;      // Bytes expected (0 if the server didn't say).
+    int transfers;          // Requests running.
+} netprogress_t;
+
 void Networking_Init();
+netsession_t* Networking_CreateSession();
+void Networking_DestroySession(netsession_t* session);
+void Networking_SetApiBase(const char* url);
+const char* Networking_GetApiBase();
+netprogress_t Networking_GetProgress();
+void Networking_DrawWaitFrame(const char* text);
+bool Networking_RunBlocking(const char* text, bool (*func)(void* arg), void* arg);
+
+// Quiet versions of the API calls. No wait screen, errors are returned instead of shown.
+char* Networking_GetImageId(netsession_t* session, char* errText, size_t errSize);
+bool Networking_DownloadFrame(netsession_t* session, const char* iid, struct MemoryStruct* frame, char* errText, size_t errSize);
+bool Networking_CheckAnswer(netsession_t* session, int season, int episode, const char* iid, response_t* response, char* errText, size_t errSize);
 
 char *get_image_id(); // Obtain an Image ID.
-void downloadImage(char* iid); // Download image with specified IID.
+void downloadImage(char* iid, struct MemoryStruct* frame); // Download image with specified IID into memory.
+void Networking_SetFrameCache(const char* path);
+void Networking_CacheFrame(const struct MemoryStruct* frame);
 response_t checkCorrect(int season, int episode, char* iid);
 
 #endif
\ No newline at end of file
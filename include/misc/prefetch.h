@@ -0,0 +1,40 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <grrlib.h>
+
+#include "misc/roundpack.h"
+
+// Defaults.
+#define PREFETCH_DEFAULT_DEPTH 2    // Ready rounds kept in the queue.
+#define PREFETCH_DEFAULT_THREADS 1  // Rounds fetched at the same time.
+#define PREFETCH_MAX_THREADS 4
+
+// A round that's ready to play.
+typedef struct {
+    char* iid;              // Image ID, needed for checkCorrect.
+    GRRLIB_texImg* frame;   // Decoded pony frame.
+    size_t pngSize;         // Size of the PNG that was downloaded.
+    bool offline;           // Came from a round pack. answer is filled in.
+    packentry_t answer;     // The correct answer (offline rounds only).
+} round_t;
+
+// Prefetch settings.
+typedef struct {
+    int queueDepth;     // How many ready rounds to keep around.
+    int fetchThreads;   // How many rounds get fetched at once.
+    roundpack_t* pack;  // Play from this round pack instead of the network (optional).
+    bool verifyFrames;  // CRC check pack frames before decoding them.
+} prefetch_config_t;
+
+prefetch_config_t Prefetch_DefaultConfig();
+void Prefetch_Start(prefetch_config_t config);
+int  Prefetch_Ready();
+bool Prefetch_TryPop(round_t* round);
+bool Prefetch_Pop(round_t* round, char* errText, size_t errSize);
+void Prefetch_FreeRound(round_t* round);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef ROUNDPACK_H
+#define ROUNDPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "misc/networking.h"
+
+/*
+Round pack layout (a normal zip, frames stored without compression):
+    index.bin           - ROUNDPACK_HEADER_SIZE byte header, then one record per round.
+    frames/{iid}.png    - The frame for each round.
+
+index.bin (all numbers big endian):
+    0   char[4]  magic "PGRP"
+    4   u16      version
+    6   u16      record size
+    8   u32      round count
+    12  records:
+        0   char[40] iid (NUL padded)
+        40  u16      season
+        42  u16      episode
+        44  f32      seekTime (IEEE bits)
+*/
+#define ROUNDPACK_MAGIC "PGRP"
+#define ROUNDPACK_VERSION 1
+#define ROUNDPACK_HEADER_SIZE 12
+#define ROUNDPACK_RECORD_SIZE 48
+#define ROUNDPACK_IID_SIZE 40
+#define ROUNDPACK_INDEX_NAME "index.bin"
+#define ROUNDPACK_FRAME_FMT "frames/%s.png"
+
+// Packs up to this size get loaded into RAM and read with zip_stream_open, bigger ones are read from the file.
+#define ROUNDPACK_MAX_INMEMORY (16*1024*1024)
+
+// One round in a pack.
+typedef struct {
+    char iid[ROUNDPACK_IID_SIZE];
+    int season;
+    int episode;
+    float seekTime;
+} packentry_t;
+
+typedef struct roundpack_s roundpack_t;
+
+roundpack_t*        RoundPack_Open(const char* path, char* errText, size_t errSize);
+void                RoundPack_Close(roundpack_t* pack);
+int                 RoundPack_Count(roundpack_t* pack);
+const packentry_t*  RoundPack_Entry(roundpack_t* pack, int index);
+bool                RoundPack_ReadFrame(roundpack_t* pack, int index, struct MemoryStruct* png);
+bool                RoundPack_MapFrame(roundpack_t* pack, int index, bool verify, const void** data, size_t* size);
+response_t          RoundPack_Check(const packentry_t* entry, int season, int episode);
+
+void RoundPack_EncodeHeader(unsigned char* out, unsigned int count);
+void RoundPack_EncodeEntry(unsigned char* out, const packentry_t* entry);
+
+#endif
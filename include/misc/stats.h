@@ -0,0 +1,18 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+
+// Saved after every round so it survives a power off.
+typedef struct {
+    int rounds;         // Rounds answered.
+    int correct;        // Of those, right.
+    int streak;         // Right in a row, right now.
+    int bestStreak;
+} stats_t;
+
+void Stats_Load(const char* path, stats_t* stats);
+bool Stats_Save(const char* path, const stats_t* stats);
+void Stats_AddRound(stats_t* stats, bool correct);
+
+#endif
@@ -0,0 +1,26 @@
+// assets.h - (C)2024 Dakota Thorpe.
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stddef.h>
+#include <gctypes.h>
+#include <grrlib.h>
+
+#define ASSETS_MAX 32 // Max distinct assets in the cache.
+
+// Cache stats.
+typedef struct {
+    int textures;           // Decoded textures in the cache.
+    int fonts;              // Loaded fonts in the cache.
+    int inUse;              // Assets with at least one reference.
+    size_t textureBytes;    // Texture memory used by cached textures.
+} assetstats_t;
+
+GRRLIB_texImg*  Assets_GetTexture(const u8* data);
+GRRLIB_ttfFont* Assets_GetFont(const u8* data, s32 size);
+void            Assets_Release(const void* handle);
+void            Assets_Trim();
+assetstats_t    Assets_GetStats();
+size_t          Assets_MemoryUsage();
+
+#endif
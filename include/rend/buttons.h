@@ -89,12 +89,32 @@ typedef struct
     int h;
 } spritedbtn_assets_t;
 
+// Pre-rendered button label.
+/**
+ * @param texture The label drawn into a texture (NULL for empty labels).
+ * @param width Width of the text in pixels.
+ * @param str Copy of the string it was rendered from.
+ * @param font Font it was rendered with.
+ * @param fontSize Font size it was rendered at.
+ * @param color Text color it was rendered with.
+*/
+typedef struct
+{
+    GRRLIB_texImg* texture;
+    int width;
+    char* str;
+    GRRLIB_ttfFont* font;
+    int fontSize;
+    u32 color;
+} spritedbtn_label_t;
+
 // Customizable button.
 /**
  * @param pnt The point where the button is placed at.
  * @param settings The settings of the button.
  * @param assets The buttons required assets.
  * @param str The string to be put in the button.
+ * @param label Cached label, re-rendered only when str, the font, fontSize or textColor change.
 */
 typedef struct
 {
@@ -102,6 +122,7 @@ typedef struct
     spritedbtn_options_t settings;  // Button settings
     spritedbtn_assets_t assets;     // Button assets.
     char* str;
+    spritedbtn_label_t label;       // Label cache.
 } spritedbtn_t;
 
 // Functions.
@@ -110,7 +131,9 @@ spritedbtn_assets_t     GetStdBtnAssets(u32 bgColor, u32 txtColor, GRRLIB_ttfFon
 spritedbtn_options_t    GetStdBtnOptions(void (*clickFunction)(int, char**), void (*hoverFunction)(int, char**), int fontSize);
 Size                    GetButtonSize(spritedbtn_t btn);
 
-void renderSpritedButton(spritedbtn_t btn);
+void DestroyButton(spritedbtn_t* btn);
+
+void renderSpritedButton(spritedbtn_t* btn);
 void checkButtonStatus(spritedbtn_t* btn, int mx, int my, Size cSize, s32 pressed);
 
 char* tf_s(bool i); // Returns a bool as a string.
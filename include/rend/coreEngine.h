@@ -1,9 +1,14 @@
 #ifndef COREENGINE_H
 #define COREENGINE_H
 
+#include <grrlib.h>
+
 #define THREAD_SLEEP_TIME 30
 
 void CoreEngine_Init();
+void CoreEngine_Render();
+void CoreEngine_ScanPads();
 void showErrorScreen(char* errorText);
+GRRLIB_texImg* CoreEngine_LoadPNG(const void* pngData);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+// framearena.h - (C)2024 Dakota Thorpe.
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <stddef.h>
+
+#define FRAMEARENA_SIZE (16 * 1024) // Bytes of scratch per frame.
+
+// One frame's worth of arena use.
+typedef struct {
+    size_t used;                // Bytes handed out.
+    unsigned int allocs;        // Allocations.
+    unsigned int heapFallbacks; // Allocations that didn't fit and hit malloc.
+} framearenaframe_t;
+
+// Arena counters.
+typedef struct {
+    size_t used;                // Bytes handed out this frame.
+    size_t peak;                // Most bytes used in any one frame.
+    unsigned int allocs;        // Allocations this frame.
+    unsigned int heapFallbacks; // Allocations this frame that didn't fit and hit malloc.
+    unsigned int totalHeapFallbacks;
+    unsigned int frames;        // Frames since startup.
+    framearenaframe_t lastFrame; // The last whole frame, as it was at FrameArena_Reset.
+} framearenastats_t;
+
+void* FrameArena_Alloc(size_t size);
+char* FrameArena_Printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void FrameArena_Reset();
+framearenastats_t FrameArena_GetStats();
+
+#endif
@@ -0,0 +1,76 @@
+// glyphatlas.h - (C)2024 Dakota Thorpe.
+// Platform neutral glyph atlas: packing, glyph lookup and text layout.
+// No Wii stuff in here, the renderer plugs in through glyphsource_t.
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GLYPHATLAS_PADDING 1 // Empty pixels between glyphs, stops filtering bleed.
+
+// Glyph states.
+#define GLYPH_EMPTY 0       // Unused hash slot.
+#define GLYPH_METRICS 1     // Metrics known, not rasterised yet.
+#define GLYPH_PACKED 2      // In the atlas.
+#define GLYPH_MISSING 3     // The font doesn't have it.
+
+// One glyph.
+typedef struct {
+    uint32_t codepoint;
+    uint32_t glyphIndex;    // Font specific index, passed back for kerning.
+    int16_t bearingX;       // Pen to left edge of the bitmap.
+    int16_t bearingY;       // Baseline to top edge of the bitmap.
+    int16_t width;          // Bitmap size.
+    int16_t height;
+    int16_t advance;        // Pen advance.
+    int16_t atlasX;         // Where the bitmap is in the atlas (GLYPH_PACKED only).
+    int16_t atlasY;
+    uint8_t state;
+} atlasglyph_t;
+
+// Where glyphs come from (FreeType on the Wii, anything in a test).
+typedef struct {
+    void* ctx;
+    // Fills glyphIndex, bearings, size and advance. Returns false if the font doesn't have it.
+    bool (*metrics)(void* ctx, uint32_t codepoint, atlasglyph_t* glyph);
+    // Draws the glyph's width x height 8 bit coverage into dst.
+    bool (*rasterize)(void* ctx, const atlasglyph_t* glyph, uint8_t* dst, int pitch);
+    // Kerning between two glyph indexes in pixels. Can be NULL.
+    int (*kerning)(void* ctx, uint32_t leftIndex, uint32_t rightIndex);
+} glyphsource_t;
+
+// A textured quad for one glyph, in screen and texture (0-1) coordinates.
+typedef struct {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+} glyphquad_t;
+
+// The atlas.
+typedef struct {
+    int width, height;
+    uint8_t* pixels;                    // 8 bit coverage, width*height.
+    int shelfX, shelfY, shelfHeight;    // Shelf packer state.
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1; // Changed area since the last upload.
+    atlasglyph_t* glyphs;               // Open addressing table keyed by codepoint.
+    int glyphCapacity;
+    int glyphCount;
+    unsigned int resets;                // Times the atlas filled up and was cleared.
+    glyphsource_t source;
+} glyphatlas_t;
+
+bool GlyphAtlas_Init(glyphatlas_t* atlas, int width, int height, glyphsource_t source);
+void GlyphAtlas_Free(glyphatlas_t* atlas);
+void GlyphAtlas_Reset(glyphatlas_t* atlas);
+
+const atlasglyph_t* GlyphAtlas_GetMetrics(glyphatlas_t* atlas, uint32_t codepoint);
+const atlasglyph_t* GlyphAtlas_GetGlyph(glyphatlas_t* atlas, uint32_t codepoint);
+
+int  GlyphAtlas_Measure(glyphatlas_t* atlas, const char* utf8);
+int  GlyphAtlas_Layout(glyphatlas_t* atlas, const char* utf8, float x, float y, int baseline, glyphquad_t* quads, int maxQuads, int* width);
+bool GlyphAtlas_TakeDirty(glyphatlas_t* atlas, int* x, int* y, int* w, int* h);
+
+uint32_t GlyphAtlas_DecodeUTF8(const char** str);
+int      GlyphAtlas_EncodeUTF8(uint32_t codepoint, char* out);
+
+#endif
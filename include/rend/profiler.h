@@ -0,0 +1,43 @@
+// profiler.h - (C)2024 Dakota Thorpe.
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PROFILER_MAX_SAMPLES 4096   // Ring buffer of timed scopes.
+#define PROFILER_FRAMES 120         // Frame times kept for the graph.
+#define PROFILER_TOP_SCOPES 6       // Scopes listed on the overlay.
+#define PROFILER_TRACE_PATH "sd:/ponii/trace.json"
+
+// One timed scope. Times are microseconds since the profiler started.
+typedef struct {
+    const char* name;       // Must be a string literal (compared by pointer).
+    uint64_t start;
+    uint64_t end;           // 0 while the scope is still open.
+    uint32_t seq;
+    uint32_t thread;
+} profsample_t;
+
+// Handle for an open scope.
+typedef uint32_t profscope_t;
+
+uint64_t Profiler_Now();
+profscope_t Profiler_Begin(const char* name);
+void Profiler_End(profscope_t scope);
+void Profiler_EndScope(profscope_t* scope);
+void Profiler_FrameMark();
+float Profiler_LastFrameMs();
+
+void Profiler_SetOverlay(bool visible);
+bool Profiler_OverlayVisible();
+void Profiler_DrawOverlay();
+bool Profiler_DumpTrace(const char* path);
+
+// Times the rest of the enclosing block.
+#define PROFILE_SCOPE(name) profscope_t __profScope __attribute__((cleanup(Profiler_EndScope))) = Profiler_Begin(name)
+
+// Times one statement.
+#define PROFILE_CALL(name, call) do { profscope_t __profCall = Profiler_Begin(name); call; Profiler_End(__profCall); } while(0)
+
+#endif
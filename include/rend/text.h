@@ -0,0 +1,14 @@
+// text.h - (C)2024 Dakota Thorpe.
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <gctypes.h>
+#include <grrlib.h>
+
+void Text_Draw(int x, int y, GRRLIB_ttfFont* font, const char* str, unsigned int fontSize, u32 color);
+unsigned int Text_Width(GRRLIB_ttfFont* font, const char* str, unsigned int fontSize);
+bool Text_ReserveAtlas(GRRLIB_ttfFont* font, unsigned int fontSize, int width, int height);
+void Text_ForgetFont(GRRLIB_ttfFont* font);
+GRRLIB_texImg* Text_RenderToTexture(GRRLIB_ttfFont* font, const char* str, unsigned int fontSize, u32 color, int* width);
+
+#endif
@@ -61,6 +61,18 @@ typedef long ssize_t; /* byte count or error */
  */
 #define ZIP_DEFAULT_COMPRESSION_LEVEL 6
 
+/**
+ * Default cap on inflated data held in memory by the _parallel extract
+ * functions.
+ */
+#define ZIP_EXTRACT_DEFAULT_MEMORY (64 * 1024 * 1024)
+
+/**
+ * Thread count for the _parallel extract functions that picks one inflating
+ * thread per CPU online when the extract starts.
+ */
+#define ZIP_EXTRACT_AUTO_THREADS 0
+
 /**
  * Error codes
  */
@@ -96,6 +108,9 @@ typedef long ssize_t; /* byte count or error */
 #define ZIP_ERINIT -30      // cannot initialize reader
 #define ZIP_EWINIT -31      // cannot initialize writer
 #define ZIP_EWRINIT -32     // cannot initialize writer from reader
+#define ZIP_ENOTSTORED -33  // entry is not stored in memory
+#define ZIP_ECRC -34        // crc32 mismatch
+#define ZIP_EINFLATE -35    // cannot inflate entry
 
 /**
  * Looks up the error message string corresponding to an error number.
@@ -363,6 +378,47 @@ extern ZIP_EXPORT ssize_t zip_entry_read(struct zip_t *zip, void **buf,
 extern ZIP_EXPORT ssize_t zip_entry_noallocread(struct zip_t *zip, void *buf,
                                                 size_t bufsize);
 
+/**
+ * Extracts the next part of the current zip entry into a memory buffer.
+ * Call it until it returns 0 to read the whole entry a chunk at a time.
+ *
+ * @param zip zip archive handler.
+ * @param buf output buffer.
+ * @param bufsize output buffer size (in bytes), any size will do.
+ *
+ * @note memory use doesn't depend on the entry size: a deflated entry needs
+ *       one 32KB dictionary, plus a read buffer of up to 64KB when the
+ *       archive is read from a file. It is freed by zip_entry_close.
+ *       The crc32 is checked when the last chunk is read.
+ *
+ * @return the return code - the number of bytes read on success, 0 once the
+ *         entry has been read completely.
+ *         Otherwise a negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_entry_readchunk(struct zip_t *zip, void *buf,
+                                              size_t bufsize);
+
+/**
+ * Points straight at the current zip entry's data inside the archive buffer,
+ * without allocating or copying anything.
+ *
+ * @param zip zip archive handler.
+ * @param buf output pointer, valid until the archive is closed.
+ * @param check_crc if non-zero, the data is checked against the entry's crc32
+ *                  first.
+ *
+ * @note only works for archives opened with zip_stream_open and entries
+ *       stored without compression (ZIP_ENOTSTORED otherwise), so callers
+ *       should fall back to zip_entry_noallocread.
+ *       The data is not NUL terminated.
+ *
+ * @return the return code - the entry size on success.
+ *         Otherwise a negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_entry_noallocptr(struct zip_t *zip,
+                                               const void **buf,
+                                               int check_crc);
+
 /**
  * Extracts the current zip entry into output file.
  *
@@ -444,6 +500,35 @@ zip_stream_extract(const char *stream, size_t size, const char *dir,
                    int (*on_extract)(const char *filename, void *arg),
                    void *arg);
 
+/**
+ * Extracts a zip archive stream into directory, inflating entries on several
+ * threads at once.
+ *
+ * Works like zip_stream_extract: files are written, and on_extract called, in
+ * archive order from the calling thread. The threads only inflate entries
+ * ahead of it into memory.
+ *
+ * @param stream zip archive stream.
+ * @param size stream size.
+ * @param dir output directory.
+ * @param threads number of inflating threads, ZIP_EXTRACT_AUTO_THREADS for one
+ *                per online CPU. 1 (or a negative number) extracts serially.
+ * @param max_memory cap on inflated data held in memory at once (in bytes), 0
+ *                   for ZIP_EXTRACT_DEFAULT_MEMORY. Entries bigger than this
+ *                   are extracted serially.
+ * @param on_extract on extract callback.
+ * @param arg opaque pointer.
+ *
+ * @note threads are only used when zip.c is built with ZIP_ENABLE_THREADS
+ *       (pthreads), otherwise this is zip_stream_extract.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_stream_extract_parallel(
+    const char *stream, size_t size, const char *dir, int threads,
+    size_t max_memory, int (*on_extract)(const char *filename, void *arg),
+    void *arg);
+
 /**
  * Opens zip archive stream into memory.
  *
@@ -576,6 +661,35 @@ extern ZIP_EXPORT int zip_extract(const char *zipname, const char *dir,
                                   int (*on_extract_entry)(const char *filename,
                                                           void *arg),
                                   void *arg);
+
+/**
+ * Extracts a zip archive file into directory, inflating entries on several
+ * threads at once.
+ *
+ * Works like zip_extract: files are written, and on_extract_entry called, in
+ * archive order from the calling thread. The threads only inflate entries
+ * ahead of it into memory.
+ *
+ * @param zipname zip archive file.
+ * @param dir output directory.
+ * @param threads number of inflating threads, ZIP_EXTRACT_AUTO_THREADS for one
+ *                per online CPU. 1 (or a negative number) extracts serially.
+ * @param max_memory cap on inflated data held in memory at once (in bytes), 0
+ *                   for ZIP_EXTRACT_DEFAULT_MEMORY. Entries bigger than this
+ *                   are extracted serially.
+ * @param on_extract_entry on extract callback.
+ * @param arg opaque pointer.
+ *
+ * @note threads are only used when zip.c is built with ZIP_ENABLE_THREADS
+ *       (pthreads), otherwise this is zip_extract.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int
+zip_extract_parallel(const char *zipname, const char *dir, int threads,
+                     size_t max_memory,
+                     int (*on_extract_entry)(const char *filename, void *arg),
+                     void *arg);
 /** @} */
 #ifdef __cplusplus
 }
@@ -0,0 +1,103 @@
+/**
+ * @file arenabench.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: parses API responses onto the heap (cJSON_Parse + cJSON_Delete) and into
+ * an arena (cJSON_ParseInArena + cJSON_ResetArena, what the networking sessions do) and
+ * prints mallocs and parse+free time for each.
+ *
+ * Usage:
+ *   build-host/arenabench [iterations]
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+#define ARENABENCH_DEFAULT_ITERATIONS 200000
+#define ARENABENCH_ARENA_SIZE 2048      // Same as NETWORKING_JSON_ARENA.
+
+// Responses recorded from tools/mockserver.py, which sends what the real API does.
+static const char* samples[] = {
+    "{\"id\": \"cd613e30-d8f1-4adf-91b7-584a2265b1f5\"}",
+    "{\"season\": 2, \"episode\": 9, \"seekTime\": 153.29431477237938, \"expiryTs\": 1792231026863, \"correct\": false}",
+    "{\"id\": \"c9e9c616-612e-4696-a6ce-cc1b78e51061\"}",
+    "{\"season\": 4, \"episode\": 4, \"seekTime\": 634.2136534813918, \"expiryTs\": 1792231026969, \"correct\": false}",
+    "{\"id\": \"c4647159-c324-4985-9b81-0e766ec9d286\"}",
+    "{\"season\": 1, \"episode\": 23, \"seekTime\": 579.0033522712419, \"expiryTs\": 1792231027074, \"correct\": false}",
+};
+#define SAMPLE_COUNT (int)(sizeof(samples) / sizeof(samples[0]))
+
+static size_t mallocs = 0;
+
+static void* countingMalloc(size_t size) {
+    mallocs++;
+    return malloc(size);
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, int parses, size_t count, double seconds) {
+    printf("%-6s %8.2f mallocs/parse %8.1f ns/parse+free\n", name, (double)count / parses, seconds / parses * 1e9);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : ARENABENCH_DEFAULT_ITERATIONS;
+    if(iterations < 1) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    cJSON_Hooks hooks = { countingMalloc, free };
+    cJSON_InitHooks(&hooks);
+
+    size_t lengths[SAMPLE_COUNT];
+    for(int i = 0; i < SAMPLE_COUNT; i++) {
+        lengths[i] = strlen(samples[i]);
+    }
+    int parses = iterations * SAMPLE_COUNT;
+    printf("%d parses of %d recorded responses\n", parses, SAMPLE_COUNT);
+
+    // Heap: every node and string is a malloc, every one freed again.
+    mallocs = 0;
+    double start = now();
+    for(int n = 0; n < iterations; n++) {
+        for(int i = 0; i < SAMPLE_COUNT; i++) {
+            cJSON* root = cJSON_ParseWithLength(samples[i], lengths[i]);
+            if(root == NULL) {
+                fprintf(stderr, "heap parse failed on sample %d\n", i);
+                return 1;
+            }
+            cJSON_Delete(root);
+        }
+    }
+    report("heap", parses, mallocs, now() - start);
+
+    // Arena: one block made up front, reset after each response.
+    mallocs = 0;
+    start = now();
+    cJSON_Arena* arena = cJSON_CreateArena(ARENABENCH_ARENA_SIZE);
+    if(arena == NULL) {
+        return 1;
+    }
+    for(int n = 0; n < iterations; n++) {
+        for(int i = 0; i < SAMPLE_COUNT; i++) {
+            if(cJSON_ParseInArena(arena, samples[i], lengths[i]) == NULL) {
+                fprintf(stderr, "arena parse failed on sample %d\n", i);
+                return 1;
+            }
+            cJSON_ResetArena(arena);
+        }
+    }
+    cJSON_DeleteArena(arena);
+    report("arena", parses, mallocs, now() - start);
+    return 0;
+}
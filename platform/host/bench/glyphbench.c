@@ -0,0 +1,394 @@
+/**
+ * @file glyphbench.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: checks the glyph atlas (shelf packing, what happens when it fills up,
+ * UTF-8 decoding, GlyphAtlas_Measure) against a made up glyph source, then times
+ * layout and runs the wait screen spinner through the real font, once in a default
+ * 512x512 atlas and once in the 1024x576 one it gets now.
+ *
+ * Usage:
+ *   build-host/glyphbench [iterations]
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "rend/glyphatlas.h"
+#include "segoe_slboot_ttf.h"
+
+#define GLYPHBENCH_DEFAULT_ITERATIONS 200000
+#define GLYPHBENCH_MISSING 0x7F         // The made up font doesn't have this one.
+#define SPINNER_START 0xE052            // Same as networking.c.
+#define SPINNER_END 0xE0CB
+#define SPINNER_SIZE 64                 // Same as NETWORKING_SPINNER_SIZE.
+#define SPINNER_ATLAS_W 1024            // Same as NETWORKING_SPINNER_ATLAS_W/H.
+#define SPINNER_ATLAS_H 576
+#define SPINNER_LAPS 3
+
+static int bad = 0;
+static unsigned int metricsCalls = 0;
+static unsigned int rasterizeCalls = 0;
+
+#define CHECK(condition, ...) do { if(!(condition)) { if(bad++ < 20) { printf(__VA_ARGS__); printf("\n"); } } } while(0)
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A made up font: sizes follow from the codepoint, and every glyph fills its box with its own value. */
+
+static uint8_t testFill(uint32_t codepoint) {
+    return (uint8_t)(codepoint % 255 + 1);
+}
+
+static bool testMetrics(void* ctx, uint32_t codepoint, atlasglyph_t* glyph) {
+    (void)ctx;
+    metricsCalls++;
+    if(codepoint == GLYPHBENCH_MISSING) {
+        return false;
+    }
+    glyph->glyphIndex = codepoint;
+    if(codepoint == ' ') {
+        glyph->advance = 4;
+        return true;
+    }
+    glyph->width = (int16_t)(3 + codepoint % 13);
+    glyph->height = (int16_t)(5 + codepoint / 13 % 11);
+    glyph->bearingX = 1;
+    glyph->bearingY = glyph->height - 2;
+    glyph->advance = glyph->width + 1;
+    return true;
+}
+
+static bool testRasterize(void* ctx, const atlasglyph_t* glyph, uint8_t* dst, int pitch) {
+    (void)ctx;
+    rasterizeCalls++;
+    for(int y = 0; y < glyph->height; y++) {
+        memset(dst + y * pitch, testFill(glyph->codepoint), glyph->width);
+    }
+    return true;
+}
+
+static int testKerning(void* ctx, uint32_t leftIndex, uint32_t rightIndex) {
+    (void)ctx;
+    return (int)((leftIndex + rightIndex) % 3) - 1;
+}
+
+static const glyphsource_t testSource = { NULL, testMetrics, testRasterize, testKerning };
+
+/* Checks. */
+
+static void checkUTF8() {
+    static const struct { const char* text; uint32_t codepoint; int length; } cases[] = {
+        { "A", 'A', 1 },
+        { "\xC3\xA9", 0xE9, 2 },
+        { "\xE2\x82\xAC", 0x20AC, 3 },
+        { "\xF0\x9F\x90\xB4", 0x1F434, 4 },
+        { "\xEE\x81\x92", SPINNER_START, 3 },
+        { "\x80", 0xFFFD, 1 },          // Stray continuation byte.
+        { "\xFF", 0xFFFD, 1 },          // Not a lead byte.
+        { "\xC3", 0xFFFD, 1 },          // Cut off by the end of the string.
+        { "\xE2\x82", 0xFFFD, 2 },
+        { "\xE2\x41", 0xFFFD, 1 },      // Cut off by ASCII, which is read next.
+        { "\xF0\x9F\x90", 0xFFFD, 3 },
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const char* at = cases[i].text;
+        uint32_t codepoint = GlyphAtlas_DecodeUTF8(&at);
+        CHECK(codepoint == cases[i].codepoint && at - cases[i].text == cases[i].length,
+            "decode case %zu: got U+%04X (%d bytes), want U+%04X (%d bytes)", i,
+            (unsigned int)codepoint, (int)(at - cases[i].text), (unsigned int)cases[i].codepoint, cases[i].length);
+    }
+
+    // Everything encodes and decodes back, taking the bytes it wrote.
+    char text[8];
+    for(uint32_t codepoint = 1; codepoint <= 0x10FFFF; codepoint++) {
+        int length = GlyphAtlas_EncodeUTF8(codepoint, text);
+        const char* at = text;
+        uint32_t back = GlyphAtlas_DecodeUTF8(&at);
+        CHECK(back == codepoint && at - text == length && text[length] == '\0',
+            "U+%04X encodes to %d bytes but decodes to U+%04X (%d bytes)", (unsigned int)codepoint, length, (unsigned int)back, (int)(at - text));
+    }
+}
+
+static void checkPacking() {
+    glyphatlas_t atlas;
+    if(!GlyphAtlas_Init(&atlas, 256, 256, testSource)) {
+        CHECK(false, "GlyphAtlas_Init failed");
+        return;
+    }
+
+    // Glyphs go left to right along a shelf, and onto a new one under it when the row is full.
+    atlasglyph_t packed[200];     // Copies, the glyph table moves when it grows.
+    int count = 0;
+    int shelfY = 0, shelfHeight = 0, nextX = 0;
+    for(uint32_t codepoint = 0x100; count < 200; codepoint++) {
+        const atlasglyph_t* glyph = GlyphAtlas_GetGlyph(&atlas, codepoint);
+        if(glyph == NULL) {
+            break;
+        }
+        int paddedW = glyph->width + GLYPHATLAS_PADDING;
+        int paddedH = glyph->height + GLYPHATLAS_PADDING;
+        if(nextX + paddedW > atlas.width) {
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+            nextX = 0;
+        }
+        CHECK(glyph->state == GLYPH_PACKED && glyph->atlasX == nextX && glyph->atlasY == shelfY,
+            "U+%04X packed at %d,%d, want %d,%d", (unsigned int)codepoint, glyph->atlasX, glyph->atlasY, nextX, shelfY);
+        nextX += paddedW;
+        if(paddedH > shelfHeight) {
+            shelfHeight = paddedH;
+        }
+        packed[count++] = *glyph;
+    }
+    CHECK(count == 200, "only %d glyphs fit a 256x256 atlas", count);
+
+    // Nothing overlaps (padding included) or sticks out, and every glyph's pixels are still its own.
+    for(int i = 0; i < count; i++) {
+        const atlasglyph_t* a = &packed[i];
+        CHECK(a->atlasX + a->width <= atlas.width && a->atlasY + a->height <= atlas.height,
+            "U+%04X sticks out of the atlas", (unsigned int)a->codepoint);
+        for(int j = i + 1; j < count; j++) {
+            const atlasglyph_t* b = &packed[j];
+            bool apart = a->atlasX + a->width + GLYPHATLAS_PADDING <= b->atlasX || b->atlasX + b->width + GLYPHATLAS_PADDING <= a->atlasX ||
+                         a->atlasY + a->height + GLYPHATLAS_PADDING <= b->atlasY || b->atlasY + b->height + GLYPHATLAS_PADDING <= a->atlasY;
+            CHECK(apart, "U+%04X and U+%04X overlap", (unsigned int)a->codepoint, (unsigned int)b->codepoint);
+        }
+        for(int y = 0; y < a->height; y++) {
+            for(int x = 0; x < a->width; x++) {
+                uint8_t pixel = atlas.pixels[(a->atlasY + y) * atlas.width + a->atlasX + x];
+                CHECK(pixel == testFill(a->codepoint), "U+%04X pixel %d,%d is %d", (unsigned int)a->codepoint, x, y, pixel);
+            }
+        }
+    }
+
+    // Blank glyphs take no room, and nothing gets rasterised twice.
+    unsigned int before = rasterizeCalls;
+    const atlasglyph_t* space = GlyphAtlas_GetGlyph(&atlas, ' ');
+    GlyphAtlas_GetGlyph(&atlas, 0x100);
+    CHECK(space != NULL && space->state == GLYPH_PACKED && rasterizeCalls == before, "space or a packed glyph got rasterised");
+    CHECK(GlyphAtlas_GetGlyph(&atlas, GLYPHBENCH_MISSING) == NULL, "a missing glyph came back");
+
+    // The quads point at the packed bitmaps.
+    glyphquad_t quads[4];
+    int n = GlyphAtlas_Layout(&atlas, "\xC4\x80\xC4\x81", 10, 20, 16, quads, 4, NULL);
+    CHECK(n == 2 && quads[0].u0 * atlas.width == packed[0].atlasX && quads[1].v0 * atlas.height == packed[1].atlasY
+        && quads[0].x1 - quads[0].x0 == packed[0].width && quads[0].y0 == 20 + 16 - packed[0].bearingY,
+        "layout quads don't match the packed glyphs");
+    GlyphAtlas_Free(&atlas);
+}
+
+static void checkFull() {
+    glyphatlas_t atlas;
+    if(!GlyphAtlas_Init(&atlas, 64, 64, testSource)) {
+        CHECK(false, "GlyphAtlas_Init failed");
+        return;
+    }
+
+    // Fill it up.
+    uint32_t codepoint = 'A';
+    while(GlyphAtlas_GetGlyph(&atlas, codepoint) != NULL) {
+        codepoint++;
+    }
+    CHECK(codepoint > 'A' + 4, "only %d glyphs fit a 64x64 atlas", (int)(codepoint - 'A'));
+    const atlasglyph_t* full = GlyphAtlas_GetMetrics(&atlas, codepoint);
+    CHECK(full != NULL && full->state == GLYPH_METRICS, "the glyph that didn't fit isn't left with its metrics");
+
+    // Layout says so, and after a reset (what Text_Draw does) it works without asking for metrics again.
+    char text[8];
+    GlyphAtlas_EncodeUTF8(codepoint, text);
+    glyphquad_t quads[4];
+    int x, y, w, h;
+    GlyphAtlas_TakeDirty(&atlas, &x, &y, &w, &h);
+    CHECK(GlyphAtlas_Layout(&atlas, text, 0, 0, 16, quads, 4, NULL) == -1, "layout on a full atlas didn't fail");
+    unsigned int metrics = metricsCalls;
+    GlyphAtlas_Reset(&atlas);
+    CHECK(atlas.resets == 1 && GlyphAtlas_Layout(&atlas, text, 0, 0, 16, quads, 4, NULL) == 1 && metricsCalls == metrics,
+        "layout after a reset failed, or fetched metrics again");
+    CHECK(GlyphAtlas_GetMetrics(&atlas, 'A')->state == GLYPH_METRICS, "a glyph from before the reset is still marked packed");
+    CHECK(GlyphAtlas_TakeDirty(&atlas, &x, &y, &w, &h) && x == 0 && y == 0 && w == atlas.width && h == atlas.height,
+        "a reset doesn't mark the whole atlas for upload");
+    GlyphAtlas_Free(&atlas);
+}
+
+static void checkMeasure() {
+    glyphatlas_t atlas;
+    if(!GlyphAtlas_Init(&atlas, 256, 256, testSource)) {
+        CHECK(false, "GlyphAtlas_Init failed");
+        return;
+    }
+
+    // Advances plus kerning, skipping what the font doesn't have, and nothing rasterised.
+    const char* text = "Hello, \x7F w\xC3\xB6rld \xE2\x82\xAC!";
+    int want = 0;
+    uint32_t previous = 0;
+    for(const char* at = text; *at;) {
+        uint32_t codepoint = GlyphAtlas_DecodeUTF8(&at);
+        atlasglyph_t glyph;
+        memset(&glyph, 0, sizeof(glyph));
+        if(!testMetrics(NULL, codepoint, &glyph)) {
+            continue;
+        }
+        if(previous) {
+            want += testKerning(NULL, previous, glyph.glyphIndex);
+        }
+        want += glyph.advance;
+        previous = glyph.glyphIndex;
+    }
+    unsigned int before = rasterizeCalls;
+    int got = GlyphAtlas_Measure(&atlas, text);
+    CHECK(got == want && rasterizeCalls == before, "GlyphAtlas_Measure gave %d, want %d (%u rasterised)", got, want, rasterizeCalls - before);
+
+    glyphquad_t quads[32];
+    int width = 0;
+    GlyphAtlas_Layout(&atlas, text, 0, 0, 16, quads, 32, &width);
+    CHECK(width == want, "GlyphAtlas_Layout width %d, GlyphAtlas_Measure %d", width, want);
+    CHECK(GlyphAtlas_Measure(&atlas, "") == 0, "an empty string has a width");
+    GlyphAtlas_Free(&atlas);
+}
+
+/* The spinner, through FreeType like text.c does it. */
+
+static bool ftMetrics(void* ctx, uint32_t codepoint, atlasglyph_t* glyph) {
+    FT_Face face = ctx;
+    FT_UInt glyphIndex = FT_Get_Char_Index(face, codepoint);
+    if(FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+    FT_Glyph_Metrics* metrics = &face->glyph->metrics;
+    glyph->glyphIndex = glyphIndex;
+    glyph->bearingX = metrics->horiBearingX >> 6;
+    glyph->bearingY = metrics->horiBearingY >> 6;
+    glyph->width = (metrics->width + 63) >> 6;
+    glyph->height = (metrics->height + 63) >> 6;
+    glyph->advance = face->glyph->advance.x >> 6;
+    return true;
+}
+
+static bool ftRasterize(void* ctx, const atlasglyph_t* glyph, uint8_t* dst, int pitch) {
+    FT_Face face = ctx;
+    rasterizeCalls++;
+    if(FT_Load_Glyph(face, glyph->glyphIndex, FT_LOAD_RENDER)) {
+        return false;
+    }
+    FT_GlyphSlot slot = face->glyph;
+    int offX = slot->bitmap_left - glyph->bearingX;
+    int offY = glyph->bearingY - slot->bitmap_top;
+    for(unsigned int row = 0; row < slot->bitmap.rows; row++) {
+        int y = (int)row + offY;
+        if(y < 0 || y >= glyph->height) continue;
+        for(unsigned int col = 0; col < slot->bitmap.width; col++) {
+            int x = (int)col + offX;
+            if(x < 0 || x >= glyph->width) continue;
+            dst[y * pitch + x] = slot->bitmap.buffer[row * slot->bitmap.pitch + col];
+        }
+    }
+    return true;
+}
+
+// Draws SPINNER_LAPS laps of the spinner the way Networking_DrawWaitFrame does (each glyph two frames).
+static void timeSpinner(FT_Face face, int width, int height) {
+    glyphatlas_t atlas;
+    glyphsource_t source = { face, ftMetrics, ftRasterize, NULL };
+    if(!GlyphAtlas_Init(&atlas, width, height, source)) {
+        CHECK(false, "GlyphAtlas_Init %dx%d failed", width, height);
+        return;
+    }
+
+    for(int lap = 0; lap < SPINNER_LAPS; lap++) {
+        unsigned int resets = atlas.resets;
+        unsigned int rasterized = rasterizeCalls;
+        size_t uploaded = 0;
+        double start = now();
+        for(float spin = SPINNER_START; spin < SPINNER_END; spin += 0.5f) {
+            char text[8];
+            glyphquad_t quad;
+            GlyphAtlas_EncodeUTF8((uint32_t)spin, text);
+            if(GlyphAtlas_Layout(&atlas, text, 0, 0, SPINNER_SIZE, &quad, 1, NULL) < 0) {
+                GlyphAtlas_Reset(&atlas);
+                GlyphAtlas_Layout(&atlas, text, 0, 0, SPINNER_SIZE, &quad, 1, NULL);
+            }
+            int x, y, w, h;
+            if(GlyphAtlas_TakeDirty(&atlas, &x, &y, &w, &h)) {
+                uploaded += (size_t)w * h * 2;   // IA8.
+            }
+        }
+        printf("spinner %4dx%-4d lap %d: %3u resets %4u rasterised %7zu KB uploaded %7.2f ms\n", width, height, lap + 1,
+            atlas.resets - resets, rasterizeCalls - rasterized, uploaded / 1024, (now() - start) * 1e3);
+    }
+    if(width == SPINNER_ATLAS_W && height == SPINNER_ATLAS_H) {
+        CHECK(atlas.resets == 0, "the spinner doesn't fit its %dx%d atlas", width, height);
+    }
+    GlyphAtlas_Free(&atlas);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : GLYPHBENCH_DEFAULT_ITERATIONS;
+    if(iterations < 1) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    checkUTF8();
+    checkPacking();
+    checkFull();
+    checkMeasure();
+    if(bad) {
+        printf("%d failed checks\n", bad);
+        return 1;
+    }
+    printf("UTF-8, shelf packing, full atlas and measure checks pass\n");
+
+    // Warm atlas, so this is just lookups and quads.
+    glyphatlas_t atlas;
+    if(!GlyphAtlas_Init(&atlas, 256, 256, testSource)) {
+        return 1;
+    }
+    const char* text = "You guessed: S4E12. Is this your final answer?";
+    int glyphs = (int)strlen(text);
+    glyphquad_t quads[64];
+    volatile int sink = 0;  // Keeps the loops from being thrown away.
+    GlyphAtlas_Layout(&atlas, text, 0, 0, 16, quads, 64, NULL);
+
+    double start = now();
+    for(int i = 0; i < iterations; i++) {
+        sink += GlyphAtlas_Layout(&atlas, text, 0, 0, 16, quads, 64, NULL);
+    }
+    printf("GlyphAtlas_Layout  %6.1f ns/glyph\n", (now() - start) / iterations / glyphs * 1e9);
+
+    start = now();
+    for(int i = 0; i < iterations; i++) {
+        sink += GlyphAtlas_Measure(&atlas, text);
+    }
+    printf("GlyphAtlas_Measure %6.1f ns/glyph\n", (now() - start) / iterations / glyphs * 1e9);
+    GlyphAtlas_Free(&atlas);
+
+    // The spinner in the default atlas for its size, and in its own.
+    FT_Library library;
+    FT_Face face;
+    if(FT_Init_FreeType(&library) || FT_New_Memory_Face(library, segoe_slboot_ttf, segoe_slboot_ttf_size, 0, &face)) {
+        fprintf(stderr, "Could not load the spinner font\n");
+        return 1;
+    }
+    FT_Set_Pixel_Sizes(face, 0, SPINNER_SIZE);
+    timeSpinner(face, 512, 512);
+    timeSpinner(face, SPINNER_ATLAS_W, SPINNER_ATLAS_H);
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    if(bad) {
+        printf("%d failed checks\n", bad);
+        return 1;
+    }
+    return 0;
+}
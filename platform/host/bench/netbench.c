@@ -0,0 +1,184 @@
+/**
+ * @file netbench.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: times whole rounds (gen, frame, check) against the API, once with one
+ * networking session kept alive and once with a fresh curl handle per request, the way
+ * the game used to do it.
+ *
+ * Usage:
+ *   PONII_API_BASE=https://127.0.0.1:8443/api build-host/netbench [rounds]
+ *
+ * Point it at tools/mockserver.py (with --cert/--key for HTTPS, that's where keeping the
+ * session pays off most) rather than the real service.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <curl/curl.h>
+#include "cJSON.h"
+
+// Wii Specific (shims).
+#include <gctypes.h>
+
+#include "misc/networking.h"
+
+#define NETBENCH_DEFAULT_ROUNDS 20
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t writeMemory(char* contents, size_t size, size_t nmemb, void* userp) {
+    size_t realsize = size * nmemb;
+    struct MemoryStruct* mem = userp;
+    char* ptr = realloc(mem->memory, mem->size + realsize + 1);
+    if(ptr == NULL) {
+        return 0;
+    }
+    mem->memory = ptr;
+    memcpy(mem->memory + mem->size, contents, realsize);
+    mem->size += realsize;
+    mem->memory[mem->size] = 0;
+    return realsize;
+}
+
+// One GET on a handle made just for it, like the old get_image_id/downloadImage/checkCorrect.
+static bool freshGet(const char* url, struct MemoryStruct* mem) {
+    CURL* curl = curl_easy_init();
+    if(curl == NULL) {
+        return false;
+    }
+    mem->size = 0;
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeMemory);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)mem);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    if(res != CURLE_OK) {
+        fprintf(stderr, "%s: %s\n", url, curl_easy_strerror(res));
+        return false;
+    }
+    return true;
+}
+
+static bool freshRound(struct MemoryStruct* mem) {
+    char url[1024];
+    snprintf(url, sizeof(url), "%s/resource/gen?runId&subtitles=false&audioLength=10&resourceType=frame", Networking_GetApiBase());
+    if(!freshGet(url, mem)) {
+        return false;
+    }
+
+    cJSON* root = cJSON_Parse(mem->memory);
+    cJSON* id = cJSON_GetObjectItem(root, "id");
+    if(!cJSON_IsString(id)) {
+        fprintf(stderr, "bad gen response\n");
+        cJSON_Delete(root);
+        return false;
+    }
+    char iid[64];
+    snprintf(iid, sizeof(iid), "%s", id->valuestring);
+    cJSON_Delete(root);
+
+    snprintf(url, sizeof(url), "%s/resource/get/%s.png", Networking_GetApiBase(), iid);
+    if(!freshGet(url, mem)) {
+        return false;
+    }
+    snprintf(url, sizeof(url), "%s/resource/%s/check?season=1&episode=1", Networking_GetApiBase(), iid);
+    return freshGet(url, mem);
+}
+
+static bool sessionRound(netsession_t* session, struct MemoryStruct* mem) {
+    char errText[256];
+    char* iid = Networking_GetImageId(session, errText, sizeof(errText));
+    if(iid == NULL) {
+        fprintf(stderr, "%s\n", errText);
+        return false;
+    }
+
+    response_t response;
+    bool ok = Networking_DownloadFrame(session, iid, mem, errText, sizeof(errText)) &&
+              Networking_CheckAnswer(session, 1, 1, iid, &response, errText, sizeof(errText));
+    if(!ok) {
+        fprintf(stderr, "%s\n", errText);
+    }
+    free(iid);
+    return ok;
+}
+
+static int compareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Prints every round (ms), then a summary. Sorts times.
+static void report(const char* name, double* times, int rounds) {
+    printf("%s:", name);
+    double first = times[0];    // The one that has to connect.
+    double total = 0;
+    for(int i = 0; i < rounds; i++) {
+        printf(" %.1f", times[i] * 1000);
+        total += times[i];
+    }
+    qsort(times, rounds, sizeof(double), compareDouble);
+    printf("\n  first %.1f ms, median %.1f ms, mean %.1f ms, max %.1f ms per round\n",
+        first * 1000, times[rounds / 2] * 1000, total / rounds * 1000, times[rounds - 1] * 1000);
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : NETBENCH_DEFAULT_ROUNDS;
+    if(rounds < 1) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    Networking_Init();
+    printf("%d rounds against %s\n", rounds, Networking_GetApiBase());
+
+    double* times = malloc(rounds * sizeof(double));
+    struct MemoryStruct mem = { NULL, 0, 0 };
+    if(times == NULL) {
+        return 1;
+    }
+
+    // Before: three fresh handles a round, every one connects (and handshakes) again.
+    for(int i = 0; i < rounds; i++) {
+        double start = now();
+        if(!freshRound(&mem)) {
+            return 1;
+        }
+        times[i] = now() - start;
+    }
+    report("fresh handles", times, rounds);
+
+    // After: one session, the connection and TLS session stay up between rounds.
+    netsession_t* session = Networking_CreateSession();
+    if(session == NULL) {
+        fprintf(stderr, "Networking_CreateSession failed\n");
+        return 1;
+    }
+    free(mem.memory);
+    mem.memory = NULL;
+    mem.size = 0;
+    for(int i = 0; i < rounds; i++) {
+        double start = now();
+        if(!sessionRound(session, &mem)) {
+            return 1;
+        }
+        times[i] = now() - start;
+    }
+    report("one session", times, rounds);
+
+    Networking_DestroySession(session);
+    free(mem.memory);
+    free(times);
+    return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file writerbench.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: writes a profiler style trace three ways and prints mallocs and time for each:
+ * building a cJSON tree and printing it (cJSON_PrintBuffered), printing a tree that's
+ * already built, and the streaming writer through a 4K buffer (what Profiler_DumpTrace does).
+ * The writer's output has to match cJSON_PrintUnformatted byte for byte first.
+ *
+ * Usage:
+ *   build-host/writerbench [events] [iterations]
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+#define WRITERBENCH_DEFAULT_EVENTS 4000
+#define WRITERBENCH_DEFAULT_ITERATIONS 50
+#define WRITERBENCH_BUFFER 4096         // Same as PROFILER_TRACE_BUFFER.
+
+// A trace event, as the profiler keeps them.
+typedef struct {
+    const char* name;
+    int thread;
+    double start;
+    double duration;
+} event_t;
+
+// Where the writer's flushes go, like a file but in memory (so the disk isn't timed).
+typedef struct {
+    char* data;
+    size_t size;
+    size_t used;
+} sink_t;
+
+static size_t mallocs = 0;
+
+static void* countingMalloc(size_t size) {
+    mallocs++;
+    return malloc(size);
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static cJSON_bool flushToSink(void* context, const char* data, size_t length) {
+    sink_t* sink = (sink_t*)context;
+    if(length > sink->size - sink->used) {
+        return 0;
+    }
+    memcpy(sink->data + sink->used, data, length);
+    sink->used += length;
+    return 1;
+}
+
+static cJSON* buildTree(const event_t* events, int count) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "displayTimeUnit", "ms");
+    cJSON* array = cJSON_AddArrayToObject(root, "traceEvents");
+    for(int i = 0; i < count; i++) {
+        cJSON* event = cJSON_CreateObject();
+        cJSON_AddStringToObject(event, "name", events[i].name);
+        cJSON_AddStringToObject(event, "ph", "X");
+        cJSON_AddNumberToObject(event, "pid", 0);
+        cJSON_AddNumberToObject(event, "tid", events[i].thread);
+        cJSON_AddNumberToObject(event, "ts", events[i].start);
+        cJSON_AddNumberToObject(event, "dur", events[i].duration);
+        cJSON_AddItemToArray(array, event);
+    }
+    return root;
+}
+
+static cJSON_bool writeStream(const event_t* events, int count, sink_t* sink) {
+    char buffer[WRITERBENCH_BUFFER];
+    cJSON_Writer writer;
+    sink->used = 0;
+    cJSON_InitWriter(&writer, buffer, sizeof(buffer), flushToSink, sink);
+    cJSON_WriteStartObject(&writer);
+    cJSON_WriteKey(&writer, "displayTimeUnit");
+    cJSON_WriteString(&writer, "ms");
+    cJSON_WriteKey(&writer, "traceEvents");
+    cJSON_WriteStartArray(&writer);
+    for(int i = 0; i < count; i++) {
+        cJSON_WriteStartObject(&writer);
+        cJSON_WriteKey(&writer, "name"); cJSON_WriteString(&writer, events[i].name);
+        cJSON_WriteKey(&writer, "ph"); cJSON_WriteString(&writer, "X");
+        cJSON_WriteKey(&writer, "pid"); cJSON_WriteNumber(&writer, 0);
+        cJSON_WriteKey(&writer, "tid"); cJSON_WriteNumber(&writer, events[i].thread);
+        cJSON_WriteKey(&writer, "ts"); cJSON_WriteNumber(&writer, events[i].start);
+        cJSON_WriteKey(&writer, "dur"); cJSON_WriteNumber(&writer, events[i].duration);
+        cJSON_WriteEndObject(&writer);
+    }
+    cJSON_WriteEndArray(&writer);
+    cJSON_WriteEndObject(&writer);
+    return cJSON_WriterFinish(&writer);
+}
+
+static void report(const char* name, int iterations, size_t count, double seconds) {
+    printf("%-22s %10.1f mallocs/trace %8.3f ms/trace\n", name, (double)count / iterations, seconds / iterations * 1e3);
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : WRITERBENCH_DEFAULT_EVENTS;
+    int iterations = argc > 2 ? atoi(argv[2]) : WRITERBENCH_DEFAULT_ITERATIONS;
+    if(count < 1 || iterations < 1) {
+        fprintf(stderr, "usage: %s [events] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    cJSON_Hooks hooks = { countingMalloc, free };
+    cJSON_InitHooks(&hooks);
+
+    // Scope names like the real ones, microsecond timestamps a few frames apart.
+    static const char* names[] = { "CoreEngine_Render", "Text_Draw", "curl_easy_perform", "GlyphAtlas_Upload", "Quote \"this\"\n" };
+    event_t* events = malloc(count * sizeof(event_t));
+    if(events == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    double ts = 1792231026863.0;
+    for(int i = 0; i < count; i++) {
+        events[i].name = names[i % 5];
+        events[i].thread = i % 3;
+        events[i].start = ts;
+        events[i].duration = (double)(i * 37 % 16000);
+        ts += 16667 + i % 7;
+    }
+
+    // The writer has to print what cJSON_PrintUnformatted prints (its flushes don't include the '\0').
+    cJSON* tree = buildTree(events, count);
+    char* expected = cJSON_PrintUnformatted(tree);
+    sink_t sink = { NULL, 0, 0 };
+    sink.size = expected ? strlen(expected) + 1 : 0;
+    sink.data = malloc(sink.size);
+    if(expected == NULL || sink.data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if(!writeStream(events, count, &sink) || sink.used != sink.size - 1 || memcmp(sink.data, expected, sink.used) != 0) {
+        printf("cJSON_Writer output doesn't match cJSON_PrintUnformatted\n");
+        return 1;
+    }
+    printf("%d events, %zu bytes, %d traces each\n", count, sink.size - 1, iterations);
+
+    // Tree: every node and key is a malloc, then the print and the frees.
+    mallocs = 0;
+    double start = now();
+    for(int n = 0; n < iterations; n++) {
+        cJSON* root = buildTree(events, count);
+        char* text = cJSON_PrintBuffered(root, WRITERBENCH_BUFFER, 0);
+        cJSON_free(text);
+        cJSON_Delete(root);
+    }
+    report("build + PrintBuffered", iterations, mallocs, now() - start);
+
+    // Print only, the tree already there.
+    mallocs = 0;
+    start = now();
+    for(int n = 0; n < iterations; n++) {
+        cJSON_free(cJSON_PrintBuffered(tree, WRITERBENCH_BUFFER, 0));
+    }
+    report("PrintBuffered", iterations, mallocs, now() - start);
+
+    // Writer: a stack buffer flushed into the sink.
+    mallocs = 0;
+    start = now();
+    for(int n = 0; n < iterations; n++) {
+        if(!writeStream(events, count, &sink)) {
+            fprintf(stderr, "cJSON_Writer failed\n");
+            return 1;
+        }
+    }
+    report("cJSON_Writer", iterations, mallocs, now() - start);
+
+    cJSON_free(expected);
+    cJSON_Delete(tree);
+    free(sink.data);
+    free(events);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file bin2c.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: stands in for devkitPro's bin2o. Turns data/x.ext into x_ext.c and
+ * x_ext.h with the same symbols (x_ext, x_ext_end, x_ext_size).
+ *
+ * bin2c <input> <output dir>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        fprintf(stderr, "usage: %s <input> <output dir>\n", argv[0]);
+        return 1;
+    }
+
+    // Symbol name: basename with anything that isn't alphanumeric turned into _.
+    const char* base = strrchr(argv[1], '/');
+    base = base ? base + 1 : argv[1];
+    char name[256];
+    size_t len = strlen(base);
+    if(len >= sizeof(name)) {
+        fprintf(stderr, "bin2c: name too long\n");
+        return 1;
+    }
+    for(size_t i = 0; i <= len; i++) {
+        name[i] = (base[i] && !isalnum((unsigned char)base[i])) ? '_' : base[i];
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if(in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s.c", argv[2], name);
+    FILE* c = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s/%s.h", argv[2], name);
+    FILE* h = fopen(path, "w");
+    if(c == NULL || h == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(h, "/* Generated by bin2c from %s, don't edit. */\n#pragma once\n#include <gctypes.h>\n\n", base);
+    fprintf(h, "extern const u8 %s[];\nextern const u8* const %s_end;\nextern const u32 %s_size;\n", name, name, name);
+
+    // Aligned like bin2o, PNGU and FreeType don't care but the Wii side does.
+    fprintf(c, "/* Generated by bin2c from %s, don't edit. */\n#include <gctypes.h>\n\n", base);
+    fprintf(c, "const u8 %s[] __attribute__((aligned(32))) = {", name);
+    unsigned long size = 0;
+    int ch;
+    while((ch = fgetc(in)) != EOF) {
+        fprintf(c, "%s%s%d", size ? "," : "", (size % 20) == 0 ? "\n" : "", ch);
+        size++;
+    }
+    fprintf(c, "%s0\n};\n", size ? "," : ""); // Trailing 0 so text data is NUL terminated.
+    fprintf(c, "const u8* const %s_end = %s + %lu;\n", name, name, size);
+    fprintf(c, "const u32 %s_size = %lu;\n", name, size);
+
+    fclose(in);
+    fclose(c);
+    fclose(h);
+    return 0;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file host_gfx.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: headless GRRLIB and GX. Textures get decoded and fonts get loaded for
+ * real, draw calls are just counted. GRRLIB_Render waits for a 60Hz "vsync" like the
+ * Wii does, unless PONII_HOST_NOVSYNC is set (for benchmarks).
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+// Wii Specific (shims).
+#include <gctypes.h>
+#include <gccore.h>
+#include <grrlib.h>
+#include <pngu.h>
+#include <ogc/lwp_watchdog.h>
+
+#define HOST_FRAME_NS 16666667ull
+
+Mtx GXmodelView2D;
+
+static FT_Library __host_ftLibrary = NULL;
+static unsigned int __host_frames = 0;
+static unsigned long __host_drawCalls = 0;
+static u64 __host_lastFrame = 0;
+static bool __host_vsync = true;
+
+/**
+ * @author Dakota Thorpe
+ * Frames rendered so far. The input script runs off this.
+*/
+unsigned int HostGfx_FrameCount() {
+    return __host_frames;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Draw calls made so far (images, rectangles, lines and GX batches).
+*/
+unsigned long HostGfx_DrawCalls() {
+    return __host_drawCalls;
+}
+
+int GRRLIB_Init() {
+    __host_vsync = getenv("PONII_HOST_NOVSYNC") == NULL;
+    if(FT_Init_FreeType(&__host_ftLibrary)) {
+        return -1;
+    }
+    return 0;
+}
+
+void GRRLIB_Exit() {
+    FT_Done_FreeType(__host_ftLibrary);
+    __host_ftLibrary = NULL;
+}
+
+void GRRLIB_Render() {
+    __host_frames++;
+    if(!__host_vsync) {
+        return;
+    }
+
+    // Sleep until the next 60Hz tick.
+    u64 now = gettime();
+    u64 next = __host_lastFrame + HOST_FRAME_NS;
+    if(__host_lastFrame != 0 && now < next) {
+        struct timespec ts = { (time_t)((next - now) / 1000000000ull), (long)((next - now) % 1000000000ull) };
+        nanosleep(&ts, NULL);
+        now = next;
+    }
+    __host_lastFrame = now;
+}
+
+/* Textures */
+
+GRRLIB_texImg* GRRLIB_CreateEmptyTexture(const u32 width, const u32 height) {
+    GRRLIB_texImg* tex = calloc(1, sizeof(GRRLIB_texImg));
+    if(tex == NULL) {
+        return NULL;
+    }
+    tex->data = memalign(32, width * height * 4);
+    if(tex->data == NULL) {
+        free(tex);
+        return NULL;
+    }
+    memset(tex->data, 0, width * height * 4);
+    tex->w = width;
+    tex->h = height;
+    return tex;
+}
+
+// Reads the size out of a JPEG's start of frame marker.
+static bool __host_jpegSize(const u8* jpeg, u32* width, u32* height) {
+    size_t pos = 2;
+    for(int guard = 0; guard < 4096; guard++) {
+        if(jpeg[pos] != 0xFF) {
+            return false;
+        }
+        u8 marker = jpeg[pos + 1];
+        u32 length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            *height = (jpeg[pos + 5] << 8) | jpeg[pos + 6];
+            *width = (jpeg[pos + 7] << 8) | jpeg[pos + 8];
+            return true;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+GRRLIB_texImg* GRRLIB_LoadTexture(const u8* my_img) {
+    // PNGs get decoded properly.
+    if(my_img[0] == 0x89 && my_img[1] == 'P' && my_img[2] == 'N' && my_img[3] == 'G') {
+        IMGCTX ctx = PNGU_SelectImageFromBuffer(my_img);
+        PNGUPROP prop;
+        if(ctx == NULL || PNGU_GetImageProperties(ctx, &prop) != PNGU_OK) {
+            if(ctx != NULL) PNGU_ReleaseImageContext(ctx);
+            return NULL;
+        }
+        GRRLIB_texImg* tex = calloc(1, sizeof(GRRLIB_texImg));
+        int w, h;
+        tex->data = PNGU_DecodeTo4x4RGBA8(ctx, prop.imgWidth, prop.imgHeight, &w, &h);
+        PNGU_ReleaseImageContext(ctx);
+        if(tex->data == NULL) {
+            free(tex);
+            return NULL;
+        }
+        tex->w = w;
+        tex->h = h;
+        return tex;
+    }
+
+    // JPEGs only need to be the right size, nobody looks at them here.
+    if(my_img[0] == 0xFF && my_img[1] == 0xD8) {
+        u32 width, height;
+        if(__host_jpegSize(my_img, &width, &height)) {
+            return GRRLIB_CreateEmptyTexture(width, height);
+        }
+    }
+    return NULL;
+}
+
+void GRRLIB_FreeTexture(GRRLIB_texImg* tex) {
+    if(tex == NULL) {
+        return;
+    }
+    free(tex->data);
+    free(tex);
+}
+
+void GRRLIB_FlushTex(GRRLIB_texImg* tex) {
+}
+
+void GRRLIB_SetHandle(GRRLIB_texImg* tex, const int x, const int y) {
+    tex->handlex = x;
+    tex->handley = y;
+}
+
+// Same 4x4 tiled RGBA8 layout GRRLIB uses.
+void GRRLIB_SetPixelTotexImg(const int x, const int y, GRRLIB_texImg* tex, const u32 color) {
+    u8* data = tex->data;
+    u32 offset = (((y >> 2) << 4) * tex->w) + ((x >> 2) << 6) + ((((y & 3) << 2) + (x & 3)) << 1);
+    data[offset] = color & 0xFF;
+    data[offset + 1] = (color >> 24) & 0xFF;
+    data[offset + 32] = (color >> 16) & 0xFF;
+    data[offset + 33] = (color >> 8) & 0xFF;
+}
+
+u32 GRRLIB_GetPixelFromtexImg(const int x, const int y, const GRRLIB_texImg* tex) {
+    const u8* data = tex->data;
+    u32 offset = (((y >> 2) << 4) * tex->w) + ((x >> 2) << 6) + ((((y & 3) << 2) + (x & 3)) << 1);
+    return ((u32)data[offset + 1] << 24) | ((u32)data[offset + 32] << 16) | ((u32)data[offset + 33] << 8) | data[offset];
+}
+
+/* Fonts */
+
+GRRLIB_ttfFont* GRRLIB_LoadTTF(const u8* file_base, s32 file_size) {
+    GRRLIB_ttfFont* font = malloc(sizeof(GRRLIB_ttfFont));
+    if(font == NULL) {
+        return NULL;
+    }
+    if(FT_New_Memory_Face(__host_ftLibrary, file_base, file_size, 0, &font->face)) {
+        free(font);
+        return NULL;
+    }
+    font->kerning = FT_HAS_KERNING(font->face);
+    return font;
+}
+
+void GRRLIB_FreeTTF(GRRLIB_ttfFont* myFont) {
+    if(myFont == NULL) {
+        return;
+    }
+    FT_Done_Face(myFont->face);
+    free(myFont);
+}
+
+// Nothing calls these any more (see text.c), they're here so the API is complete.
+void GRRLIB_PrintfTTF(int x, int y, GRRLIB_ttfFont* myFont, const char* string, unsigned int fontSize, const u32 color) {
+    __host_drawCalls++;
+}
+
+unsigned int GRRLIB_WidthTTF(GRRLIB_ttfFont* myFont, const char* string, unsigned int fontSize) {
+    return 0;
+}
+
+/* Drawing */
+
+void GRRLIB_DrawImg(const f32 xpos, const f32 ypos, const GRRLIB_texImg* tex, const f32 degrees, const f32 scaleX, const f32 scaleY, const u32 color) {
+    __host_drawCalls++;
+}
+
+void GRRLIB_Rectangle(const f32 x, const f32 y, const f32 width, const f32 height, const u32 color, const bool filled) {
+    __host_drawCalls++;
+}
+
+void GRRLIB_Line(const f32 x1, const f32 y1, const f32 x2, const f32 y2, const u32 color) {
+    __host_drawCalls++;
+}
+
+/* GX */
+
+void GX_InitTexObj(GXTexObj* obj, void* img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap) {
+}
+void GX_InitTexObjLOD(GXTexObj* obj, u8 minfilt, u8 magfilt, f32 minlod, f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod, u8 maxaniso) {
+}
+void GX_LoadTexObj(GXTexObj* obj, u8 mapid) {
+}
+void GX_SetTevOp(u8 tevstage, u8 mode) {
+}
+void GX_SetVtxDesc(u8 attr, u8 type) {
+}
+void GX_LoadPosMtxImm(Mtx mt, u32 pnidx) {
+}
+void GX_InvalidateTexAll() {
+}
+void GX_Begin(u8 primitve, u8 vtxfmt, u16 vtxcnt) {
+    __host_drawCalls++;
+}
+void GX_End() {
+}
+void GX_Position3f32(f32 x, f32 y, f32 z) {
+}
+void GX_Color1u32(u32 clr) {
+}
+void GX_TexCoord2f32(f32 s, f32 t) {
+}
@@ -0,0 +1,112 @@
+/**
+ * @file host_input.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: Wiimote input replayed from a script, so the game can run headless.
+ * PONII_HOST_INPUT is a list of frame:button presses, e.g. "60:A,120:HOME".
+ * Buttons are A, B, 1, 2, PLUS, MINUS, HOME, UP, DOWN, LEFT, RIGHT.
+ * PONII_HOST_POINTER=x,y aims the pointer (defaults to the middle of the screen).
+ * Without a script HOME gets pressed on frame 600 so nothing runs forever.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Wii Specific (shims).
+#include <gctypes.h>
+#include <wiiuse/wpad.h>
+
+#define HOST_MAX_PRESSES 256
+#define HOST_DEFAULT_SCRIPT "600:HOME"
+
+// One scripted press.
+typedef struct {
+    unsigned int frame;
+    u32 button;
+    bool delivered;
+} hostpress_t;
+
+static hostpress_t __host_presses[HOST_MAX_PRESSES];
+static int __host_pressCount = 0;
+static u32 __host_down = 0;
+static f32 __host_pointerX = 320;
+static f32 __host_pointerY = 240;
+
+extern unsigned int HostGfx_FrameCount();
+
+static u32 __host_buttonFromName(const char* name) {
+    static const struct { const char* name; u32 button; } buttons[] = {
+        { "A", WPAD_BUTTON_A }, { "B", WPAD_BUTTON_B }, { "1", WPAD_BUTTON_1 }, { "2", WPAD_BUTTON_2 },
+        { "PLUS", WPAD_BUTTON_PLUS }, { "MINUS", WPAD_BUTTON_MINUS }, { "HOME", WPAD_BUTTON_HOME },
+        { "UP", WPAD_BUTTON_UP }, { "DOWN", WPAD_BUTTON_DOWN }, { "LEFT", WPAD_BUTTON_LEFT }, { "RIGHT", WPAD_BUTTON_RIGHT },
+    };
+    for(size_t i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++) {
+        if(strcmp(buttons[i].name, name) == 0) {
+            return buttons[i].button;
+        }
+    }
+    fprintf(stderr, "host: unknown button '%s'\n", name);
+    return 0;
+}
+
+s32 WPAD_Init() {
+    const char* script = getenv("PONII_HOST_INPUT");
+    if(script == NULL) {
+        script = HOST_DEFAULT_SCRIPT;
+    }
+
+    char* copy = strdup(script);
+    char* save = NULL;
+    for(char* token = strtok_r(copy, ",", &save); token != NULL && __host_pressCount < HOST_MAX_PRESSES; token = strtok_r(NULL, ",", &save)) {
+        char* colon = strchr(token, ':');
+        if(colon == NULL) {
+            continue;
+        }
+        *colon = '\0';
+        __host_presses[__host_pressCount].frame = (unsigned int)strtoul(token, NULL, 10);
+        __host_presses[__host_pressCount].button = __host_buttonFromName(colon + 1);
+        __host_presses[__host_pressCount].delivered = false;
+        __host_pressCount++;
+    }
+    free(copy);
+
+    const char* pointer = getenv("PONII_HOST_POINTER");
+    if(pointer != NULL) {
+        sscanf(pointer, "%f,%f", &__host_pointerX, &__host_pointerY);
+    }
+    return 0;
+}
+
+s32 WPAD_SetDataFormat(s32 chan, s32 fmt) {
+    return 0;
+}
+
+// Each press shows up once, on the first scan at or after its frame.
+s32 WPAD_ScanPads() {
+    unsigned int frame = HostGfx_FrameCount();
+    __host_down = 0;
+    for(int i = 0; i < __host_pressCount; i++) {
+        if(!__host_presses[i].delivered && __host_presses[i].frame <= frame) {
+            __host_down |= __host_presses[i].button;
+            __host_presses[i].delivered = true;
+        }
+    }
+    return 0;
+}
+
+s32 WPAD_IR(int chan, ir_t* ir) {
+    ir->valid = 1;
+    ir->x = __host_pointerX;
+    ir->y = __host_pointerY;
+    return 0;
+}
+
+u32 WPAD_ButtonsDown(int chan) {
+    return __host_down;
+}
+
+u32 WPAD_ButtonsHeld(int chan) {
+    return __host_down;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file host_lwp.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: libogc threads, mutexes and condition variables on pthreads.
+ * libogc hands out integer handles, so these index into tables.
+*/
+
+#define _GNU_SOURCE
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+// Wii Specific (shims).
+#include <gctypes.h>
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+
+#define HOST_MAX_THREADS 64
+#define HOST_MAX_MUTEXES 256
+#define HOST_MAX_CONDS 64
+
+// A thread.
+typedef struct {
+    pthread_t thread;
+    void* (*entry)(void*);
+    void* arg;
+    bool used;
+} hostthread_t;
+
+static hostthread_t __host_threads[HOST_MAX_THREADS];
+static pthread_mutex_t __host_mutexes[HOST_MAX_MUTEXES];
+static pthread_cond_t __host_conds[HOST_MAX_CONDS];
+static int __host_mutexCount = 0;
+static int __host_condCount = 0;
+static pthread_mutex_t __host_tableLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread lwp_t __host_self = 0; // 0 is the main thread.
+
+// Entry point wrapper, so LWP_GetSelf knows who it is.
+static void* __host_threadEntry(void* arg) {
+    hostthread_t* thread = arg;
+    __host_self = (lwp_t)(thread - __host_threads) + 1;
+    return thread->entry(thread->arg);
+}
+
+s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg, void* stackbase, u32 stack_size, u8 prio) {
+    pthread_mutex_lock(&__host_tableLock);
+    int slot = -1;
+    for(int i = 0; i < HOST_MAX_THREADS; i++) {
+        if(!__host_threads[i].used) {
+            slot = i;
+            break;
+        }
+    }
+    if(slot < 0) {
+        pthread_mutex_unlock(&__host_tableLock);
+        return -1;
+    }
+    hostthread_t* thread = &__host_threads[slot];
+    thread->entry = entry;
+    thread->arg = arg;
+    thread->used = true;
+    pthread_mutex_unlock(&__host_tableLock);
+
+    // Priorities are ignored, the host scheduler is fair enough.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(stack_size > 0) {
+        pthread_attr_setstacksize(&attr, stack_size < 65536 ? 65536 : stack_size);
+    }
+    int res = pthread_create(&thread->thread, &attr, __host_threadEntry, thread);
+    pthread_attr_destroy(&attr);
+    if(res != 0) {
+        thread->used = false;
+        return -1;
+    }
+
+    if(thethread != NULL) {
+        *thethread = (lwp_t)slot + 1;
+    }
+    return 0;
+}
+
+// Nothing uses these since the spinner thread went away, and pthreads can't do them.
+s32 LWP_SuspendThread(lwp_t thethread) {
+    return -1;
+}
+s32 LWP_ResumeThread(lwp_t thethread) {
+    return -1;
+}
+
+s32 LWP_JoinThread(lwp_t thethread, void** value_ptr) {
+    if(thethread == 0 || thethread > HOST_MAX_THREADS) {
+        return -1;
+    }
+    hostthread_t* thread = &__host_threads[thethread - 1];
+    int res = pthread_join(thread->thread, value_ptr);
+
+    pthread_mutex_lock(&__host_tableLock);
+    thread->used = false;
+    pthread_mutex_unlock(&__host_tableLock);
+    return res == 0 ? 0 : -1;
+}
+
+void LWP_YieldThread() {
+    sched_yield();
+}
+
+lwp_t LWP_GetSelf() {
+    return __host_self;
+}
+
+s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive) {
+    pthread_mutex_lock(&__host_tableLock);
+    if(__host_mutexCount == HOST_MAX_MUTEXES) {
+        pthread_mutex_unlock(&__host_tableLock);
+        return -1;
+    }
+    int slot = __host_mutexCount++;
+    pthread_mutex_unlock(&__host_tableLock);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if(use_recursive) {
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    }
+    pthread_mutex_init(&__host_mutexes[slot], &attr);
+    pthread_mutexattr_destroy(&attr);
+    *mutex = slot;
+    return 0;
+}
+
+s32 LWP_MutexLock(mutex_t mutex) {
+    return pthread_mutex_lock(&__host_mutexes[mutex]) == 0 ? 0 : -1;
+}
+
+s32 LWP_MutexUnlock(mutex_t mutex) {
+    return pthread_mutex_unlock(&__host_mutexes[mutex]) == 0 ? 0 : -1;
+}
+
+// Handles are never reused, there's only ever a handful.
+s32 LWP_MutexDestroy(mutex_t mutex) {
+    return 0;
+}
+
+s32 LWP_CondInit(cond_t* cond) {
+    pthread_mutex_lock(&__host_tableLock);
+    if(__host_condCount == HOST_MAX_CONDS) {
+        pthread_mutex_unlock(&__host_tableLock);
+        return -1;
+    }
+    int slot = __host_condCount++;
+    pthread_mutex_unlock(&__host_tableLock);
+
+    pthread_cond_init(&__host_conds[slot], NULL);
+    *cond = slot;
+    return 0;
+}
+
+s32 LWP_CondWait(cond_t cond, mutex_t mutex) {
+    return pthread_cond_wait(&__host_conds[cond], &__host_mutexes[mutex]) == 0 ? 0 : -1;
+}
+
+s32 LWP_CondSignal(cond_t cond) {
+    return pthread_cond_signal(&__host_conds[cond]) == 0 ? 0 : -1;
+}
+
+s32 LWP_CondBroadcast(cond_t cond) {
+    return pthread_cond_broadcast(&__host_conds[cond]) == 0 ? 0 : -1;
+}
+
+s32 LWP_CondDestroy(cond_t cond) {
+    return 0;
+}
+
+// No incoherent caches on a PC.
+void DCFlushRange(void* startaddress, u32 len) {
+}
+
+u64 gettime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+u32 diff_usec(u64 start, u64 end) {
+    return (u32)((end - start) / 1000);
+}
+
+u64 ticks_to_microsecs(u64 ticks) {
+    return ticks / 1000;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file host_pngu.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: PNGU on libpng. Decodes to the same 4x4 tiled RGBA8 layout PNGU makes,
+ * so decode benchmarks do the same work.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <png.h>
+
+// Wii Specific (shims).
+#include <gctypes.h>
+#include <pngu.h>
+
+struct _IMGCTX {
+    png_image image;
+    const u8* buffer;
+    size_t size;
+};
+
+// PNGU takes the buffer without a size, so read it out of the chunks (up to IEND).
+static size_t __host_pngSize(const u8* png) {
+    size_t pos = 8;
+    while(true) {
+        u32 length = ((u32)png[pos] << 24) | ((u32)png[pos + 1] << 16) | ((u32)png[pos + 2] << 8) | png[pos + 3];
+        bool end = memcmp(png + pos + 4, "IEND", 4) == 0;
+        pos += 12 + length;
+        if(end) {
+            return pos;
+        }
+    }
+}
+
+IMGCTX PNGU_SelectImageFromBuffer(const void* buffer) {
+    if(buffer == NULL || png_sig_cmp(buffer, 0, 8) != 0) {
+        return NULL;
+    }
+    IMGCTX ctx = calloc(1, sizeof(struct _IMGCTX));
+    if(ctx == NULL) {
+        return NULL;
+    }
+    ctx->buffer = buffer;
+    ctx->size = __host_pngSize(buffer);
+    ctx->image.version = PNG_IMAGE_VERSION;
+    if(!png_image_begin_read_from_memory(&ctx->image, ctx->buffer, ctx->size)) {
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+int PNGU_GetImageProperties(IMGCTX ctx, PNGUPROP* fileproperties) {
+    fileproperties->imgWidth = ctx->image.width;
+    fileproperties->imgHeight = ctx->image.height;
+    fileproperties->imgBitDepth = 8;
+    fileproperties->imgColorType = ctx->image.format;
+    return PNGU_OK;
+}
+
+void* PNGU_DecodeTo4x4RGBA8(IMGCTX ctx, u32 width, u32 height, int* dstWidth, int* dstHeight) {
+    ctx->image.format = PNG_FORMAT_RGBA;
+    u8* rgba = malloc(PNG_IMAGE_SIZE(ctx->image));
+    if(rgba == NULL) {
+        return NULL;
+    }
+    if(!png_image_finish_read(&ctx->image, NULL, rgba, 0, NULL)) {
+        free(rgba);
+        return NULL;
+    }
+
+    // Pad up to whole tiles.
+    u32 tw = (width + 3) & ~3u;
+    u32 th = (height + 3) & ~3u;
+    u8* tiled = memalign(32, tw * th * 4);
+    if(tiled == NULL) {
+        free(rgba);
+        return NULL;
+    }
+    memset(tiled, 0, tw * th * 4);
+
+    // Each 4x4 tile is 32 bytes of AR pairs then 32 bytes of GB pairs.
+    for(u32 y = 0; y < height; y++) {
+        for(u32 x = 0; x < width; x++) {
+            const u8* px = rgba + (y * width + x) * 4;
+            u32 offset = (((y >> 2) << 4) * tw) + ((x >> 2) << 6) + ((((y & 3) << 2) + (x & 3)) << 1);
+            tiled[offset] = px[3];
+            tiled[offset + 1] = px[0];
+            tiled[offset + 32] = px[1];
+            tiled[offset + 33] = px[2];
+        }
+    }
+    free(rgba);
+
+    *dstWidth = tw;
+    *dstHeight = th;
+    return tiled;
+}
+
+void PNGU_ReleaseImageContext(IMGCTX ctx) {
+    if(ctx == NULL) {
+        return;
+    }
+    png_image_free(&ctx->image);
+    free(ctx);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file host_system.c
+ * @author Dakota Thorpe
+ * @copyright &copy;2024
+ * Host build: SD card, network and audio init.
+*/
+
+// Standard Libs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+// Wii Specific (shims).
+#include <gctypes.h>
+#include <asndlib.h>
+#include <fat.h>
+#include <wiisocket.h>
+
+// The SD card is the "sd:" folder in the working directory.
+bool fatInitDefault() {
+    if(mkdir("sd:", 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    if(mkdir("sd:/ponii", 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    return true;
+}
+
+int wiisocket_init() {
+    return 0;
+}
+
+// Audio goes nowhere.
+void ASND_Init() {
+}
+
+void ASND_Pause(s32 paused) {
+}
+
+s32 ASND_SetVoice(s32 voice, s32 format, s32 pitch, s32 delay, void* snd, s32 size_snd, s32 volume_l, s32 volume_r, void* callback) {
+    return 0;
+}
+
+s32 ASND_GetFirstUnusedVoice() {
+    return 0;
+}
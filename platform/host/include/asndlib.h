@@ -0,0 +1,18 @@
+// asndlib.h - (C)2024 Dakota Thorpe.
+// Host build: audio goes nowhere.
+#ifndef HOST_ASNDLIB_H
+#define HOST_ASNDLIB_H
+
+#include <gctypes.h>
+
+#define VOICE_MONO_8BIT 0
+#define VOICE_MONO_16BIT 1
+#define VOICE_STEREO_8BIT 2
+#define VOICE_STEREO_16BIT 3
+
+void ASND_Init();
+void ASND_Pause(s32 paused);
+s32 ASND_SetVoice(s32 voice, s32 format, s32 pitch, s32 delay, void* snd, s32 size_snd, s32 volume_l, s32 volume_r, void* callback);
+s32 ASND_GetFirstUnusedVoice();
+
+#endif
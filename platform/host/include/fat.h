@@ -0,0 +1,11 @@
+// fat.h - (C)2024 Dakota Thorpe.
+// Host build: the SD card is the "sd:" folder in the working directory, so "sd:/ponii/x"
+// paths work unchanged.
+#ifndef HOST_FAT_H
+#define HOST_FAT_H
+
+#include <stdbool.h>
+
+bool fatInitDefault();
+
+#endif
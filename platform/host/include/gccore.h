@@ -0,0 +1,81 @@
+// gccore.h - (C)2024 Dakota Thorpe.
+// Host build: the bits of libogc we use. Threads are pthreads, GX calls do nothing.
+#ifndef HOST_GCCORE_H
+#define HOST_GCCORE_H
+
+#include <gctypes.h>
+
+/* Threads (platform/host/host_lwp.c) */
+typedef u32 lwp_t;
+typedef u32 mutex_t;
+typedef u32 cond_t;
+
+#define LWP_PRIO_IDLE 0
+#define LWP_PRIO_HIGHEST 127
+#define LWP_THREAD_NULL 0xffffffff
+#define LWP_MUTEX_NULL 0xffffffff
+#define LWP_COND_NULL 0xffffffff
+
+s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg, void* stackbase, u32 stack_size, u8 prio);
+s32 LWP_SuspendThread(lwp_t thethread);
+s32 LWP_ResumeThread(lwp_t thethread);
+s32 LWP_JoinThread(lwp_t thethread, void** value_ptr);
+void LWP_YieldThread();
+lwp_t LWP_GetSelf();
+
+s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive);
+s32 LWP_MutexLock(mutex_t mutex);
+s32 LWP_MutexUnlock(mutex_t mutex);
+s32 LWP_MutexDestroy(mutex_t mutex);
+
+s32 LWP_CondInit(cond_t* cond);
+s32 LWP_CondWait(cond_t cond, mutex_t mutex);
+s32 LWP_CondSignal(cond_t cond);
+s32 LWP_CondBroadcast(cond_t cond);
+s32 LWP_CondDestroy(cond_t cond);
+
+/* Cache */
+void DCFlushRange(void* startaddress, u32 len);
+
+/* GX (platform/host/host_gfx.c) */
+typedef f32 Mtx[3][4];
+extern Mtx GXmodelView2D;
+
+typedef struct {
+    u32 val[8];
+} GXTexObj;
+
+#define GX_FALSE 0
+#define GX_TRUE 1
+#define GX_NONE 0
+#define GX_DIRECT 1
+#define GX_CLAMP 0
+#define GX_NEAR 0
+#define GX_LINEAR 1
+#define GX_ANISO_1 0
+#define GX_TF_I8 0x1
+#define GX_TF_IA8 0x3
+#define GX_TF_RGBA8 0x6
+#define GX_TEXMAP0 0
+#define GX_TEVSTAGE0 0
+#define GX_MODULATE 0
+#define GX_PASSCLR 4
+#define GX_VA_TEX0 13
+#define GX_QUADS 0x80
+#define GX_VTXFMT0 0
+#define GX_PNMTX0 0
+
+void GX_InitTexObj(GXTexObj* obj, void* img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap);
+void GX_InitTexObjLOD(GXTexObj* obj, u8 minfilt, u8 magfilt, f32 minlod, f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod, u8 maxaniso);
+void GX_LoadTexObj(GXTexObj* obj, u8 mapid);
+void GX_SetTevOp(u8 tevstage, u8 mode);
+void GX_SetVtxDesc(u8 attr, u8 type);
+void GX_LoadPosMtxImm(Mtx mt, u32 pnidx);
+void GX_InvalidateTexAll();
+void GX_Begin(u8 primitve, u8 vtxfmt, u16 vtxcnt);
+void GX_End();
+void GX_Position3f32(f32 x, f32 y, f32 z);
+void GX_Color1u32(u32 clr);
+void GX_TexCoord2f32(f32 s, f32 t);
+
+#endif
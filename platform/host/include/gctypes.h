@@ -0,0 +1,20 @@
+// gctypes.h - (C)2024 Dakota Thorpe.
+// Host build: libogc's basic types.
+#ifndef HOST_GCTYPES_H
+#define HOST_GCTYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef float f32;
+typedef double f64;
+
+#endif
@@ -0,0 +1,55 @@
+// grrlib.h - (C)2024 Dakota Thorpe.
+// Host build: headless GRRLIB. Textures and fonts are real (so decoding and glyph
+// work still costs what it does on the Wii), drawing does nothing.
+#ifndef HOST_GRRLIB_H
+#define HOST_GRRLIB_H
+
+#include <gccore.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+typedef struct {
+    u32 w;
+    u32 h;
+    int handlex;
+    int handley;
+    int offsetx;
+    int offsety;
+    bool tiledtex;
+    u32 tilew;
+    u32 tileh;
+    u32 nbtilew;
+    u32 nbtileh;
+    u32 tilestart;
+    f32 ofnormaltexx;
+    f32 ofnormaltexy;
+    void* data;             // RGBA8, 4x4 tiles like the real thing.
+} GRRLIB_texImg;
+
+typedef struct {
+    FT_Face face;
+    FT_Bool kerning;
+} GRRLIB_ttfFont;
+
+int GRRLIB_Init();
+void GRRLIB_Exit();
+void GRRLIB_Render();
+
+GRRLIB_texImg* GRRLIB_LoadTexture(const u8* my_img);
+GRRLIB_texImg* GRRLIB_CreateEmptyTexture(const u32 width, const u32 height);
+void GRRLIB_FreeTexture(GRRLIB_texImg* tex);
+void GRRLIB_FlushTex(GRRLIB_texImg* tex);
+void GRRLIB_SetHandle(GRRLIB_texImg* tex, const int x, const int y);
+void GRRLIB_SetPixelTotexImg(const int x, const int y, GRRLIB_texImg* tex, const u32 color);
+u32 GRRLIB_GetPixelFromtexImg(const int x, const int y, const GRRLIB_texImg* tex);
+
+GRRLIB_ttfFont* GRRLIB_LoadTTF(const u8* file_base, s32 file_size);
+void GRRLIB_FreeTTF(GRRLIB_ttfFont* myFont);
+void GRRLIB_PrintfTTF(int x, int y, GRRLIB_ttfFont* myFont, const char* string, unsigned int fontSize, const u32 color);
+unsigned int GRRLIB_WidthTTF(GRRLIB_ttfFont* myFont, const char* string, unsigned int fontSize);
+
+void GRRLIB_DrawImg(const f32 xpos, const f32 ypos, const GRRLIB_texImg* tex, const f32 degrees, const f32 scaleX, const f32 scaleY, const u32 color);
+void GRRLIB_Rectangle(const f32 x, const f32 y, const f32 width, const f32 height, const u32 color, const bool filled);
+void GRRLIB_Line(const f32 x1, const f32 y1, const f32 x2, const f32 y2, const u32 color);
+
+#endif
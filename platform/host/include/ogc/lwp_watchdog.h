@@ -0,0 +1,12 @@
+// lwp_watchdog.h - (C)2024 Dakota Thorpe.
+// Host build: time base. Ticks are nanoseconds here.
+#ifndef HOST_LWP_WATCHDOG_H
+#define HOST_LWP_WATCHDOG_H
+
+#include <gctypes.h>
+
+u64 gettime();
+u32 diff_usec(u64 start, u64 end);
+u64 ticks_to_microsecs(u64 ticks);
+
+#endif
@@ -0,0 +1,25 @@
+// pngu.h - (C)2024 Dakota Thorpe.
+// Host build: PNGU on top of libpng.
+#ifndef HOST_PNGU_H
+#define HOST_PNGU_H
+
+#include <gctypes.h>
+
+#define PNGU_OK 0
+#define PNGU_ERR -1
+
+typedef struct _IMGCTX* IMGCTX;
+
+typedef struct {
+    u32 imgWidth;
+    u32 imgHeight;
+    u32 imgBitDepth;
+    u32 imgColorType;
+} PNGUPROP;
+
+IMGCTX PNGU_SelectImageFromBuffer(const void* buffer);
+int PNGU_GetImageProperties(IMGCTX ctx, PNGUPROP* fileproperties);
+void* PNGU_DecodeTo4x4RGBA8(IMGCTX ctx, u32 width, u32 height, int* dstWidth, int* dstHeight);
+void PNGU_ReleaseImageContext(IMGCTX ctx);
+
+#endif
@@ -0,0 +1,8 @@
+// wiisocket.h - (C)2024 Dakota Thorpe.
+// Host build: the PC's sockets are always up.
+#ifndef HOST_WIISOCKET_H
+#define HOST_WIISOCKET_H
+
+int wiisocket_init();
+
+#endif
@@ -0,0 +1,36 @@
+// wpad.h - (C)2024 Dakota Thorpe.
+// Host build: Wiimote input replayed from PONII_HOST_INPUT (see host_input.c).
+#ifndef HOST_WPAD_H
+#define HOST_WPAD_H
+
+#include <gctypes.h>
+
+#define WPAD_CHAN_0 0
+#define WPAD_FMT_BTNS_ACC_IR 2
+
+#define WPAD_BUTTON_2 0x0001
+#define WPAD_BUTTON_1 0x0002
+#define WPAD_BUTTON_B 0x0004
+#define WPAD_BUTTON_A 0x0008
+#define WPAD_BUTTON_MINUS 0x0010
+#define WPAD_BUTTON_HOME 0x0080
+#define WPAD_BUTTON_LEFT 0x0100
+#define WPAD_BUTTON_RIGHT 0x0200
+#define WPAD_BUTTON_DOWN 0x0400
+#define WPAD_BUTTON_UP 0x0800
+#define WPAD_BUTTON_PLUS 0x1000
+
+typedef struct {
+    int valid;
+    f32 x;
+    f32 y;
+} ir_t;
+
+s32 WPAD_Init();
+s32 WPAD_SetDataFormat(s32 chan, s32 fmt);
+s32 WPAD_ScanPads();
+s32 WPAD_IR(int chan, ir_t* ir);
+u32 WPAD_ButtonsDown(int chan);
+u32 WPAD_ButtonsHeld(int chan);
+
+#endif
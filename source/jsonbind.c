@@ -0,0 +1,176 @@
+/**
+ * @file jsonbind.c
+ * @author Dakota Thorpe
+ * Decodes JSON objects straight into C structs from a table of fields, instead of
+ * a cJSON_GetObjectItem (and a by hand conversion) per field.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "cJSON.h"
+#include "misc/jsonbind.h"
+
+// What a value is, for error messages.
+static const char* __jsonbind_describe(const cJSON* value) {
+    if(cJSON_IsNumber(value)) return "a number";
+    if(cJSON_IsString(value)) return "a string";
+    if(cJSON_IsBool(value)) return "a bool";
+    if(cJSON_IsNull(value)) return "null";
+    if(cJSON_IsObject(value)) return "an object";
+    if(cJSON_IsArray(value)) return "an array";
+    return "something invalid";
+}
+
+static const char* __jsonbind_typeName(jsonbind_type_t type) {
+    switch(type) {
+        case JSONBIND_INT:
+        case JSONBIND_INT64:
+            return "a whole number";
+        case JSONBIND_FLOAT:
+        case JSONBIND_DOUBLE:
+            return "a number";
+        case JSONBIND_BOOL:
+            return "a bool";
+        default:
+            return "a string";
+    }
+}
+
+// Stores one value into its member. Returns false if the value isn't the right type.
+static bool __jsonbind_store(const jsonbind_field_t* field, const cJSON* value, unsigned char* out) {
+    void* member = out + field->offset;
+    double number = value->valuedouble;
+
+    switch(field->type) {
+        case JSONBIND_INT:
+            if(!cJSON_IsNumber(value) || number < (double)INT_MIN || number > (double)INT_MAX || (double)(int)number != number) {
+                return false;
+            }
+            *(int*)member = (int)number;
+            return true;
+
+        case JSONBIND_INT64:
+            // Doubles are only exact up to 2^53, but that's plenty for ms timestamps.
+            if(!cJSON_IsNumber(value) || number < -9223372036854775808.0 || number >= 9223372036854775808.0 || (double)(long long)number != number) {
+                return false;
+            }
+            *(long long*)member = (long long)number;
+            return true;
+
+        case JSONBIND_FLOAT:
+            if(!cJSON_IsNumber(value)) {
+                return false;
+            }
+            *(float*)member = (float)number;
+            return true;
+
+        case JSONBIND_DOUBLE:
+            if(!cJSON_IsNumber(value)) {
+                return false;
+            }
+            *(double*)member = number;
+            return true;
+
+        case JSONBIND_BOOL:
+            if(!cJSON_IsBool(value)) {
+                return false;
+            }
+            *(bool*)member = cJSON_IsTrue(value);
+            return true;
+
+        case JSONBIND_STRING:
+            if(!cJSON_IsString(value)) {
+                return false;
+            }
+            *(char**)member = strdup(value->valuestring);
+            return *(char**)member != NULL;
+    }
+    return false;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Decodes a JSON object into a struct in one pass over its members. Keys that aren't
+ * in the table are skipped. On failure nothing this call allocated is left behind.
+ *
+ * @param object The JSON object.
+ * @param fields The fields to fill in (at most JSONBIND_MAX_FIELDS).
+ * @param count How many fields there are.
+ * @param out The struct.
+ * @param errText Gets which field was missing or the wrong type, on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns true if every required field was there and every field had the right type.
+*/
+bool JsonBind_Object(const cJSON* object, const jsonbind_field_t* fields, size_t count, void* out, char* errText, size_t errSize) {
+    uint32_t seen = 0;      // Fields this object had.
+    uint32_t strings = 0;   // String fields this call allocated, freed if it fails.
+    const cJSON* child;
+    size_t i;
+
+    if(count > JSONBIND_MAX_FIELDS) {
+        snprintf(errText, errSize, "Too many fields to bind (%u, max %d).", (unsigned int)count, JSONBIND_MAX_FIELDS);
+        return false;
+    }
+    if(!cJSON_IsObject(object)) {
+        snprintf(errText, errSize, "Expected an object, got %s.", object ? __jsonbind_describe(object) : "nothing");
+        return false;
+    }
+
+    cJSON_ArrayForEach(child, object) {
+        if(child->string == NULL) {
+            continue;
+        }
+
+        for(i = 0; i < count; i++) {
+            if(strcmp(fields[i].name, child->string) == 0) {
+                break;
+            }
+        }
+        if(i == count) {
+            continue; // Not one of ours.
+        }
+
+        // Key given twice, the last one wins.
+        if(strings & (1u << i)) {
+            free(*(char**)((unsigned char*)out + fields[i].offset));
+            strings &= ~(1u << i);
+        }
+
+        if(!__jsonbind_store(&fields[i], child, out)) {
+            if(cJSON_IsNumber(child)) {
+                // Right type, wrong number (not whole, or too big).
+                snprintf(errText, errSize, "'%s' should be %s, got %.17g.", fields[i].name, __jsonbind_typeName(fields[i].type), child->valuedouble);
+            } else {
+                snprintf(errText, errSize, "'%s' should be %s, got %s.", fields[i].name, __jsonbind_typeName(fields[i].type), __jsonbind_describe(child));
+            }
+            goto fail;
+        }
+        if(fields[i].type == JSONBIND_STRING) {
+            strings |= 1u << i;
+        }
+        seen |= 1u << i;
+    }
+
+    for(i = 0; i < count; i++) {
+        if(fields[i].required && !(seen & (1u << i))) {
+            snprintf(errText, errSize, "'%s' is missing.", fields[i].name);
+            goto fail;
+        }
+    }
+    return true;
+
+fail:
+    for(i = 0; i < count; i++) {
+        if(strings & (1u << i)) {
+            char** member = (char**)((unsigned char*)out + fields[i].offset);
+            free(*member);
+            *member = NULL;
+        }
+    }
+    return false;
+}
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <math.h>
 
@@ -18,9 +19,15 @@
 #include <curl/curl.h>
 #include "cJSON.h"
 
+#include "rend/text.h"
+#include "rend/assets.h"
+#include "rend/glyphatlas.h"
+#include "rend/framearena.h"
+#include "rend/profiler.h"
 #include "rend/coreEngine.h" // For error handling.
 #include "misc/carhorn_defs.h" // Colors
 #include "misc/networking.h"
+#include "misc/jsonbind.h"
 
 // Built-in-data.
 #include "wiibg_jpg.h"
@@ -28,72 +35,133 @@
 #include "segoe_slboot_ttf.h"
 
 // local code defs.
-lwp_t __networking_waitingThread;
-bool __networking_isDoingNetworkOpetaion = false; // Should we display the please wait?
-char* __networking_waitingText; // Text to be displayed in the wait screen.
+#define NETWORKING_JOB_PRIO 64              // Same as the main thread, it's just sitting in the wait screen.
+#define NETWORKING_JOB_STACK (64*1024)      // TLS handshakes are stack hungry.
+#define NETWORKING_JSON_ARENA 2048          // The API's responses are tiny, this fits them in one block.
+#define NETWORKING_MAX_SESSIONS 8           // Sessions whose progress shows on the wait screen.
+#define NETWORKING_MAX_BODY (8*1024*1024)   // Biggest body held in memory. Frames are a couple of MB at most.
+#define NETWORKING_SPINNER_SIZE 64          // Wait screen spinner font size.
+#define NETWORKING_SPINNER_ATLAS_W 1024     // Its atlas, all 121 frames (up to 83x83 each) fit.
+#define NETWORKING_SPINNER_ATLAS_H 576
+#define NETWORKING_MAX_IID 64               // Longest image ID we take from the server (they're UUIDs).
 int __networking_spinStart = 0xE052;
 int __networking_spinEnd = 0xE0CB;
 double __networking_spinCur = 0;
+GRRLIB_ttfFont* __networking_waitFont = NULL;
+GRRLIB_texImg* __networking_waitBg = NULL;
+char __networking_apiBase[256] = API_BASE;     // Where the API lives, see Networking_SetApiBase.
+
+// What the API sends back.
+typedef struct {
+    char* id;
+} genresponse_t;
+
+static const jsonbind_field_t __networking_genFields[] = {
+    JSONBIND_FIELD(genresponse_t, id, JSONBIND_STRING, true),
+};
+
+static const jsonbind_field_t __networking_checkFields[] = {
+    JSONBIND_FIELD(response_t, season, JSONBIND_INT, true),         // Correct season.
+    JSONBIND_FIELD(response_t, episode, JSONBIND_INT, true),        // Correct episode.
+    JSONBIND_FIELD(response_t, seekTime, JSONBIND_FLOAT, true),     // Time frame was taken.
+    JSONBIND_FIELD(response_t, expiryTs, JSONBIND_INT64, true),     // ms timestamp, too big for an int.
+    JSONBIND_FIELD(response_t, correct, JSONBIND_BOOL, true),       // Is the answer correct?
+};
+
+// Session shit.
+struct netsession_s {
+    CURL* curl;     // Easy handle, kept alive so the connection gets reused.
+    cJSON_Arena* json;  // JSON responses are parsed into this, reset after each one.
+
+    // Progress of the current request, written by curl's thread and read by the wait screen.
+    const char* volatile stage;
+    volatile size_t bytesNow;
+    volatile size_t bytesTotal;
+    volatile unsigned int startedAt;    // Request counter when it started, the newest one names the stage.
+};
+
+CURLSH* __networking_share = NULL;              // DNS/TLS/connection cache shared by all sessions.
+mutex_t __networking_shareLocks[CURL_LOCK_DATA_LAST];
+netsession_t* __networking_session = NULL;      // Default session used by the API calls.
+netsession_t* __networking_sessions[NETWORKING_MAX_SESSIONS];
+mutex_t __networking_sessionsLock;
+unsigned int __networking_requestCounter = 0;
+
+// A blocking API call running on a worker while the main thread draws the wait screen.
+typedef struct {
+    bool (*func)(void* arg);
+    void* arg;
+    volatile bool done;
+    bool result;
+} netjob_t;
+
+// SD frame cache (write-behind).
+lwp_t __networking_cacheThread = LWP_THREAD_NULL;
+mutex_t __networking_cacheLock;
+cond_t __networking_cacheCond;
+const char* __networking_cachePath = NULL;      // NULL = don't cache frames.
+struct MemoryStruct __networking_cachePending;  // Copy of the last frame waiting to be written.
+
+// Makes sure a memory sink can hold at least `needed` bytes (+1 for the NUL).
+static bool __networking_reserve(struct MemoryStruct *mem, size_t needed) {
+    // Past this the +1 or the doubling below would wrap.
+    if(needed > SIZE_MAX / 2) {
+        return false;
+    }
+    if(needed + 1 <= mem->capacity) {
+        return true;
+    }
 
-// Thread for waiting.
-static void* __networking_waitingThreadFunc(void* arg) {
-    // Make the font.
-    GRRLIB_ttfFont* globalFont = GRRLIB_LoadTTF(segoe_slboot_ttf, segoe_slboot_ttf_size);
-
-    // The waiting BG.
-    GRRLIB_texImg* bgImg = GRRLIB_LoadTexture(wiibg_jpg);
-
-    // Spinner.
-    __networking_spinCur = __networking_spinStart;
-    int spinnerW = 0;
-
-    // Main loop.
-    while(true) {
-        if(__networking_isDoingNetworkOpetaion) {
-            /* Render waiting prompt */
-            // BG.
-            GRRLIB_DrawImg(0,0, bgImg, 0, 1,1, COL_WHITE);
-
-            char* loadChar = malloc(10);
-            sprintf(loadChar, "%lc", (int)__networking_spinCur);
-            spinnerW = GRRLIB_WidthTTF(globalFont, loadChar, 64);
-
-            // Text.
-            GRRLIB_PrintfTTF(0,0, globalFont, __networking_waitingText, 18, COL_GOLD);
-
-            // Load.
-            GRRLIB_PrintfTTF(((SCREEN_WIDTH/2) - (spinnerW/2)), ((SCREEN_HEIGHT/2) - (128/2)), globalFont, loadChar, 64, COL_WHITE);
+    // Grow geometrically so a chunked body doesn't realloc on every chunk.
+    size_t newCapacity = mem->capacity ? mem->capacity : 4096;
+    while(newCapacity < needed + 1) {
+        if(newCapacity > SIZE_MAX / 2) {
+            return false;
+        }
+        newCapacity *= 2;
+    }
 
-            // Free
-            free(loadChar);
+    char *ptr = realloc(mem->memory, newCapacity);
+    if(ptr == NULL) {
+        /* out of memory! */
+        printf("not enough memory (realloc returned NULL)\n");
+        return false;
+    }
 
-            // Update spinner.
-            __networking_spinCur+=0.5;
-            if(__networking_spinCur >= __networking_spinEnd) {
-                __networking_spinCur = __networking_spinStart;
-            }
+    mem->memory = ptr;
+    mem->capacity = newCapacity;
+    return true;
+}
 
-            // Render.
-            GRRLIB_Render();
+// Image IDs are UUIDs. Anything else (too long, or with characters that mean something in a URL) is refused.
+static bool __networking_validIid(const char* iid) {
+    size_t length = strlen(iid);
+    if(length == 0 || length > NETWORKING_MAX_IID) {
+        return false;
+    }
+    for(size_t i = 0; i < length; i++) {
+        char c = iid[i];
+        if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '_')) {
+            return false;
         }
-        usleep(THREAD_SLEEP_TIME);
     }
-    return NULL;
+    return true;
 }
 
 // Callback function to handle the response from curl
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+static size_t WriteMemoryCallback(char *contents, size_t size, size_t nmemb, void *userp) {
     size_t realsize = size * nmemb;
     struct MemoryStruct *mem = (struct MemoryStruct *)userp;
 
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if(ptr == NULL) {
-        /* out of memory! */
-        printf("not enough memory (realloc returned NULL)\n");
+    // Nothing the API sends is this big, don't let a bad server eat all the RAM.
+    if(realsize > NETWORKING_MAX_BODY - mem->size) {
+        printf("response too big (over %u bytes)\n", (unsigned int)NETWORKING_MAX_BODY);
+        return 0;
+    }
+    if(!__networking_reserve(mem, mem->size + realsize)) {
         return 0;
     }
 
-    mem->memory = ptr;
     memcpy(&(mem->memory[mem->size]), contents, realsize);
     mem->size += realsize;
     mem->memory[mem->size] = 0;
@@ -101,171 +169,676 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
     return realsize;
 }
 
-// Callback function to write received data to a file
-size_t write_data(void *ptr, size_t size, size_t nmemb, FILE *stream) {
-    size_t written = fwrite(ptr, size, nmemb, stream);
-    return written;
+// Callback that feeds the response straight into a streaming JSON parse.
+static size_t WriteJsonCallback(char *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    cJSON_Stream *stream = (cJSON_Stream *)userp;
+
+    // Bad JSON, no point downloading the rest.
+    if(!cJSON_StreamFeed(stream, contents, realsize)) {
+        return 0;
+    }
+    return realsize;
+}
+
+// Header callback, pre-sizes the memory sink from Content-Length.
+static size_t HeaderMemoryCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    size_t realsize = size * nitems;
+    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    const char* key = "content-length:";
+    size_t keyLen = strlen(key);
+
+    if(realsize > keyLen && strncasecmp(buffer, key, keyLen) == 0) {
+        unsigned long length = strtoul(buffer + keyLen, NULL, 10);
+
+        // Only a hint. Anything over the cap is left for WriteMemoryCallback to refuse.
+        if(length > 0 && mem->size <= NETWORKING_MAX_BODY && length <= NETWORKING_MAX_BODY - mem->size) {
+            __networking_reserve(mem, mem->size + length);
+        }
+    }
+    return realsize;
+}
+
+// Write-behind thread for the SD frame cache.
+static void* __networking_cacheThreadFunc(void* arg) {
+    while(true) {
+        LWP_MutexLock(__networking_cacheLock);
+        while(__networking_cachePending.memory == NULL) {
+            LWP_CondWait(__networking_cacheCond, __networking_cacheLock);
+        }
+        struct MemoryStruct job = __networking_cachePending;
+        __networking_cachePending.memory = NULL;
+        __networking_cachePending.size = 0;
+        const char* path = __networking_cachePath;
+        LWP_MutexUnlock(__networking_cacheLock);
+
+        if(path != NULL) {
+            FILE* fp = fopen(path, "wb");
+            if(fp != NULL) {
+                fwrite(job.memory, 1, job.size, fp);
+                fclose(fp);
+            }
+        }
+        free(job.memory);
+    }
+    return NULL;
+}
+
+// Share lock callbacks, curl calls these whenever it touches the shared cache.
+static void __networking_shareLock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp) {
+    LWP_MutexLock(__networking_shareLocks[data]);
+}
+static void __networking_shareUnlock(CURL* handle, curl_lock_data data, void* userp) {
+    LWP_MutexUnlock(__networking_shareLocks[data]);
+}
+
+// Progress callback, publishes how far along the session's request is.
+static int __networking_xferInfo(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    netsession_t* session = clientp;
+    session->bytesNow = (size_t)dlnow;
+    session->bytesTotal = (size_t)dltotal;
+    return 0;
+}
+
+// Runs a job on the worker thread.
+static void* __networking_jobThreadFunc(void* arg) {
+    netjob_t* job = arg;
+    job->result = job->func(job->arg);
+    job->done = true;
+    return NULL;
 }
 
 /**
  * @author Dakota Thorpe.
- * Starts networking threads and shit.
+ * Adds up what every session is downloading right now.
+ *
+ * @returns The progress. stage is NULL if nothing is downloading.
 */
-void Networking_Init() {
-    LWP_CreateThread(&__networking_waitingThread, __networking_waitingThreadFunc, NULL, NULL,0, LWP_PRIO_HIGHEST);
-    LWP_SuspendThread(__networking_waitingThread);
+netprogress_t Networking_GetProgress() {
+    netprogress_t progress = { NULL, 0, 0, 0 };
+    unsigned int newest = 0;
+
+    LWP_MutexLock(__networking_sessionsLock);
+    for(int i = 0; i < NETWORKING_MAX_SESSIONS; i++) {
+        netsession_t* session = __networking_sessions[i];
+        if(session == NULL || session->stage == NULL) {
+            continue;
+        }
+        progress.bytesNow += session->bytesNow;
+        progress.bytesTotal += session->bytesTotal;
+        progress.transfers++;
+        if(progress.stage == NULL || session->startedAt > newest) {
+            progress.stage = session->stage;
+            newest = session->startedAt;
+        }
+    }
+    LWP_MutexUnlock(__networking_sessionsLock);
+    return progress;
 }
 
 /**
  * @author Dakota Thorpe.
- * Gets an Image ID from the PonyGuessr API.
+ * Draws one frame of the please wait screen. Only call this from the main thread,
+ * it's the only one that renders.
+ *
+ * @param text The text shown in the corner.
 */
-char *get_image_id() {
-    CURL *curl;
+void Networking_DrawWaitFrame(const char* text) {
+    if(__networking_waitFont == NULL) {
+        // Kept for the whole run, the wait screen comes up every round.
+        __networking_waitFont = Assets_GetFont(segoe_slboot_ttf, segoe_slboot_ttf_size);
+        // The spinner goes through 121 big glyphs, which don't fit a normal atlas. Without
+        // its own it got cleared and re-uploaded every few frames.
+        Text_ReserveAtlas(__networking_waitFont, NETWORKING_SPINNER_SIZE, NETWORKING_SPINNER_ATLAS_W, NETWORKING_SPINNER_ATLAS_H);
+        __networking_waitBg = Assets_GetTexture(wiibg_jpg);
+        __networking_spinCur = __networking_spinStart;
+    }
+
+    // BG.
+    GRRLIB_DrawImg(0,0, __networking_waitBg, 0, 1,1, COL_WHITE);
+
+    // Text.
+    Text_Draw(0,0, __networking_waitFont, text, 18, COL_GOLD);
+
+    // Load.
+    char* loadChar = FrameArena_Alloc(5);
+    GlyphAtlas_EncodeUTF8((uint32_t)__networking_spinCur, loadChar);
+    int spinnerW = Text_Width(__networking_waitFont, loadChar, NETWORKING_SPINNER_SIZE);
+    Text_Draw(((SCREEN_WIDTH/2) - (spinnerW/2)), ((SCREEN_HEIGHT/2) - (128/2)), __networking_waitFont, loadChar, NETWORKING_SPINNER_SIZE, COL_WHITE);
+
+    // What the network is up to.
+    netprogress_t progress = Networking_GetProgress();
+    if(progress.stage != NULL) {
+        char* status;
+        if(progress.bytesTotal > 0) {
+            status = FrameArena_Printf("%s %u / %u KB", progress.stage, (unsigned int)(progress.bytesNow / 1024), (unsigned int)(progress.bytesTotal / 1024));
+        } else {
+            status = FrameArena_Printf("%s %u KB", progress.stage, (unsigned int)(progress.bytesNow / 1024));
+        }
+        int statusW = Text_Width(__networking_waitFont, status, 18);
+        Text_Draw(((SCREEN_WIDTH/2) - (statusW/2)), ((SCREEN_HEIGHT/2) + 64), __networking_waitFont, status, 18, COL_WHITE);
+    }
+
+    // Update spinner.
+    __networking_spinCur+=0.5;
+    if(__networking_spinCur >= __networking_spinEnd) {
+        __networking_spinCur = __networking_spinStart;
+    }
+
+    // Render.
+    CoreEngine_Render();
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Runs a blocking call on a worker thread and shows the please wait screen on this
+ * (the main) thread until it's done. The worker never touches GX.
+ *
+ * @param text The text shown in the corner.
+ * @param func The call. Runs on the worker.
+ * @param arg Passed to func.
+ *
+ * @returns What func returned.
+*/
+bool Networking_RunBlocking(const char* text, bool (*func)(void* arg), void* arg) {
+    netjob_t job;
+    job.func = func;
+    job.arg = arg;
+    job.done = false;
+    job.result = false;
+
+    lwp_t thread;
+    if(LWP_CreateThread(&thread, __networking_jobThreadFunc, &job, NULL, NETWORKING_JOB_STACK, NETWORKING_JOB_PRIO) < 0) {
+        // No thread, just do it here without the wait screen.
+        return func(arg);
+    }
+
+    while(!job.done) {
+        Networking_DrawWaitFrame(text);
+    }
+    LWP_JoinThread(thread, NULL);
+    return job.result;
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Runs a GET request on a session and appends the body to a memory sink.
+ * The sink is pre-sized from Content-Length when the server sends one. The handle
+ * stays open afterwards so the next request reuses the connection (and TLS session).
+ *
+ * @param session The session to use.
+ * @param stage What this request is, for the wait screen.
+ * @param url The URL to fetch.
+ * @param mem The memory sink. Existing allocation is reused.
+ *
+ * @returns The curl result code.
+*/
+static CURLcode __networking_getToMemory(netsession_t* session, const char* stage, const char* url, struct MemoryStruct* mem) {
+    // Show up on the wait screen.
+    session->bytesNow = 0;
+    session->bytesTotal = 0;
+    LWP_MutexLock(__networking_sessionsLock);   // Fetch threads start requests at the same time.
+    session->startedAt = ++__networking_requestCounter;
+    LWP_MutexUnlock(__networking_sessionsLock);
+    session->stage = stage;
+
+    curl_easy_setopt(session->curl, CURLOPT_URL, url);
+    curl_easy_setopt(session->curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(session->curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(session->curl, CURLOPT_WRITEDATA, (void *)mem);
+    curl_easy_setopt(session->curl, CURLOPT_HEADERFUNCTION, HeaderMemoryCallback);
+    curl_easy_setopt(session->curl, CURLOPT_HEADERDATA, (void *)mem);
     CURLcode res;
-    struct MemoryStruct chunk;
+    PROFILE_CALL("curl_easy_perform", res = curl_easy_perform(session->curl));
+
+    session->stage = NULL;
+    return res;
+}
 
-    // Set waiting text.
-    __networking_isDoingNetworkOpetaion = true;
-    __networking_waitingText = malloc(100);
-    sprintf(__networking_waitingText, "Please Wait. Getting IID.");
+/**
+ * @author Dakota Thorpe.
+ * Checks the HTTP status of the session's last request. Error pages come back as a
+ * normal body, so curl alone calls them a success.
+ *
+ * @param session The session that ran the request.
+ * @param errText Gets an error message if the status isn't 2xx.
+ * @param errSize Size of errText.
+ *
+ * @returns true if the server answered 2xx.
+*/
+static bool __networking_checkStatus(netsession_t* session, char* errText, size_t errSize) {
+    long code = 0;
+    curl_easy_getinfo(session->curl, CURLINFO_RESPONSE_CODE, &code);
+    if(code < 200 || code > 299) {
+        snprintf(errText, errSize, "The server answered HTTP %ld.", code);
+        return false;
+    }
+    return true;
+}
 
-    chunk.memory = malloc(1);  // will be grown as needed by realloc
-    chunk.size = 0;             // no data at this point
+/**
+ * @author Dakota Thorpe.
+ * Runs a GET request on a session and parses the body as JSON while it downloads,
+ * so the response is never held in one piece. The tree lives in the session's arena,
+ * so there's no per node malloc.
+ *
+ * @param session The session to use.
+ * @param stage What this request is, for the wait screen.
+ * @param url The URL to fetch.
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns The parsed response, or NULL on failure. Hand it back with cJSON_ResetArena(session->json)
+ * once you've read it, and before the session's next request.
+*/
+static cJSON* __networking_getToJson(netsession_t* session, const char* stage, const char* url, char* errText, size_t errSize) {
+    cJSON_Stream* stream = cJSON_CreateStreamInArena(session->json);
+    if(stream == NULL) {
+        snprintf(errText, errSize, "Not enough memory to parse the response.");
+        return NULL;
+    }
 
-    // Create a URL.
-    char* reqUrl = malloc(1024);
-    sprintf(reqUrl, "%s/resource/gen?runId&subtitles=false&audioLength=10&resourceType=frame", API_BASE);
-
-    // Resume thread.
-    LWP_ResumeThread(__networking_waitingThread);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, reqUrl);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-        res = curl_easy_perform(curl);
-        if(res != CURLE_OK) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "curl_easy_perform() failed: %s", curl_easy_strerror(res));
-            showErrorScreen(errText);
-            return NULL;
+    // Show up on the wait screen.
+    session->bytesNow = 0;
+    session->bytesTotal = 0;
+    LWP_MutexLock(__networking_sessionsLock);   // Fetch threads start requests at the same time.
+    session->startedAt = ++__networking_requestCounter;
+    LWP_MutexUnlock(__networking_sessionsLock);
+    session->stage = stage;
+
+    curl_easy_setopt(session->curl, CURLOPT_URL, url);
+    curl_easy_setopt(session->curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(session->curl, CURLOPT_WRITEFUNCTION, WriteJsonCallback);
+    curl_easy_setopt(session->curl, CURLOPT_WRITEDATA, (void *)stream);
+    curl_easy_setopt(session->curl, CURLOPT_HEADERFUNCTION, NULL);   // Nothing to pre-size.
+    curl_easy_setopt(session->curl, CURLOPT_HEADERDATA, NULL);
+    CURLcode res;
+    PROFILE_CALL("curl_easy_perform", res = curl_easy_perform(session->curl));
+    session->stage = NULL;
+
+    cJSON* root = NULL;
+    if((res == CURLE_OK || res == CURLE_WRITE_ERROR) && !__networking_checkStatus(session, errText, errSize)) {
+        // An error page, which likely isn't JSON either. The status says more than the parse error.
+    } else if(res == CURLE_WRITE_ERROR) {
+        // The write callback bailed, so it's the JSON that's broken, not the network.
+        snprintf(errText, errSize, "Error parsing JSON at byte %lu.", (unsigned long)cJSON_StreamErrorOffset(stream));
+    } else if(res != CURLE_OK) {
+        snprintf(errText, errSize, "curl_easy_perform() failed: %s", curl_easy_strerror(res));
+    } else {
+        root = cJSON_StreamFinish(stream);
+        if(root == NULL) {
+            snprintf(errText, errSize, "Error parsing JSON at byte %lu.", (unsigned long)cJSON_StreamErrorOffset(stream));
+        }
+    }
+
+    cJSON_DeleteStream(stream);
+    if(root == NULL) {
+        cJSON_ResetArena(session->json);
+    }
+    return root;
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Creates a networking session. Every session shares the DNS, TLS session and
+ * connection caches. A session must only be used by one thread at a time.
+ *
+ * @returns The new session, or NULL if curl could not make a handle.
+*/
+netsession_t* Networking_CreateSession() {
+    netsession_t* session = malloc(sizeof(netsession_t));
+    if(session == NULL) {
+        return NULL;
+    }
+
+    session->curl = curl_easy_init();
+    if(session->curl == NULL) {
+        free(session);
+        return NULL;
+    }
+
+    session->json = cJSON_CreateArena(NETWORKING_JSON_ARENA);
+    if(session->json == NULL) {
+        curl_easy_cleanup(session->curl);
+        free(session);
+        return NULL;
+    }
+
+    curl_easy_setopt(session->curl, CURLOPT_SHARE, __networking_share);
+    curl_easy_setopt(session->curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(session->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(session->curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(session->curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    curl_easy_setopt(session->curl, CURLOPT_NOSIGNAL, 1L);
+
+    // Progress for the wait screen.
+    session->stage = NULL;
+    session->bytesNow = 0;
+    session->bytesTotal = 0;
+    session->startedAt = 0;
+    curl_easy_setopt(session->curl, CURLOPT_XFERINFOFUNCTION, __networking_xferInfo);
+    curl_easy_setopt(session->curl, CURLOPT_XFERINFODATA, session);
+    curl_easy_setopt(session->curl, CURLOPT_NOPROGRESS, 0L);
+
+    LWP_MutexLock(__networking_sessionsLock);
+    for(int i = 0; i < NETWORKING_MAX_SESSIONS; i++) {
+        if(__networking_sessions[i] == NULL) {
+            __networking_sessions[i] = session;
+            break;
         }
+    }
+    LWP_MutexUnlock(__networking_sessionsLock);
+    return session;
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Closes a session made with Networking_CreateSession.
+ *
+ * @param session The session to close.
+*/
+void Networking_DestroySession(netsession_t* session) {
+    if(session == NULL) {
+        return;
+    }
 
-        // Parse JSON response using cJSON
-        cJSON *root = cJSON_Parse(chunk.memory);
-        if (root == NULL) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "Error parsing JSON: %s", cJSON_GetErrorPtr());
-            showErrorScreen(errText);
-            return NULL;
+    LWP_MutexLock(__networking_sessionsLock);
+    for(int i = 0; i < NETWORKING_MAX_SESSIONS; i++) {
+        if(__networking_sessions[i] == session) {
+            __networking_sessions[i] = NULL;
         }
+    }
+    LWP_MutexUnlock(__networking_sessionsLock);
 
-        cJSON *id = cJSON_GetObjectItem(root, "id");
-        if (cJSON_IsString(id)) {
-            char *image_id = strdup(id->valuestring);
-            cJSON_Delete(root);
-            curl_easy_cleanup(curl);
-            free(chunk.memory);
-            return image_id;
-        } else {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errTxt = malloc(256);
-            sprintf(errTxt, "Error: 'id' field not found or not a string");
-            cJSON_Delete(root);
-            curl_easy_cleanup(curl);
-            free(chunk.memory);
-            showErrorScreen(errTxt);
-            return NULL;
+    curl_easy_cleanup(session->curl);
+    cJSON_DeleteArena(session->json);
+    free(session);
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Sets up networking shit. Also sets up curl once for the whole run, so the
+ * API calls don't redo the global init and TLS handshake every time.
+*/
+void Networking_Init() {
+    LWP_MutexInit(&__networking_sessionsLock, false);
+
+    // Global curl init. Only done once.
+    CURLcode res = curl_global_init(CURL_GLOBAL_ALL);
+    if(res != CURLE_OK) {
+        showErrorScreen("curl_global_init() failed.");
+    }
+
+    // Shared cache.
+    for(int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        LWP_MutexInit(&__networking_shareLocks[i], false);
+    }
+    __networking_share = curl_share_init();
+    if(__networking_share != NULL) {
+        curl_share_setopt(__networking_share, CURLSHOPT_LOCKFUNC, __networking_shareLock);
+        curl_share_setopt(__networking_share, CURLSHOPT_UNLOCKFUNC, __networking_shareUnlock);
+        curl_share_setopt(__networking_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(__networking_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(__networking_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    // Frame cache.
+    LWP_MutexInit(&__networking_cacheLock, false);
+    LWP_CondInit(&__networking_cacheCond);
+
+    // Point somewhere else (like tools/mockserver.py) if asked to.
+    const char* apiBase = getenv(API_BASE_ENV);
+    if(apiBase != NULL && apiBase[0] != '\0') {
+        Networking_SetApiBase(apiBase);
+    } else {
+        FILE* fp = fopen(API_BASE_FILE, "r");
+        if(fp != NULL) {
+            char line[sizeof(__networking_apiBase)];
+            if(fgets(line, sizeof(line), fp) != NULL) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if(line[0] != '\0') {
+                    Networking_SetApiBase(line);
+                }
+            }
+            fclose(fp);
         }
     }
 
-    curl_global_cleanup();
-    free(reqUrl);
-    free(__networking_waitingText);
-    LWP_SuspendThread(__networking_waitingThread);
-    __networking_isDoingNetworkOpetaion = false;
-    return NULL;
+    // Default session.
+    __networking_session = Networking_CreateSession();
+    if(__networking_session == NULL) {
+        showErrorScreen("curl_easy_init() failed.");
+    }
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Changes where the API calls go. Networking_Init already picks this up from
+ * API_BASE_ENV or API_BASE_FILE, so this is for anything that needs to switch later.
+ * Don't call it while requests are running.
+ *
+ * @param url Base URL with no trailing slash, e.g. "http://192.168.1.10:8080/api".
+*/
+void Networking_SetApiBase(const char* url) {
+    snprintf(__networking_apiBase, sizeof(__networking_apiBase), "%s", url);
+
+    // "/api/" and "/api" are the same thing.
+    size_t length = strlen(__networking_apiBase);
+    while(length > 0 && __networking_apiBase[length - 1] == '/') {
+        __networking_apiBase[--length] = '\0';
+    }
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Gets where the API calls go.
+*/
+const char* Networking_GetApiBase() {
+    return __networking_apiBase;
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Gets an Image ID from the PonyGuessr API. Doesn't touch the screen, so it's
+ * safe to call from any thread that owns the session.
+ *
+ * @param session The session to use.
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns The image ID (free it), or NULL on failure.
+*/
+char* Networking_GetImageId(netsession_t* session, char* errText, size_t errSize) {
+    // Create a URL.
+    char reqUrl[1024];
+    if(snprintf(reqUrl, sizeof(reqUrl), "%s/resource/gen?runId&subtitles=false&audioLength=10&resourceType=frame", __networking_apiBase) >= (int)sizeof(reqUrl)) {
+        snprintf(errText, errSize, "The API URL is too long.");
+        return NULL;
+    }
+
+    // Parsed as it comes in.
+    cJSON *root = __networking_getToJson(session, "Getting IID.", reqUrl, errText, errSize);
+    if (root == NULL) {
+        return NULL;
+    }
+
+    genresponse_t gen = { NULL };
+    char bindErr[128];
+    bool ok = JsonBind_Object(root, __networking_genFields, sizeof(__networking_genFields) / sizeof(jsonbind_field_t), &gen, bindErr, sizeof(bindErr));
+    cJSON_ResetArena(session->json);
+    if (!ok) {
+        snprintf(errText, errSize, "Bad IID response: %s", bindErr);
+        return NULL;
+    }
+
+    // It goes into URLs, so only take what an ID looks like.
+    if (!__networking_validIid(gen.id)) {
+        snprintf(errText, errSize, "Bad IID response: id isn't a valid ID.");
+        free(gen.id);
+        return NULL;
+    }
+    return gen.id;
 }
 
 /**
  * @author Dakota Thorpe
- * Downloads the generated frame from PonyGuessr.
- * 
+ * Downloads a generated frame into memory. Doesn't touch the screen, so it's
+ * safe to call from any thread that owns the session.
+ *
+ * @param session The session to use.
  * @param iid The UUID of the generated image.
+ * @param frame Memory sink for the PNG. Its buffer is reused (and grown if needed).
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns true if the frame was downloaded.
 */
-void downloadImage(char* iid) {
-    CURL *curl;
-    FILE *fp;
-    CURLcode res;
+bool Networking_DownloadFrame(netsession_t* session, const char* iid, struct MemoryStruct* frame, char* errText, size_t errSize) {
+    // Create the link.
+    char reqUrl[1024];
+    if(snprintf(reqUrl, sizeof(reqUrl), "%s/resource/get/%s.png", __networking_apiBase, iid) >= (int)sizeof(reqUrl)) {
+        snprintf(errText, errSize, "The frame URL is too long.");
+        return false;
+    }
 
-    // Set waiting text.
-    __networking_isDoingNetworkOpetaion = true;
-    __networking_waitingText = malloc(100);
-    sprintf(__networking_waitingText, "Please wait. Downloading Pony Frame.");
+    // Perform the request
+    frame->size = 0;
+    CURLcode res = __networking_getToMemory(session, "Downloading Pony Frame.", reqUrl, frame);
+    if ((res == CURLE_OK || res == CURLE_WRITE_ERROR) && !__networking_checkStatus(session, errText, errSize)) {
+        frame->size = 0;    // The error page, not a frame.
+        return false;
+    } else if (res == CURLE_WRITE_ERROR) {
+        // The write callback bailed.
+        snprintf(errText, errSize, "Frame too big or out of memory (limit %u KB).", (unsigned int)(NETWORKING_MAX_BODY / 1024));
+        return false;
+    } else if (res != CURLE_OK) {
+        snprintf(errText, errSize, "curl_easy_perform() failed: %s", curl_easy_strerror(res));
+        return false;
+    }
 
-    // Create the link.
-    char *reqUrl = malloc(1024);
-    sprintf(reqUrl, "%s/resource/get/%s.png", API_BASE, iid);
-
-    // Output file.
-    const char *output_filename = "sd:/ponyFrame.png";
-
-    // Resume thread.
-    LWP_ResumeThread(__networking_waitingThread);
-
-    // Initialize cURL
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-    if (curl) {
-        // Open file for writing
-        fp = fopen(output_filename, "wb");
-        if (fp == NULL) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "Error opening file %s", output_filename);
-            showErrorScreen(errText);
-            return NULL;
-        }
+    // Write it to the SD in the background, if wanted.
+    Networking_CacheFrame(frame);
+    return true;
+}
 
-        curl_easy_setopt(curl, CURLOPT_URL, reqUrl);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-
-        // Perform the request
-        res = curl_easy_perform(curl);
-
-        // Check for errors
-        if (res != CURLE_OK) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "curl_easy_perform() failed: %s", curl_easy_strerror(res));
-            showErrorScreen(errText);
-            return NULL;
-        }
+// Arguments for the blocking API calls, run on the job thread.
+typedef struct {
+    const char* iid;
+    int season;
+    int episode;
+    struct MemoryStruct* frame;
+    char* imageId;
+    response_t response;
+    char errText[256];
+} netcall_t;
+
+static bool __networking_getImageIdJob(void* arg) {
+    netcall_t* call = arg;
+    call->imageId = Networking_GetImageId(__networking_session, call->errText, sizeof(call->errText));
+    return call->imageId != NULL;
+}
+
+static bool __networking_downloadFrameJob(void* arg) {
+    netcall_t* call = arg;
+    return Networking_DownloadFrame(__networking_session, call->iid, call->frame, call->errText, sizeof(call->errText));
+}
+
+static bool __networking_checkAnswerJob(void* arg) {
+    netcall_t* call = arg;
+    return Networking_CheckAnswer(__networking_session, call->season, call->episode, call->iid, &call->response, call->errText, sizeof(call->errText));
+}
+
+/**
+ * @author Dakota Thorpe.
+ * Gets an Image ID from the PonyGuessr API.
+*/
+char *get_image_id() {
+    netcall_t call;
+    memset(&call, 0, sizeof(netcall_t));
 
-        // Clean up
-        curl_easy_cleanup(curl);
-        fclose(fp);
+    if(!Networking_RunBlocking("Please Wait. Getting IID.", __networking_getImageIdJob, &call)) {
+        showErrorScreen(call.errText);
+        return NULL;
     }
+    return call.imageId;
+}
 
-    // Cleanup global cURL
-    curl_global_cleanup();
-    free(__networking_waitingText);
-    free(reqUrl);
-    LWP_SuspendThread(__networking_waitingThread);
-    __networking_isDoingNetworkOpetaion = false;
+/**
+ * @author Dakota Thorpe
+ * Downloads the generated frame from PonyGuessr straight into memory.
+ * 
+ * @param iid The UUID of the generated image.
+ * @param frame Memory sink for the PNG. Its buffer is reused (and grown if needed), so
+ * keep it around between rounds. frame->size is the PNG size afterwards.
+*/
+void downloadImage(char* iid, struct MemoryStruct* frame) {
+    netcall_t call;
+    memset(&call, 0, sizeof(netcall_t));
+    call.iid = iid;
+    call.frame = frame;
+
+    if(!Networking_RunBlocking("Please wait. Downloading Pony Frame.", __networking_downloadFrameJob, &call)) {
+        showErrorScreen(call.errText);
+    }
+}
+
+/**
+ * @author Dakota Thorpe
+ * Sets where downloaded frames get cached on the SD. The write happens on a
+ * background thread after the download, so it never holds up a round.
+ *
+ * @param path File to write frames to, or NULL to turn the cache off (default).
+*/
+void Networking_SetFrameCache(const char* path) {
+    LWP_MutexLock(__networking_cacheLock);
+    __networking_cachePath = path;
+    LWP_MutexUnlock(__networking_cacheLock);
+
+    if(path != NULL && __networking_cacheThread == LWP_THREAD_NULL) {
+        LWP_CreateThread(&__networking_cacheThread, __networking_cacheThreadFunc, NULL, NULL, 0, LWP_PRIO_IDLE + 1);
+    }
+}
+
+/**
+ * @author Dakota Thorpe
+ * Queues a copy of a frame for the SD cache. Does nothing if the cache is off.
+ * If a write is already pending, it's replaced by this one.
+ *
+ * @param frame The frame to cache.
+*/
+void Networking_CacheFrame(const struct MemoryStruct* frame) {
+    if(__networking_cachePath == NULL || frame->size == 0) {
+        return;
+    }
+
+    char* copy = malloc(frame->size);
+    if(copy == NULL) {
+        return; // It's just a cache.
+    }
+    memcpy(copy, frame->memory, frame->size);
+
+    LWP_MutexLock(__networking_cacheLock);
+    free(__networking_cachePending.memory);
+    __networking_cachePending.memory = copy;
+    __networking_cachePending.size = frame->size;
+    LWP_CondSignal(__networking_cacheCond);
+    LWP_MutexUnlock(__networking_cacheLock);
 }
 
 /**
  * @author Dakota Thorpe.
- * Checks to see if you were correct.
+ * Checks to see if you were correct. Doesn't touch the screen, so it's safe to
+ * call from any thread that owns the session.
+ *
+ * @param session The session to use.
+ * @param season Guessed season.
+ * @param episode Guessed episode.
+ * @param iid The UUID of the image being guessed.
+ * @param response Gets the answer.
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns true if the server answered.
 */
 // https://ponyguessr.com/api/resource/{imageId}/check?season={session}&episode={episode}.
 // One time call. Cannot be called twice.
@@ -279,103 +852,46 @@ Returns like:
     "correct": false
 }
 */
-response_t checkCorrect(int season, int episode, char* iid) {
-    // Create a blank response.
-    response_t apiResponse;
-
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct chunk;
-
-    // Set waiting text.
-    __networking_isDoingNetworkOpetaion = true;
-    __networking_waitingText = malloc(100);
-    sprintf(__networking_waitingText, "Please Wait. Checking your answer.");
-
-    chunk.memory = malloc(1);  // will be grown as needed by realloc
-    chunk.size = 0;             // no data at this point
+bool Networking_CheckAnswer(netsession_t* session, int season, int episode, const char* iid, response_t* response, char* errText, size_t errSize) {
+    memset(response, 0, sizeof(response_t));
 
     // Create a URL.
-    char* reqUrl = malloc(1024);
-    sprintf(reqUrl, "%s/resource/%s/check?season=%d&episode=%d", API_BASE, iid, season, episode);
-
-    // Resume thread.
-    LWP_ResumeThread(__networking_waitingThread);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, reqUrl);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-        res = curl_easy_perform(curl);
-        if(res != CURLE_OK) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "curl_easy_perform() failed: %s", curl_easy_strerror(res));
-            showErrorScreen(errText);
-            return apiResponse;
-        }
+    char reqUrl[1024];
+    if(snprintf(reqUrl, sizeof(reqUrl), "%s/resource/%s/check?season=%d&episode=%d", __networking_apiBase, iid, season, episode) >= (int)sizeof(reqUrl)) {
+        snprintf(errText, errSize, "The check URL is too long.");
+        return false;
+    }
 
-        // Parse JSON response using cJSON
-        cJSON *root = cJSON_Parse(chunk.memory);
-        if (root == NULL) {
-            __networking_isDoingNetworkOpetaion = false;
-            char* errText = malloc(256);
-            sprintf(errText, "Error parsing JSON: %s", cJSON_GetErrorPtr());
-            showErrorScreen(errText);
-            return apiResponse;
-        }
+    // Parsed as it comes in.
+    cJSON *root = __networking_getToJson(session, "Checking your answer.", reqUrl, errText, errSize);
+    if (root == NULL) {
+        return false;
+    }
 
-        cJSON *cSeason = cJSON_GetObjectItem(root, "season");       // Correct season.
-        cJSON *cEpisode = cJSON_GetObjectItem(root, "episode");     // Correct episode.
-        cJSON *seekTime = cJSON_GetObjectItem(root, "seekTime");    // Time frame was taken.
-        cJSON *expiryTs = cJSON_GetObjectItem(root, "expiryTs");    // ?
-        cJSON *isCorrect = cJSON_GetObjectItem(root, "correct");    // Is the answer correct?
-
-        // A bunch of checks just because ERROR HANDLING DAMNIT.
-        if (cJSON_IsNumber(cSeason) && cJSON_IsNumber(cEpisode) && cJSON_IsNumber(seekTime) && cJSON_IsNumber(expiryTs) && cJSON_IsBool(isCorrect)) {
-            // Set the data (but in the machine this time).
-            int mSeason = cSeason->valueint;
-            int mEpisode = cEpisode->valueint;
-            float mSeekTime = (float)seekTime->valuedouble; // I have an odd feeling that this is gonna be set like X.XX instead of X.XXXXXXXXX.
-            int mExpiryTs = expiryTs->valueint;
-            bool mCorrect = cJSON_IsTrue(isCorrect);
-
-            // Set the data.
-            apiResponse.season = mSeason;
-            apiResponse.episode = mEpisode;
-            apiResponse.seekTime = mSeekTime;
-            apiResponse.expiryTs = mExpiryTs;
-            apiResponse.correct = mCorrect;
-
-            cJSON_Delete(root);
-            curl_easy_cleanup(curl);
-            free(chunk.memory);
-
-            LWP_SuspendThread(__networking_waitingThread);
-            __networking_isDoingNetworkOpetaion = false;
-
-            return apiResponse;
-        } else {
-            __networking_isDoingNetworkOpetaion = false;
-            LWP_SuspendThread(__networking_waitingThread);
-
-            char* errTxt = malloc(256);
-            sprintf(errTxt, "Error: 'id' field not found or not a string");
-            cJSON_Delete(root);
-            curl_easy_cleanup(curl);
-            free(chunk.memory);
-            showErrorScreen(errTxt);
-            return apiResponse;
-        }
+    // Straight into the response, with ERROR HANDLING DAMNIT.
+    char bindErr[128];
+    bool ok = JsonBind_Object(root, __networking_checkFields, sizeof(__networking_checkFields) / sizeof(jsonbind_field_t), response, bindErr, sizeof(bindErr));
+    cJSON_ResetArena(session->json);
+    if (!ok) {
+        snprintf(errText, errSize, "Bad check response: %s", bindErr);
+        return false;
     }
+    return true;
+}
 
-    curl_global_cleanup();
-    free(reqUrl);
-    free(__networking_waitingText);
-    LWP_SuspendThread(__networking_waitingThread);
-    __networking_isDoingNetworkOpetaion = false;
-    return apiResponse;
-}
\ No newline at end of file
+/**
+ * @author Dakota Thorpe.
+ * Checks to see if you were correct, showing the wait screen while it does.
+*/
+response_t checkCorrect(int season, int episode, char* iid) {
+    netcall_t call;
+    memset(&call, 0, sizeof(netcall_t));
+    call.iid = iid;
+    call.season = season;
+    call.episode = episode;
+
+    if(!Networking_RunBlocking("Please Wait. Checking your answer.", __networking_checkAnswerJob, &call)) {
+        showErrorScreen(call.errText);
+    }
+    return call.response;
+}
@@ -17,14 +17,16 @@
 
 // Our #1 graphics library.
 #include <grrlib.h>
-#include <pngu.h>
 
 // OGG Player lib.
 #include "oggplayer.h"
 
 // core.
 #include "rend/osk.h"
+#include "rend/text.h"
+#include "rend/framearena.h"
 #include "rend/audio.h"
+#include "rend/assets.h"
 #include "rend/buttons.h"
 #include "rend/coreEngine.h"
 #include "misc/carhorn_defs.h"
@@ -44,6 +46,15 @@
 #include "app_funcs.h"
 #include "misc/utils.h"
 #include "misc/networking.h"
+#include "misc/prefetch.h"
+#include "misc/roundpack.h"
+#include "misc/stats.h"
+
+// Offline round pack, used instead of the network if it exists.
+#define ROUNDPACK_PATH "sd:/ponii/roundpack.zip"
+
+// Score, kept between sessions.
+#define STATS_PATH "sd:/ponii/stats.json"
 
 // Main loop callback vars.
 bool readytoGuess = false;
@@ -51,7 +62,7 @@ bool yesClicked = false;
 bool noClicked = false;
 
 // Other screens.
-void gameStatus(GRRLIB_texImg* guessedImg, response_t answer);
+bool gameStatus(GRRLIB_texImg* guessedImg, response_t answer, const stats_t* stats);
 
 // Exit function.
 void onclickExit(int argc, char** argv) {
@@ -84,10 +95,10 @@ int main(int argc, char** argv)
     GRRLIB_ttfFont* globalFont;
 
     // Font.
-    globalFont = GRRLIB_LoadTTF(font_ttf, font_ttf_size);
+    globalFont = Assets_GetFont(font_ttf, font_ttf_size);
 
     // Cursor
-    GRRLIB_texImg* cursor = GRRLIB_LoadTexture(cursor_png);
+    GRRLIB_texImg* cursor = Assets_GetTexture(cursor_png);
     Size cSize;
     cSize.w = cursor->w;
     cSize.h = cursor->h;
@@ -116,69 +127,30 @@ int main(int argc, char** argv)
     int season = 0;//getNumInput("Select the Season guess:");
     int episode = 0;//getNumInput("Select the Episode guess:");
 
-    // Get an image ID.
-    char* imgId = get_image_id(); // Prone to fuck up.
-
-    // Download the image.
-    downloadImage(imgId);
+    // Score so far.
+    stats_t stats;
+    Stats_Load(STATS_PATH, &stats);
 
-    // Try to load in the frame.
-    FILE* frameLoad = fopen("sd:/ponyFrame.png", "rb");
-    if(frameLoad == NULL) {
-        showErrorScreen("FILE* frameLoad was NIL");
-    }
-
-    // Try to load it into ram.
-    int frmSize;
-    fseek(frameLoad, 0, SEEK_END);
-    frmSize = ftell(frameLoad);
-    fseek(frameLoad, 0, SEEK_SET);
+    // Play offline if there's a round pack on the SD.
+    prefetch_config_t prefetchConfig = Prefetch_DefaultConfig();
+    char errText[256];
+    prefetchConfig.pack = RoundPack_Open(ROUNDPACK_PATH, errText, sizeof(errText));
 
-    // Create a buffer for it.
-    void* frmBuff = malloc(frmSize);
-    if(frmBuff == NULL) {
-        showErrorScreen("Could not allocate buffer for frame.");
-    }
+    // Start fetching rounds in the background.
+    Prefetch_Start(prefetchConfig);
 
-    // Read into buffer.
-    fread(frmBuff, frmSize, 1, frameLoad);
-
-    // Close file.
-    fclose(frameLoad);
-
-    // Quick fix for grrlib issue.
-    PNGUPROP imgProp;
-    IMGCTX ctx = PNGU_SelectImageFromBuffer(frmBuff);
-    PNGU_GetImageProperties(ctx, &imgProp);
-    int pngW,pngH;
-    pngW = imgProp.imgWidth;
-    pngH = imgProp.imgHeight;
-    GRRLIB_texImg *my_texture = calloc(1, sizeof(GRRLIB_texImg));
-    if (my_texture == NULL) {
-        return NULL;
+    // Get the first round.
+    round_t round;
+    if(!Prefetch_Pop(&round, errText, sizeof(errText))) {
+        showErrorScreen(errText);
     }
-    my_texture->data = PNGU_DecodeTo4x4RGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &pngW, &pngH);
-    if (my_texture->data != NULL) {
-        my_texture->w = pngW;
-        my_texture->h = pngH;
-        //my_texture->format = GX_TF_RGBA8;
-        GRRLIB_SetHandle( my_texture, 0, 0 );
-        if (imgProp.imgWidth != pngW || imgProp.imgHeight != pngH) {
-            // PNGU has resized the texture
-            //memset(my_texture->data, 0, (my_texture->h * my_texture->w) << 2);
-        }
-        GRRLIB_FlushTex( my_texture );
-    }
-    PNGU_ReleaseImageContext(ctx);
-
-    // Free old buffer?
-    free(frmBuff);
+    GRRLIB_texImg* my_texture = round.frame;
     
     // Main Loop.
     while(true)
     {
         // Scan for button presses.
-        WPAD_ScanPads();
+        CoreEngine_ScanPads();
         WPAD_IR(WPAD_CHAN_0, &ir);
 
         s32 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
@@ -196,19 +168,19 @@ int main(int argc, char** argv)
         GRRLIB_DrawImg(frmX,frmY, my_texture, 0, 0.5,0.5, COL_WHITE);
 
         // Welcome
-        GRRLIB_PrintfTTF(0,0, globalFont, "Welcome to PONiiGuesser Wii!", 30, COL_WHITE);
+        Text_Draw(0,0, globalFont, "Welcome to PONiiGuesser Wii!", 30, COL_WHITE);
 
         // Exit button.
-        renderSpritedButton(exitBtn);
+        renderSpritedButton(&exitBtn);
         checkButtonStatus(&exitBtn, ir.x,ir.y, cSize, pressed);
 
         // Guess button.
-        renderSpritedButton(guessBtn);
+        renderSpritedButton(&guessBtn);
         checkButtonStatus(&guessBtn, ir.x,ir.y, cSize, pressed); 
 
         // update.
         GRRLIB_DrawImg(ir.x,ir.y, cursor, 0, 1,1, 0xFFFFFFFF);
-        GRRLIB_Render();
+        CoreEngine_Render();
 
         // Main loop callback checks.
         if(readytoGuess) {
@@ -220,7 +192,7 @@ int main(int argc, char** argv)
             // Confirm.
             while (true)
             {
-                WPAD_ScanPads();
+                CoreEngine_ScanPads();
                 WPAD_IR(WPAD_CHAN_0, &ir);
 
                 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
@@ -229,20 +201,18 @@ int main(int argc, char** argv)
                 GRRLIB_DrawImg(frmX,frmY, my_texture, 0, 0.5,0.5, COL_WHITE);
 
                 // Confirm text.
-                char* confirmText = malloc(100);
-                sprintf(confirmText, "You guessed: S%dE%d. Is this your final?", season, episode);
-                GRRLIB_PrintfTTF(0,0, globalFont, confirmText, 30, COL_WHITE);
-                free(confirmText);
+                char* confirmText = FrameArena_Printf("You guessed: S%dE%d. Is this your final?", season, episode);
+                Text_Draw(0,0, globalFont, confirmText, 30, COL_WHITE);
 
                 // Yes/No button.
-                renderSpritedButton(yesBtn);
-                renderSpritedButton(noBtn);
+                renderSpritedButton(&yesBtn);
+                renderSpritedButton(&noBtn);
                 checkButtonStatus(&yesBtn, ir.x,ir.y, cSize, pressed); 
                 checkButtonStatus(&noBtn, ir.x,ir.y, cSize, pressed);
 
                 // Render.
                 GRRLIB_DrawImg(ir.x,ir.y, cursor, 0, 1,1, 0xFFFFFFFF);
-                GRRLIB_Render();
+                CoreEngine_Render();
 
                 if(noClicked) {
                     season = getNumInput("Select the Season guess:");
@@ -250,7 +220,11 @@ int main(int argc, char** argv)
                 }
 
                 if(yesClicked) {
-                    isCorr = checkCorrect(season, episode, imgId);
+                    if(round.offline) {
+                        isCorr = RoundPack_Check(&round.answer, season, episode);
+                    } else {
+                        isCorr = checkCorrect(season, episode, round.iid);
+                    }
                     break;
                 }
 
@@ -259,8 +233,23 @@ int main(int argc, char** argv)
                 noClicked = false;
             }
 
+            // Save the score every round, in case the power goes.
+            Stats_AddRound(&stats, isCorr.correct);
+            Stats_Save(STATS_PATH, &stats);
+
             // Answer.
-            gameStatus(my_texture, isCorr);
+            yesClicked = false;
+            bool playAgain = gameStatus(my_texture, isCorr, &stats);
+            if(!playAgain) {
+                break;
+            }
+
+            // Next round, should already be waiting in the queue.
+            Prefetch_FreeRound(&round);
+            if(!Prefetch_Pop(&round, errText, sizeof(errText))) {
+                showErrorScreen(errText);
+            }
+            my_texture = round.frame;
         }
 
         // Reset callback vars.
@@ -270,23 +259,23 @@ int main(int argc, char** argv)
     }
 }
 
-void gameStatus(GRRLIB_texImg* guessedImg, response_t answer) {
+// Shows the answer. Returns true if the player wants to play again.
+bool gameStatus(GRRLIB_texImg* guessedImg, response_t answer, const stats_t* stats) {
     // Vars.
     ir_t ir;
     GRRLIB_ttfFont* globalFont;
 
     // Font.
-    globalFont = GRRLIB_LoadTTF(font_ttf, font_ttf_size);
-
-    // The waiting BG.
-    GRRLIB_texImg* bgImg = GRRLIB_LoadTexture(wiibg_jpg);
+    globalFont = Assets_GetFont(font_ttf, font_ttf_size);
 
     // Cursor
-    GRRLIB_texImg* cursor = GRRLIB_LoadTexture(cursor_png);
+    GRRLIB_texImg* cursor = Assets_GetTexture(cursor_png);
     Size cSize;
     cSize.w = cursor->w;
     cSize.h = cursor->h;
 
+    bool playAgain = false;
+
     // Frame pos
     int frmX = (SCREEN_WIDTH / 2) - ((guessedImg->w * 0.5) / 2);
     int frmY = (SCREEN_HEIGHT / 2) - ((guessedImg->h * 0.5) / 2);
@@ -304,7 +293,7 @@ void gameStatus(GRRLIB_texImg* guessedImg, response_t answer) {
     // Main Loop.
     while(true) {
         // Scan for button presses.
-        WPAD_ScanPads();
+        CoreEngine_ScanPads();
         WPAD_IR(WPAD_CHAN_0, &ir);
 
         s32 pressed = WPAD_ButtonsDown(WPAD_CHAN_0);
@@ -320,32 +309,45 @@ void gameStatus(GRRLIB_texImg* guessedImg, response_t answer) {
 
         // Screen code.
         if(answer.correct == true) {
-            GRRLIB_PrintfTTF(0,0, globalFont, "You were Correct!", 27, COL_WHITE);
+            Text_Draw(0,0, globalFont, "You were Correct!", 27, COL_WHITE);
         } else {
-            GRRLIB_PrintfTTF(0,0, globalFont, "You were wrong.", 27, COL_WHITE);
+            Text_Draw(0,0, globalFont, "You were wrong.", 27, COL_WHITE);
         }
 
         // More info.
-        char* fInfo = malloc(100);
-        sprintf(fInfo, "S%dE%d, Seek: %.6f, ETS: %d.", answer.season,answer.episode, answer.seekTime, answer.expiryTs);
-        GRRLIB_PrintfTTF(0,30, globalFont, fInfo, 27, COL_WHITE);
-        free(fInfo);
+        char* fInfo = FrameArena_Printf("S%dE%d, Seek: %.6f, ETS: %lld.", answer.season,answer.episode, answer.seekTime, answer.expiryTs);
+        Text_Draw(0,30, globalFont, fInfo, 27, COL_WHITE);
     
+        // Score.
+        char* score = FrameArena_Printf("Score: %d/%d, streak: %d (best %d).", stats->correct, stats->rounds, stats->streak, stats->bestStreak);
+        Text_Draw(0,30+27, globalFont, score, 27, COL_WHITE);
+
         // Play again.
-        GRRLIB_PrintfTTF(0,30+27, globalFont, "Want to play again?", 27, COL_WHITE);
+        Text_Draw(0,30+27*2, globalFont, "Want to play again?", 27, COL_WHITE);
 
         // Render buttons
-        renderSpritedButton(yesBtn);
-        renderSpritedButton(noBtn);
+        renderSpritedButton(&yesBtn);
+        renderSpritedButton(&noBtn);
         checkButtonStatus(&yesBtn, ir.x,ir.y, cSize, pressed);
         checkButtonStatus(&noBtn, ir.x,ir.y, cSize, pressed);
         
         // update.
         GRRLIB_DrawImg(ir.x,ir.y, cursor, 0, 1,1, 0xFFFFFFFF);
-        GRRLIB_Render();
+        CoreEngine_Render();
 
-        // Reset vars.
-        yesClicked = false;
-        noClicked = false;
+        // Play again?
+        if(yesClicked || noClicked) {
+            playAgain = yesClicked;
+            yesClicked = false;
+            noClicked = false;
+            break;
+        }
     }
+
+    // Give the assets back to the cache.
+    DestroyButton(&yesBtn);
+    DestroyButton(&noBtn);
+    Assets_Release(cursor);
+    Assets_Release(globalFont);
+    return playAgain;
 }
\ No newline at end of file
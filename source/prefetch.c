@@ -0,0 +1,287 @@
+/**
+ * @file prefetch.c
+ * @author Dakota Thorpe
+ * Fetches (and decodes) the next rounds in the background while you play.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <gctypes.h>
+#include <grrlib.h>
+#include <gccore.h>
+
+#include "rend/coreEngine.h"
+#include "misc/networking.h"
+#include "misc/prefetch.h"
+
+#define PREFETCH_THREAD_PRIO 48          // Below the main thread, so the game stays smooth.
+#define PREFETCH_THREAD_STACK (64*1024)  // TLS handshakes are stack hungry.
+#define PREFETCH_RETRY_DELAY 1000000     // Wait between failed fetches (usec).
+#define PREFETCH_MAX_FAILURES 3          // Failures in a row before Prefetch_Pop gives up.
+
+// local code defs.
+prefetch_config_t __prefetch_config;
+lwp_t __prefetch_threads[PREFETCH_MAX_THREADS];
+mutex_t __prefetch_lock;
+mutex_t __prefetch_packLock;    // Round pack reads aren't thread safe.
+cond_t __prefetch_spaceCond;    // Signalled when a round is popped.
+round_t* __prefetch_queue;      // Ring buffer of ready rounds.
+int __prefetch_head = 0;
+int __prefetch_count = 0;
+int __prefetch_inFlight = 0;    // Rounds being fetched right now.
+int __prefetch_failures = 0;    // Failed fetches in a row.
+char __prefetch_lastError[256];
+bool __prefetch_started = false;
+
+// Pulls a random round out of the pack. Returns false (with errText set) on failure.
+static bool __prefetch_packRound(struct MemoryStruct* png, round_t* round, char* errText, size_t errSize) {
+    roundpack_t* pack = __prefetch_config.pack;
+
+    // Packs in RAM hand out the frame as is, otherwise it gets copied into png.
+    const void* frame = NULL;
+    size_t frameSize = 0;
+
+    LWP_MutexLock(__prefetch_packLock);
+    int index = rand() % RoundPack_Count(pack);
+    bool ok = RoundPack_MapFrame(pack, index, __prefetch_config.verifyFrames, &frame, &frameSize);
+    if(!ok) {
+        ok = RoundPack_ReadFrame(pack, index, png);
+        frame = png->memory;
+        frameSize = png->size;
+    }
+    LWP_MutexUnlock(__prefetch_packLock);
+
+    const packentry_t* entry = RoundPack_Entry(pack, index);
+    if(!ok) {
+        snprintf(errText, errSize, "Could not read frame %s from the round pack.", entry->iid);
+        return false;
+    }
+
+    round->frame = CoreEngine_LoadPNG(frame);
+    if(round->frame == NULL) {
+        snprintf(errText, errSize, "Could not decode the pony frame.");
+        return false;
+    }
+
+    round->iid = strdup(entry->iid);
+    round->pngSize = frameSize;
+    round->offline = true;
+    round->answer = *entry;
+    return true;
+}
+
+// Fetches one round. Returns false (with errText set) on failure.
+static bool __prefetch_fetchRound(netsession_t* session, struct MemoryStruct* png, round_t* round, char* errText, size_t errSize) {
+    round->iid = Networking_GetImageId(session, errText, errSize);
+    if(round->iid == NULL) {
+        return false;
+    }
+
+    if(!Networking_DownloadFrame(session, round->iid, png, errText, errSize)) {
+        free(round->iid);
+        return false;
+    }
+
+    round->frame = CoreEngine_LoadPNG(png->memory);
+    if(round->frame == NULL) {
+        snprintf(errText, errSize, "Could not decode the pony frame.");
+        free(round->iid);
+        return false;
+    }
+
+    round->pngSize = png->size;
+    round->offline = false;
+    return true;
+}
+
+// Producer thread.
+static void* __prefetch_threadFunc(void* arg) {
+    netsession_t* session = NULL;   // Made on the first online fetch, see below.
+    struct MemoryStruct png = { NULL, 0, 0 }; // Reused for every frame this thread fetches.
+    char errText[256];
+
+    while(true) {
+        // Wait for room in the queue.
+        LWP_MutexLock(__prefetch_lock);
+        while(__prefetch_count + __prefetch_inFlight >= __prefetch_config.queueDepth) {
+            LWP_CondWait(__prefetch_spaceCond, __prefetch_lock);
+        }
+        __prefetch_inFlight++;
+        LWP_MutexUnlock(__prefetch_lock);
+
+        round_t round;
+        memset(&round, 0, sizeof(round_t));
+        bool ok;
+        if(__prefetch_config.pack != NULL) {
+            ok = __prefetch_packRound(&png, &round, errText, sizeof(errText));
+        } else {
+            // No session counts as a failed fetch and gets retried, so Prefetch_Pop still hears about it.
+            if(session == NULL) {
+                session = Networking_CreateSession();
+            }
+            if(session == NULL) {
+                snprintf(errText, sizeof(errText), "Could not start a networking session.");
+                ok = false;
+            } else {
+                ok = __prefetch_fetchRound(session, &png, &round, errText, sizeof(errText));
+            }
+        }
+
+        LWP_MutexLock(__prefetch_lock);
+        __prefetch_inFlight--;
+        if(ok) {
+            int tail = (__prefetch_head + __prefetch_count) % __prefetch_config.queueDepth;
+            __prefetch_queue[tail] = round;
+            __prefetch_count++;
+            __prefetch_failures = 0;
+        } else {
+            __prefetch_failures++;
+            snprintf(__prefetch_lastError, sizeof(__prefetch_lastError), "%s", errText);
+        }
+        LWP_MutexUnlock(__prefetch_lock);
+
+        if(!ok) {
+            usleep(PREFETCH_RETRY_DELAY);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Returns the default prefetch settings.
+*/
+prefetch_config_t Prefetch_DefaultConfig() {
+    prefetch_config_t config;
+    config.queueDepth = PREFETCH_DEFAULT_DEPTH;
+    config.fetchThreads = PREFETCH_DEFAULT_THREADS;
+    config.pack = NULL;
+    config.verifyFrames = true;
+    return config;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Starts the prefetch threads. Call after Networking_Init, and only once.
+ *
+ * @param config Queue depth, number of fetch threads and the optional round pack.
+*/
+void Prefetch_Start(prefetch_config_t config) {
+    if(__prefetch_started) {
+        return;
+    }
+    if(config.pack != NULL) {
+        srand((unsigned int)time(NULL));
+    }
+
+    // Clamp shit.
+    if(config.queueDepth < 1) config.queueDepth = 1;
+    if(config.fetchThreads < 1) config.fetchThreads = 1;
+    if(config.fetchThreads > PREFETCH_MAX_THREADS) config.fetchThreads = PREFETCH_MAX_THREADS;
+    if(config.fetchThreads > config.queueDepth) config.fetchThreads = config.queueDepth;
+    __prefetch_config = config;
+
+    __prefetch_queue = calloc(config.queueDepth, sizeof(round_t));
+    if(__prefetch_queue == NULL) {
+        showErrorScreen("Could not allocate the prefetch queue.");
+    }
+
+    LWP_MutexInit(&__prefetch_lock, false);
+    LWP_MutexInit(&__prefetch_packLock, false);
+    LWP_CondInit(&__prefetch_spaceCond);
+
+    for(int i = 0; i < config.fetchThreads; i++) {
+        LWP_CreateThread(&__prefetch_threads[i], __prefetch_threadFunc, NULL, NULL, PREFETCH_THREAD_STACK, PREFETCH_THREAD_PRIO);
+    }
+    __prefetch_started = true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @returns How many rounds are ready to play right now.
+*/
+int Prefetch_Ready() {
+    LWP_MutexLock(__prefetch_lock);
+    int ready = __prefetch_count;
+    LWP_MutexUnlock(__prefetch_lock);
+    return ready;
+}
+
+// Takes the oldest round off the queue. Lock must be held.
+static void __prefetch_take(round_t* round) {
+    *round = __prefetch_queue[__prefetch_head];
+    __prefetch_head = (__prefetch_head + 1) % __prefetch_config.queueDepth;
+    __prefetch_count--;
+    LWP_CondSignal(__prefetch_spaceCond);
+}
+
+/**
+ * @author Dakota Thorpe
+ * Takes a ready round without waiting.
+ *
+ * @param round Gets the round.
+ *
+ * @returns false if no round is ready yet.
+*/
+bool Prefetch_TryPop(round_t* round) {
+    LWP_MutexLock(__prefetch_lock);
+    bool ok = __prefetch_count > 0;
+    if(ok) {
+        __prefetch_take(round);
+    }
+    LWP_MutexUnlock(__prefetch_lock);
+    return ok;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Takes the next round, waiting for one if the queue is empty. Draws the
+ * please wait screen while it waits, so only call it from the main thread.
+ *
+ * @param round Gets the round.
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns false if fetching keeps failing.
+*/
+bool Prefetch_Pop(round_t* round, char* errText, size_t errSize) {
+    if(Prefetch_TryPop(round)) {
+        return true;
+    }
+
+    LWP_MutexLock(__prefetch_lock);
+    while(__prefetch_count == 0 && __prefetch_failures < PREFETCH_MAX_FAILURES) {
+        // The fetch threads do the work, we just keep the screen going.
+        LWP_MutexUnlock(__prefetch_lock);
+        Networking_DrawWaitFrame("Please wait. Getting the next round.");
+        LWP_MutexLock(__prefetch_lock);
+    }
+
+    bool ok = __prefetch_count > 0;
+    if(ok) {
+        __prefetch_take(round);
+    } else {
+        snprintf(errText, errSize, "%s", __prefetch_lastError);
+        __prefetch_failures = 0;
+    }
+    LWP_MutexUnlock(__prefetch_lock);
+    return ok;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Frees a round you're done with.
+ *
+ * @param round The round.
+*/
+void Prefetch_FreeRound(round_t* round) {
+    free(round->iid);
+    GRRLIB_FreeTexture(round->frame);
+    round->iid = NULL;
+    round->frame = NULL;
+}
@@ -0,0 +1,333 @@
+/**
+ * @file roundpack.c
+ * @author Dakota Thorpe
+ * Offline round packs. Lets the game play from a zip on the SD with no network.
+ * No Wii stuff in here, so the pack tool can use it on a PC too.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zip.h"
+#include "misc/networking.h"
+#include "misc/roundpack.h"
+
+struct roundpack_s {
+    struct zip_t* zip;
+    char* archive;          // Whole pack, if it was small enough to load into RAM.
+    packentry_t* entries;
+    int count;
+};
+
+// Big endian helpers.
+static uint32_t __roundpack_read32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+static uint16_t __roundpack_read16(const unsigned char* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+static void __roundpack_write32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+static void __roundpack_write16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)(v >> 8);
+    p[1] = (unsigned char)v;
+}
+
+// Loads a file into RAM. Returns NULL if it's missing or too big.
+static char* __roundpack_slurp(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long fileSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(fileSize <= 0 || fileSize > ROUNDPACK_MAX_INMEMORY) {
+        fclose(fp);
+        return NULL;
+    }
+
+    char* data = malloc(fileSize);
+    if(data != NULL && fread(data, 1, fileSize, fp) != (size_t)fileSize) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+
+    *size = (size_t)fileSize;
+    return data;
+}
+
+// Reads and checks index.bin.
+static bool __roundpack_readIndex(roundpack_t* pack, char* errText, size_t errSize) {
+    if(zip_entry_open(pack->zip, ROUNDPACK_INDEX_NAME) < 0) {
+        snprintf(errText, errSize, "Round pack has no %s.", ROUNDPACK_INDEX_NAME);
+        return false;
+    }
+
+    size_t indexSize = (size_t)zip_entry_size(pack->zip);
+    unsigned char* index = malloc(indexSize ? indexSize : 1);
+    if(index == NULL || indexSize < ROUNDPACK_HEADER_SIZE || zip_entry_noallocread(pack->zip, index, indexSize) < 0) {
+        snprintf(errText, errSize, "Could not read the round pack index.");
+        free(index);
+        zip_entry_close(pack->zip);
+        return false;
+    }
+    zip_entry_close(pack->zip);
+
+    uint16_t version = __roundpack_read16(index + 4);
+    uint16_t recordSize = __roundpack_read16(index + 6);
+    uint32_t count = __roundpack_read32(index + 8);
+    if(memcmp(index, ROUNDPACK_MAGIC, 4) != 0 || version != ROUNDPACK_VERSION || recordSize < ROUNDPACK_RECORD_SIZE ||
+       count == 0 || (indexSize - ROUNDPACK_HEADER_SIZE) / recordSize < count) {
+        snprintf(errText, errSize, "Round pack index is broken or from a newer version.");
+        free(index);
+        return false;
+    }
+
+    pack->entries = calloc(count, sizeof(packentry_t));
+    if(pack->entries == NULL) {
+        snprintf(errText, errSize, "Out of memory loading the round pack index.");
+        free(index);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < count; i++) {
+        const unsigned char* rec = index + ROUNDPACK_HEADER_SIZE + i * recordSize;
+        packentry_t* entry = &pack->entries[i];
+
+        memcpy(entry->iid, rec, ROUNDPACK_IID_SIZE);
+        entry->iid[ROUNDPACK_IID_SIZE - 1] = '\0';
+        entry->season = __roundpack_read16(rec + 40);
+        entry->episode = __roundpack_read16(rec + 42);
+
+        uint32_t seekBits = __roundpack_read32(rec + 44);
+        memcpy(&entry->seekTime, &seekBits, sizeof(float));
+    }
+    pack->count = (int)count;
+
+    free(index);
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Opens a round pack. Small packs are loaded into RAM and read with
+ * zip_stream_open, big ones are read straight from the file. Either way
+ * nothing gets extracted to the SD.
+ *
+ * @param path The pack file.
+ * @param errText Gets an error message on failure.
+ * @param errSize Size of errText.
+ *
+ * @returns The pack, or NULL on failure.
+*/
+roundpack_t* RoundPack_Open(const char* path, char* errText, size_t errSize) {
+    roundpack_t* pack = calloc(1, sizeof(roundpack_t));
+    if(pack == NULL) {
+        snprintf(errText, errSize, "Out of memory opening the round pack.");
+        return NULL;
+    }
+
+    size_t size = 0;
+    pack->archive = __roundpack_slurp(path, &size);
+    if(pack->archive != NULL) {
+        pack->zip = zip_stream_open(pack->archive, size, 0, 'r');
+    } else {
+        pack->zip = zip_open(path, 0, 'r');
+    }
+
+    if(pack->zip == NULL) {
+        snprintf(errText, errSize, "Could not open round pack %s.", path);
+        RoundPack_Close(pack);
+        return NULL;
+    }
+
+    if(!__roundpack_readIndex(pack, errText, errSize)) {
+        RoundPack_Close(pack);
+        return NULL;
+    }
+    return pack;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Closes a round pack.
+ *
+ * @param pack The pack.
+*/
+void RoundPack_Close(roundpack_t* pack) {
+    if(pack == NULL) {
+        return;
+    }
+
+    if(pack->zip != NULL) {
+        if(pack->archive != NULL) {
+            zip_stream_close(pack->zip);
+        } else {
+            zip_close(pack->zip);
+        }
+    }
+    free(pack->archive);
+    free(pack->entries);
+    free(pack);
+}
+
+/**
+ * @author Dakota Thorpe
+ * @returns How many rounds are in the pack.
+*/
+int RoundPack_Count(roundpack_t* pack) {
+    return pack->count;
+}
+
+/**
+ * @author Dakota Thorpe
+ * @returns Round number `index` of the pack, or NULL if it's out of range.
+*/
+const packentry_t* RoundPack_Entry(roundpack_t* pack, int index) {
+    if(index < 0 || index >= pack->count) {
+        return NULL;
+    }
+    return &pack->entries[index];
+}
+
+/**
+ * @author Dakota Thorpe
+ * Reads the frame of a round into a memory sink. The sink's buffer is reused and only
+ * grown when a frame doesn't fit. Not thread safe, lock around it if you share a pack.
+ *
+ * @param pack The pack.
+ * @param index The round.
+ * @param png Gets the PNG data.
+ *
+ * @returns true if the frame was read.
+*/
+bool RoundPack_ReadFrame(roundpack_t* pack, int index, struct MemoryStruct* png) {
+    const packentry_t* entry = RoundPack_Entry(pack, index);
+    if(entry == NULL) {
+        return false;
+    }
+
+    char name[ROUNDPACK_IID_SIZE + 16];
+    snprintf(name, sizeof(name), ROUNDPACK_FRAME_FMT, entry->iid);
+    if(zip_entry_opencasesensitive(pack->zip, name) < 0) {
+        return false;
+    }
+
+    size_t frameSize = (size_t)zip_entry_size(pack->zip);
+    if(frameSize + 1 > png->capacity) {
+        char* grown = realloc(png->memory, frameSize + 1);
+        if(grown == NULL) {
+            zip_entry_close(pack->zip);
+            return false;
+        }
+        png->memory = grown;
+        png->capacity = frameSize + 1;
+    }
+
+    ssize_t read = zip_entry_noallocread(pack->zip, png->memory, png->capacity);
+    zip_entry_close(pack->zip);
+    if(read < 0) {
+        return false;
+    }
+
+    png->size = (size_t)read;
+    png->memory[png->size] = 0;
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Gets a round's PNG straight out of the pack without copying it.
+ * Only works for packs that were loaded into RAM, since that's the buffer it points into.
+ * The data isn't NUL terminated, and stays valid until the pack is closed.
+ *
+ * @param pack The pack.
+ * @param index The round.
+ * @param verify CRC check the frame first.
+ * @param data Where the pointer to the PNG goes.
+ * @param size Where the PNG size goes.
+ *
+ * @returns false if the frame can't be read this way, use RoundPack_ReadFrame then.
+*/
+bool RoundPack_MapFrame(roundpack_t* pack, int index, bool verify, const void** data, size_t* size) {
+    const packentry_t* entry = RoundPack_Entry(pack, index);
+    if(entry == NULL || pack->archive == NULL) {
+        return false;
+    }
+
+    char name[ROUNDPACK_IID_SIZE + 16];
+    snprintf(name, sizeof(name), ROUNDPACK_FRAME_FMT, entry->iid);
+    if(zip_entry_opencasesensitive(pack->zip, name) < 0) {
+        return false;
+    }
+
+    ssize_t frameSize = zip_entry_noallocptr(pack->zip, data, verify);
+    zip_entry_close(pack->zip);
+    if(frameSize < 0) {
+        return false;
+    }
+
+    *size = (size_t)frameSize;
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Checks a guess against a pack round, the offline version of checkCorrect.
+ *
+ * @param entry The round.
+ * @param season The guessed season.
+ * @param episode The guessed episode.
+ *
+ * @returns The answer, like the API would give it.
+*/
+response_t RoundPack_Check(const packentry_t* entry, int season, int episode) {
+    response_t answer;
+    memset(&answer, 0, sizeof(response_t));
+    answer.season = entry->season;
+    answer.episode = entry->episode;
+    answer.seekTime = entry->seekTime;
+    answer.correct = (season == entry->season && episode == entry->episode);
+    return answer;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Writes the index.bin header. Used by the pack tool.
+ *
+ * @param out ROUNDPACK_HEADER_SIZE bytes.
+ * @param count Number of rounds that follow.
+*/
+void RoundPack_EncodeHeader(unsigned char* out, unsigned int count) {
+    memcpy(out, ROUNDPACK_MAGIC, 4);
+    __roundpack_write16(out + 4, ROUNDPACK_VERSION);
+    __roundpack_write16(out + 6, ROUNDPACK_RECORD_SIZE);
+    __roundpack_write32(out + 8, count);
+}
+
+/**
+ * @author Dakota Thorpe
+ * Writes one index.bin record. Used by the pack tool.
+ *
+ * @param out ROUNDPACK_RECORD_SIZE bytes.
+ * @param entry The round.
+*/
+void RoundPack_EncodeEntry(unsigned char* out, const packentry_t* entry) {
+    memset(out, 0, ROUNDPACK_RECORD_SIZE);
+    memcpy(out, entry->iid, strnlen(entry->iid, ROUNDPACK_IID_SIZE - 1));
+    __roundpack_write16(out + 40, (uint16_t)entry->season);
+    __roundpack_write16(out + 42, (uint16_t)entry->episode);
+
+    uint32_t seekBits;
+    memcpy(&seekBits, &entry->seekTime, sizeof(float));
+    __roundpack_write32(out + 44, seekBits);
+}
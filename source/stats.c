@@ -0,0 +1,129 @@
+/**
+ * @file stats.c
+ * @author Dakota Thorpe
+ * Keeps score across sessions, in a small JSON file on the SD.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "cJSON.h"
+#include "misc/jsonbind.h"
+#include "misc/stats.h"
+
+#define STATS_MAX_FILE 4096     // Anything bigger isn't ours.
+#define STATS_WRITE_BUFFER 256  // The whole file fits, so saving is one write.
+
+static const jsonbind_field_t __stats_fields[] = {
+    JSONBIND_FIELD(stats_t, rounds, JSONBIND_INT, false),
+    JSONBIND_FIELD(stats_t, correct, JSONBIND_INT, false),
+    JSONBIND_FIELD(stats_t, streak, JSONBIND_INT, false),
+    JSONBIND_FIELD(stats_t, bestStreak, JSONBIND_INT, false),
+};
+
+/**
+ * @author Dakota Thorpe
+ * Loads the stats. A missing or broken file just means starting from zero.
+ *
+ * @param path The stats file.
+ * @param stats Gets the stats.
+*/
+void Stats_Load(const char* path, stats_t* stats) {
+    memset(stats, 0, sizeof(stats_t));
+
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL) {
+        // Power went between the two steps of a Stats_Save on libfat, the new file's in the .tmp.
+        char tmpPath[256];
+        if(snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) < (int)sizeof(tmpPath)) {
+            fp = fopen(tmpPath, "rb");
+        }
+        if(fp == NULL) {
+            return;
+        }
+    }
+    char* content = malloc(STATS_MAX_FILE);
+    size_t size = content ? fread(content, 1, STATS_MAX_FILE, fp) : 0;
+    fclose(fp);
+
+    // Parsed in place, nothing to copy for a handful of numbers.
+    cJSON* json = size > 0 ? cJSON_ParseInSitu(content, size) : NULL;
+    stats_t loaded;
+    char errText[128];
+    memset(&loaded, 0, sizeof(stats_t));
+    if(json != NULL && JsonBind_Object(json, __stats_fields, sizeof(__stats_fields) / sizeof(__stats_fields[0]), &loaded, errText, sizeof(errText))) {
+        *stats = loaded;
+    }
+    cJSON_Delete(json);
+    free(content);
+}
+
+/**
+ * @author Dakota Thorpe
+ * Writes the stats out, straight from the struct (no cJSON tree, no allocations).
+ * They go to path.tmp first and are renamed over path once complete, so losing
+ * power mid-save leaves the old file rather than half of a new one.
+ *
+ * @param path The stats file.
+ * @param stats The stats.
+ *
+ * @returns false if the file couldn't be written.
+*/
+bool Stats_Save(const char* path, const stats_t* stats) {
+    char tmpPath[256];
+    if(snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath)) {
+        return false;
+    }
+    FILE* fp = fopen(tmpPath, "wb");
+    if(fp == NULL) {
+        return false;
+    }
+
+    char buffer[STATS_WRITE_BUFFER];
+    cJSON_Writer writer;
+    cJSON_InitWriter(&writer, buffer, sizeof(buffer), cJSON_FlushToFile, fp);
+    cJSON_WriteStartObject(&writer);
+    cJSON_WriteKey(&writer, "rounds"); cJSON_WriteNumber(&writer, stats->rounds);
+    cJSON_WriteKey(&writer, "correct"); cJSON_WriteNumber(&writer, stats->correct);
+    cJSON_WriteKey(&writer, "streak"); cJSON_WriteNumber(&writer, stats->streak);
+    cJSON_WriteKey(&writer, "bestStreak"); cJSON_WriteNumber(&writer, stats->bestStreak);
+    cJSON_WriteEndObject(&writer);
+
+    bool ok = cJSON_WriterFinish(&writer);
+    if(fclose(fp) != 0 || !ok) {
+        remove(tmpPath);
+        return false;
+    }
+
+    // libfat won't rename over an existing file. That leaves a moment with only
+    // the .tmp on the card, which Stats_Load falls back on.
+    if(rename(tmpPath, path) != 0) {
+        remove(path);
+        if(rename(tmpPath, path) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @author Dakota Thorpe
+ * Counts one answered round.
+ *
+ * @param stats The stats.
+ * @param correct If the guess was right.
+*/
+void Stats_AddRound(stats_t* stats, bool correct) {
+    stats->rounds++;
+    if(correct) {
+        stats->correct++;
+        stats->streak++;
+        if(stats->streak > stats->bestStreak) {
+            stats->bestStreak = stats->streak;
+        }
+    } else {
+        stats->streak = 0;
+    }
+}
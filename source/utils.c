@@ -122,15 +122,15 @@ char** GetAudioNames(char* packName, int* entryCount) {
 
     fclose(fp);
 
-    // Parse JSON content
-    cJSON* json = cJSON_Parse(fileContent);
-    free(fileContent); // Free the allocated memory for file content after parsing
+    // Parse JSON content, in place (the strings point into fileContent, so it has to stay until cJSON_Delete)
+    cJSON* json = cJSON_ParseInSitu(fileContent, bytesRead);
     if (!json) {
         const char* error_ptr = cJSON_GetErrorPtr();
         if (error_ptr != NULL) {
-            fprintf(stderr, "Error before: %s\n", error_ptr);
+            // The text after it may be cut short by the in place parse, so just say where.
+            fprintf(stderr, "Error parsing JSON at byte %lu\n", (unsigned long)(error_ptr - fileContent));
         }
-        cJSON_Delete(json);
+        free(fileContent);
         return NULL;
     }
 
@@ -141,6 +141,7 @@ char** GetAudioNames(char* packName, int* entryCount) {
     char** fileNames = (char**)malloc(arraySize * sizeof(char*));
     if (!fileNames) {
         cJSON_Delete(json);
+        free(fileContent);
         perror("Memory allocation error");
         return NULL;
     }
@@ -160,6 +161,7 @@ char** GetAudioNames(char* packName, int* entryCount) {
     }
 
     cJSON_Delete(json); // Clean up cJSON object
+    free(fileContent);
 
     fclose(quickDebugLog);
 
@@ -0,0 +1,151 @@
+/**
+ * @file crcbench.c
+ * @author Dakota Thorpe
+ * Checks and times the CRC-32 kernels in miniz.h on a PC.
+ *
+ * Usage:
+ *   crcbench [size]   Time each kernel on a size byte buffer (default 1MB), in GB/s.
+ *
+ * Every kernel is checked against the byte-at-a-time table first, so a wrong one fails
+ * loudly instead of just looking fast.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Pulls in the whole of miniz, so the kernels (static in there) can be called directly.
+#include "miniz.h"
+
+typedef mz_uint32 (*crcKernel_t)(mz_uint32 crc, const mz_uint8* p, size_t len);
+
+typedef struct {
+    const char* name;
+    crcKernel_t kernel;
+    size_t minLen;      // Kernels that need a minimum length (and a multiple of 16) set this.
+} crcVariant_t;
+
+#if MINIZ_CRC32_PCLMUL
+// Same split mz_crc32 does: whole 16 byte blocks folded, the tail sliced.
+static mz_uint32 pclmulKernel(mz_uint32 crc, const mz_uint8* p, size_t len) {
+    size_t folded = len & ~(size_t)15;
+    crc = mz_crc32_pclmul(crc, p, folded);
+    return mz_crc32_sliced(crc, p + folded, len - folded);
+}
+#endif
+
+// Through the public function, so the dispatch is timed too.
+static mz_uint32 dispatchKernel(mz_uint32 crc, const mz_uint8* p, size_t len) {
+    return ~(mz_uint32)mz_crc32(~crc, p, len);
+}
+
+static crcVariant_t variants[] = {
+    { "table (1 byte)", mz_crc32_bytes, 0 },
+    { "slicing-by-8", mz_crc32_slice8, 0 },
+#if MINIZ_CRC32_SLICES > 8
+    { "slicing-by-16", mz_crc32_slice16, 0 },
+#endif
+#if MINIZ_CRC32_PCLMUL
+    { "pclmul", pclmulKernel, 64 },
+#endif
+    { "mz_crc32", dispatchKernel, 0 },
+};
+#define VARIANT_COUNT (int)(sizeof(variants) / sizeof(variants[0]))
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool usable(const crcVariant_t* variant) {
+#if MINIZ_CRC32_PCLMUL
+    if(variant->kernel == pclmulKernel && !mz_crc32_has_pclmul()) {
+        return false;
+    }
+#else
+    (void)variant;
+#endif
+    return true;
+}
+
+// Compares every kernel with the table on odd lengths, offsets and starting CRCs.
+static int check(const mz_uint8* data) {
+    int bad = 0;
+    if(mz_crc32(MZ_CRC32_INIT, (const mz_uint8*)"123456789", 9) != 0xCBF43926) {
+        printf("mz_crc32 check value is wrong\n");
+        bad++;
+    }
+
+    for(int v = 0; v < VARIANT_COUNT; v++) {
+        if(!usable(&variants[v])) {
+            continue;
+        }
+        for(size_t len = 0; len < 2048; len += 1 + len / 16) {
+            if(len < variants[v].minLen) {
+                continue;
+            }
+            for(size_t offset = 0; offset < 16; offset++) {
+                mz_uint32 start = (mz_uint32)(len * 2654435761u + offset);
+                mz_uint32 want = mz_crc32_bytes(start, data + offset, len);
+                mz_uint32 got = variants[v].kernel(start, data + offset, len);
+                if(got != want) {
+                    if(bad++ < 10) {
+                        printf("%s: len %zu offset %zu gave %08X, want %08X\n",
+                            variants[v].name, len, offset, (unsigned)got, (unsigned)want);
+                    }
+                }
+            }
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    size_t size = argc > 1 ? (size_t)strtoul(argv[1], NULL, 0) : 1024 * 1024;
+    if(size < 64) {
+        size = 64;
+    }
+
+    mz_uint8* data = malloc(size + 4096);
+    if(data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    srand(1);
+    for(size_t i = 0; i < size + 4096; i++) {
+        data[i] = (mz_uint8)rand();
+    }
+
+    int bad = check(data);
+    if(bad) {
+        printf("%d mismatches\n", bad);
+        free(data);
+        return 1;
+    }
+
+    printf("%zu byte buffer, all kernels match the table\n", size);
+    for(int v = 0; v < VARIANT_COUNT; v++) {
+        if(!usable(&variants[v])) {
+            printf("%-16s not supported on this CPU\n", variants[v].name);
+            continue;
+        }
+
+        // Run for about a quarter of a second.
+        mz_uint32 crc = 0;
+        size_t rounds = 0, total = 0;
+        double start = now(), elapsed;
+        do {
+            crc = variants[v].kernel(crc, data, size);
+            rounds++;
+            total += size;
+            elapsed = now() - start;
+        } while(elapsed < 0.25 || rounds < 3);
+
+        printf("%-16s %7.2f GB/s  (%08X)\n", variants[v].name, total / elapsed / 1e9, (unsigned)crc);
+    }
+
+    free(data);
+    return 0;
+}
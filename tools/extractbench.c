@@ -0,0 +1,167 @@
+/**
+ * @file extractbench.c
+ * @author Dakota Thorpe
+ * Times zip_extract against zip_extract_parallel on a PC.
+ *
+ * Usage:
+ *   extractbench [threads] [entries] [entry KB]   Defaults: one thread per CPU online
+ *                                                 (ZIP_EXTRACT_AUTO_THREADS), 64 entries of 1024KB.
+ *
+ * Builds a deflated archive of asset-like data (text that compresses about 3:1, so inflating
+ * is real work), extracts it serially and then on the given number of threads, and checks
+ * every file that came out. Built with ZIP_ENABLE_THREADS, see the Makefile.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "zip.h"
+
+#define EXTRACTBENCH_ARCHIVE "extractbench.zip"
+#define EXTRACTBENCH_DIR "extractbench.out"
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Entry i's contents, the same every time so the output can be checked.
+static void fill(char* data, size_t size, int i) {
+    static const char* words[] = { "pony", "frame", "season", "episode", "guess", "magic", "friendship", "apple",
+                                   "cloud", "rainbow", "castle", "library", "party", "sonic", "canterlot", "ponyville" };
+    unsigned int seed = (unsigned int)i * 2654435761u + 1;
+    size_t at = 0;
+    while(at < size) {
+        seed = seed * 1103515245u + 12345u;
+        const char* word = words[(seed >> 16) % 16];
+        // Numbers now and then so it doesn't compress to nothing.
+        int written = (seed >> 8) % 4 == 0 ? snprintf(data + at, size - at, "%u ", seed) : snprintf(data + at, size - at, "%s ", word);
+        if(written < 0 || (size_t)written >= size - at) {
+            break;
+        }
+        at += written;
+    }
+    memset(data + at, '.', size - at);
+}
+
+static bool build(int entries, size_t entrySize, char* data) {
+    struct zip_t* zip = zip_open(EXTRACTBENCH_ARCHIVE, ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
+    if(zip == NULL) {
+        return false;
+    }
+    char name[64];
+    for(int i = 0; i < entries; i++) {
+        snprintf(name, sizeof(name), "assets/%03d.bin", i);
+        fill(data, entrySize, i);
+        if(zip_entry_open(zip, name) < 0 || zip_entry_write(zip, data, entrySize) < 0 || zip_entry_close(zip) < 0) {
+            zip_close(zip);
+            return false;
+        }
+    }
+    zip_close(zip);
+    return true;
+}
+
+// Checks every extracted file against what went in, and deletes it.
+static int check(int entries, size_t entrySize, char* want, char* got) {
+    char path[128];
+    int bad = 0;
+    for(int i = 0; i < entries; i++) {
+        snprintf(path, sizeof(path), "%s/assets/%03d.bin", EXTRACTBENCH_DIR, i);
+        FILE* fp = fopen(path, "rb");
+        size_t read = 0;
+        if(fp != NULL) {
+            read = fread(got, 1, entrySize + 1, fp);
+            fclose(fp);
+        }
+        fill(want, entrySize, i);
+        if(read != entrySize || memcmp(want, got, entrySize) != 0) {
+            if(bad++ < 10) {
+                printf("%s is wrong\n", path);
+            }
+        }
+        remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/assets", EXTRACTBENCH_DIR);
+    rmdir(path);
+    rmdir(EXTRACTBENCH_DIR);
+    return bad;
+}
+
+static double timeExtract(bool parallel, int threads) {
+    double start = now();
+    int err = parallel ? zip_extract_parallel(EXTRACTBENCH_ARCHIVE, EXTRACTBENCH_DIR, threads, 0, NULL, NULL)
+                       : zip_extract(EXTRACTBENCH_ARCHIVE, EXTRACTBENCH_DIR, NULL, NULL);
+    double elapsed = now() - start;
+    if(err < 0) {
+        printf("%s failed: %s\n", parallel ? "zip_extract_parallel" : "zip_extract", zip_strerror(err));
+        return -1;
+    }
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? atoi(argv[1]) : ZIP_EXTRACT_AUTO_THREADS;
+    int entries = argc > 2 ? atoi(argv[2]) : 64;
+    size_t entrySize = (size_t)(argc > 3 ? atoi(argv[3]) : 1024) * 1024;
+    if(threads < 0 || entries < 1 || entrySize == 0) {
+        fprintf(stderr, "usage: %s [threads] [entries] [entry KB]\n", argv[0]);
+        return 1;
+    }
+
+    char* want = malloc(entrySize);
+    char* got = malloc(entrySize + 1);
+    if(want == NULL || got == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if(!build(entries, entrySize, want)) {
+        fprintf(stderr, "Could not write %s\n", EXTRACTBENCH_ARCHIVE);
+        return 1;
+    }
+    FILE* fp = fopen(EXTRACTBENCH_ARCHIVE, "rb");
+    long archiveSize = 0;
+    if(fp != NULL) {
+        fseek(fp, 0, SEEK_END);
+        archiveSize = ftell(fp);
+        fclose(fp);
+    }
+    printf("%d entries, %zu KB each, %ld KB deflated, %ld CPUs online\n",
+        entries, entrySize / 1024, archiveSize / 1024, sysconf(_SC_NPROCESSORS_ONLN));
+
+    // Best of three each, the first run also warms the page cache.
+    double best[2] = { -1, -1 };
+    int bad = 0;
+    for(int run = 0; run < 3 && bad == 0; run++) {
+        for(int mode = 0; mode < 2 && bad == 0; mode++) {
+            double elapsed = timeExtract(mode == 1, threads);
+            bad = elapsed < 0 ? 1 : check(entries, entrySize, want, got);
+            if(best[mode] < 0 || elapsed < best[mode]) {
+                best[mode] = elapsed;
+            }
+        }
+    }
+    remove(EXTRACTBENCH_ARCHIVE);
+    free(want);
+    free(got);
+    if(bad) {
+        printf("%d bad files\n", bad);
+        return 1;
+    }
+
+    double megabytes = (double)entries * entrySize / 1e6;
+    printf("%-33s %7.3f s  %7.1f MB/s\n", "zip_extract", best[0], megabytes / best[0]);
+    char label[48];
+    if(threads == ZIP_EXTRACT_AUTO_THREADS) {
+        snprintf(label, sizeof(label), "zip_extract_parallel (auto)");
+    } else {
+        snprintf(label, sizeof(label), "zip_extract_parallel (%d threads)", threads);
+    }
+    printf("%-33s %7.3f s  %7.1f MB/s  (%.2fx)\n", label, best[1], megabytes / best[1], best[0] / best[1]);
+    return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file jsonbench.c
+ * @author Dakota Thorpe
+ * Checks and times the scanners in cJSON (scan_string, scan_whitespace) on a PC.
+ *
+ * Usage:
+ *   jsonbench-<path> [size]   Generate a size byte document (default 16MB) and time it, in MB/s.
+ *
+ * cJSON picks its scan path at compile time, so the Makefile builds this once per path:
+ * jsonbench-bytes (CJSON_NO_SIMD), jsonbench-swar, jsonbench-sse2 and jsonbench-avx2.
+ * Each one checks its scanners against the plain byte loops first, then times the byte
+ * loops, its own scanners and a whole parse of the document.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Pulls in the whole of cJSON, so the scanners (static in there) can be called directly.
+#include "../core/libcjson/cJSON.c"
+
+#if defined(CJSON_NO_SIMD)
+#define SCAN_PATH "CJSON_NO_SIMD"
+#elif defined(scan_sse) && defined(__AVX2__)
+#define SCAN_PATH "avx2"
+#elif defined(scan_sse)
+#define SCAN_PATH "sse2"
+#else
+#define SCAN_PATH "swar"
+#endif
+
+// The byte loops every path ends in, what the fast paths have to agree with.
+static const unsigned char* byteString(const unsigned char* pointer, const unsigned char* end) {
+    while((pointer < end) && (*pointer != '\"') && (*pointer != '\\') && (*pointer >= 0x20)) {
+        pointer++;
+    }
+    return pointer;
+}
+
+static const unsigned char* byteWhitespace(const unsigned char* pointer, const unsigned char* end) {
+    while((pointer < end) && (*pointer <= 32)) {
+        pointer++;
+    }
+    return pointer;
+}
+
+typedef const unsigned char* (*scanner_t)(const unsigned char* pointer, const unsigned char* end);
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned int seed = 1;
+static unsigned int next() {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// Mostly text, with a few of every byte the scanners stop on (and high bytes, for the signed compares).
+static unsigned char randomByte(int stopEvery) {
+    unsigned int pick = next() % (unsigned int)stopEvery;
+    switch(pick) {
+        case 0: return '\"';
+        case 1: return '\\';
+        case 2: return (unsigned char)(next() % 0x20);
+        case 3: return (unsigned char)(0x80 + next() % 0x80);
+        case 4: return ' ';
+        case 5: return '!';
+        default: return (unsigned char)('a' + next() % 26);
+    }
+}
+
+// Every start and end in random buffers, dense and sparse in stop bytes.
+static int check() {
+    unsigned char buffer[300];
+    unsigned char spaces[300];
+    int bad = 0;
+
+    for(int round = 0; round < 2000; round++) {
+        int stopEvery = 6 + (round % 8) * 40;
+        for(size_t i = 0; i < sizeof(buffer); i++) {
+            buffer[i] = randomByte(stopEvery);
+            // Whitespace runs with the odd byte that ends them.
+            spaces[i] = (next() % (unsigned int)stopEvery) == 0 ? buffer[i] : (unsigned char)(next() % 33);
+        }
+        for(size_t start = 0; start < 40; start++) {
+            for(size_t end = start; end <= sizeof(buffer); end += 1 + (end - start) / 8) {
+                const unsigned char* s = scan_string(buffer + start, buffer + end);
+                const unsigned char* w = scan_whitespace(spaces + start, spaces + end);
+                if(s != byteString(buffer + start, buffer + end)) {
+                    if(bad++ < 10) {
+                        printf("scan_string: start %zu end %zu stopped at %d, want %d\n", start, end,
+                            (int)(s - buffer), (int)(byteString(buffer + start, buffer + end) - buffer));
+                    }
+                }
+                if(w != byteWhitespace(spaces + start, spaces + end)) {
+                    if(bad++ < 10) {
+                        printf("scan_whitespace: start %zu end %zu stopped at %d, want %d\n", start, end,
+                            (int)(w - spaces), (int)(byteWhitespace(spaces + start, spaces + end) - spaces));
+                    }
+                }
+            }
+        }
+    }
+    return bad;
+}
+
+// An array of objects like the ones a big API dump has, pretty printed (so there's whitespace to skip).
+static cJSON* generate(size_t size) {
+    cJSON* root = cJSON_CreateArray();
+    char text[512];
+    size_t approx = 0;
+
+    while(approx < size) {
+        cJSON* item = cJSON_CreateObject();
+        snprintf(text, sizeof(text), "%08x-%04x-4%03x-%04x-%08x%04x", next(), next() & 0xFFFF, next() & 0xFFF, next() & 0xFFFF, next(), next() & 0xFFFF);
+        cJSON_AddStringToObject(item, "id", text);
+
+        // Prose, with the odd escape.
+        size_t length = next() % (sizeof(text) - 1);
+        for(size_t i = 0; i < length; i++) {
+            unsigned int pick = next() % 64;
+            text[i] = pick == 0 ? '\"' : pick == 1 ? '\n' : pick < 10 ? ' ' : (char)('a' + next() % 26);
+        }
+        text[length] = '\0';
+        cJSON_AddStringToObject(item, "description", text);
+
+        cJSON_AddNumberToObject(item, "season", next() % 9 + 1);
+        cJSON_AddNumberToObject(item, "episode", next() % 26 + 1);
+        cJSON_AddBoolToObject(item, "seen", next() & 1);
+        cJSON* tags = cJSON_AddArrayToObject(item, "tags");
+        for(unsigned int i = next() % 5; i > 0; i--) {
+            snprintf(text, sizeof(text), "tag%u", next() % 100);
+            cJSON_AddItemToArray(tags, cJSON_CreateString(text));
+        }
+        cJSON_AddItemToArray(root, item);
+        approx += length + 140;
+    }
+    return root;
+}
+
+// Walks buffer stopping wherever scan says, like parse_string does.
+static size_t walkString(scanner_t scan, const unsigned char* buffer, size_t size) {
+    const unsigned char* pointer = buffer;
+    const unsigned char* end = buffer + size;
+    size_t stops = 0;
+    while(pointer < end) {
+        pointer = scan(pointer, end) + 1;
+        stops++;
+    }
+    return stops;
+}
+
+// Skips each whitespace run with scan and the token after it by hand, like the parser between values.
+static size_t walkWhitespace(scanner_t scan, const unsigned char* buffer, size_t size) {
+    const unsigned char* pointer = buffer;
+    const unsigned char* end = buffer + size;
+    size_t stops = 0;
+    while(pointer < end) {
+        pointer = scan(pointer, end);
+        while((pointer < end) && (*pointer > 32)) {
+            pointer++;
+        }
+        stops++;
+    }
+    return stops;
+}
+
+static void timeWalk(const char* name, size_t (*walk)(scanner_t, const unsigned char*, size_t), scanner_t scan, const unsigned char* buffer, size_t size) {
+    size_t rounds = 0, stops = 0;
+    double start = now(), elapsed;
+    do {
+        stops = walk(scan, buffer, size);
+        rounds++;
+        elapsed = now() - start;
+    } while(elapsed < 0.25 || rounds < 3);
+    printf("%-30s %8.1f MB/s  (%zu stops)\n", name, (double)size * rounds / elapsed / 1e6, stops);
+}
+
+int main(int argc, char** argv) {
+    size_t size = argc > 1 ? (size_t)strtoul(argv[1], NULL, 0) : 16 * 1024 * 1024;
+
+    int bad = check();
+    if(bad) {
+        printf("%d mismatches\n", bad);
+        return 1;
+    }
+    printf("%s scanners match the byte loops\n", SCAN_PATH);
+
+    cJSON* expected = generate(size);
+    char* document = cJSON_Print(expected);
+    if(document == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    size_t length = strlen(document);
+
+    // The whole parse has to give back what was printed.
+    cJSON* parsed = cJSON_ParseWithLength(document, length);
+    if(parsed == NULL || !cJSON_Compare(parsed, expected, true)) {
+        printf("parsing the %zu byte document doesn't give it back\n", length);
+        return 1;
+    }
+    cJSON_Delete(parsed);
+    printf("%zu byte document parses back the same\n", length);
+
+    const unsigned char* bytes = (const unsigned char*)document;
+    timeWalk("scan_string (byte loop)", walkString, byteString, bytes, length);
+    timeWalk("scan_string (" SCAN_PATH ")", walkString, scan_string, bytes, length);
+    timeWalk("scan_whitespace (byte loop)", walkWhitespace, byteWhitespace, bytes, length);
+    timeWalk("scan_whitespace (" SCAN_PATH ")", walkWhitespace, scan_whitespace, bytes, length);
+
+    size_t rounds = 0;
+    double start = now(), elapsed;
+    do {
+        cJSON_Delete(cJSON_ParseWithLength(document, length));
+        rounds++;
+        elapsed = now() - start;
+    } while(elapsed < 0.5 || rounds < 3);
+    printf("%-30s %8.1f MB/s\n", "cJSON_ParseWithLength", (double)length * rounds / elapsed / 1e6);
+
+    cJSON_free(document);
+    cJSON_Delete(expected);
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file mkroundpack.c
+ * @author Dakota Thorpe
+ * Builds (and lists) PONiiGuesser round packs on a PC.
+ *
+ * Usage:
+ *   mkroundpack <dir> <out.zip>   Build a pack from dir/index.txt and dir/{iid}.png
+ *   mkroundpack -l <pack.zip>     List the rounds in a pack (reads it like the Wii does).
+ *   mkroundpack -t <pack.zip>     CRC check every file in a pack, a chunk at a time.
+ *
+ * index.txt has one round per line: "<iid> <season> <episode> <seekTime>".
+ * Lines starting with # are ignored.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zip.h"
+#include "misc/roundpack.h"
+
+// Lists a pack.
+static int listPack(const char* path) {
+    char errText[256];
+    roundpack_t* pack = RoundPack_Open(path, errText, sizeof(errText));
+    if(pack == NULL) {
+        fprintf(stderr, "%s\n", errText);
+        return 1;
+    }
+
+    struct MemoryStruct png = { NULL, 0, 0 };
+    int bad = 0;
+    for(int i = 0; i < RoundPack_Count(pack); i++) {
+        const packentry_t* entry = RoundPack_Entry(pack, i);
+        bool ok = RoundPack_ReadFrame(pack, i, &png);
+        printf("%s S%dE%d seek %.3f frame %zu bytes%s\n", entry->iid, entry->season, entry->episode,
+            entry->seekTime, ok ? png.size : 0, ok ? "" : " (MISSING)");
+        if(!ok) bad++;
+    }
+    printf("%d rounds\n", RoundPack_Count(pack));
+
+    free(png.memory);
+    RoundPack_Close(pack);
+    return bad ? 1 : 0;
+}
+
+// Tests a pack. Streams every entry through a small buffer, so any size of pack works.
+static int testPack(const char* path) {
+    struct zip_t* zip = zip_open(path, 0, 'r');
+    if(zip == NULL) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    char chunk[4096];
+    int bad = 0;
+    ssize_t total = zip_entries_total(zip);
+    for(ssize_t i = 0; i < total; i++) {
+        if(zip_entry_openbyindex(zip, (size_t)i) < 0) {
+            bad++;
+            continue;
+        }
+        if(zip_entry_isdir(zip)) {
+            zip_entry_close(zip);
+            continue;
+        }
+
+        ssize_t read;
+        while((read = zip_entry_readchunk(zip, chunk, sizeof(chunk))) > 0);
+        if(read < 0) {
+            printf("%s: %s\n", zip_entry_name(zip), zip_strerror((int)read));
+            bad++;
+        }
+        zip_entry_close(zip);
+    }
+    printf("%zd files, %d bad\n", total, bad);
+
+    zip_close(zip);
+    return bad ? 1 : 0;
+}
+
+// Builds a pack.
+static int buildPack(const char* dir, const char* out) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/index.txt", dir);
+    FILE* indexFile = fopen(path, "r");
+    if(indexFile == NULL) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    // Read the rounds.
+    packentry_t* entries = NULL;
+    unsigned int count = 0, capacity = 0;
+    char line[512];
+    while(fgets(line, sizeof(line), indexFile) != NULL) {
+        packentry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        if(line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if(sscanf(line, "%39s %d %d %f", entry.iid, &entry.season, &entry.episode, &entry.seekTime) != 4) {
+            fprintf(stderr, "Bad line in index.txt: %s", line);
+            fclose(indexFile);
+            free(entries);
+            return 1;
+        }
+        if(count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            entries = realloc(entries, capacity * sizeof(packentry_t));
+            if(entries == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                fclose(indexFile);
+                return 1;
+            }
+        }
+        entries[count++] = entry;
+    }
+    fclose(indexFile);
+
+    if(count == 0) {
+        fprintf(stderr, "index.txt has no rounds\n");
+        free(entries);
+        return 1;
+    }
+
+    // Level 0 = stored, PNGs don't compress anyway.
+    struct zip_t* zip = zip_open(out, 0, 'w');
+    if(zip == NULL) {
+        fprintf(stderr, "Could not create %s\n", out);
+        free(entries);
+        return 1;
+    }
+
+    // Index.
+    size_t indexSize = ROUNDPACK_HEADER_SIZE + (size_t)count * ROUNDPACK_RECORD_SIZE;
+    unsigned char* index = malloc(indexSize);
+    RoundPack_EncodeHeader(index, count);
+    for(unsigned int i = 0; i < count; i++) {
+        RoundPack_EncodeEntry(index + ROUNDPACK_HEADER_SIZE + i * ROUNDPACK_RECORD_SIZE, &entries[i]);
+    }
+    int err = zip_entry_open(zip, ROUNDPACK_INDEX_NAME);
+    if(err == 0) err = zip_entry_write(zip, index, indexSize);
+    if(err == 0) err = zip_entry_close(zip);
+    free(index);
+
+    // Frames.
+    for(unsigned int i = 0; i < count && err == 0; i++) {
+        char name[ROUNDPACK_IID_SIZE + 16];
+        snprintf(name, sizeof(name), ROUNDPACK_FRAME_FMT, entries[i].iid);
+        snprintf(path, sizeof(path), "%s/%s.png", dir, entries[i].iid);
+
+        err = zip_entry_open(zip, name);
+        if(err == 0) err = zip_entry_fwrite(zip, path);
+        if(err == 0) err = zip_entry_close(zip);
+        if(err != 0) {
+            fprintf(stderr, "Could not add %s: %s\n", path, zip_strerror(err));
+        }
+    }
+
+    zip_close(zip);
+    free(entries);
+    if(err != 0) {
+        remove(out);
+        return 1;
+    }
+
+    printf("Wrote %u rounds to %s\n", count, out);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if(argc == 3 && strcmp(argv[1], "-l") == 0) {
+        return listPack(argv[2]);
+    }
+    if(argc == 3 && strcmp(argv[1], "-t") == 0) {
+        return testPack(argv[2]);
+    }
+    if(argc == 3) {
+        return buildPack(argv[1], argv[2]);
+    }
+
+    fprintf(stderr, "Usage: %s <dir> <out.zip>\n       %s -l <pack.zip>\n       %s -t <pack.zip>\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+# mockserver.py - (C)2024 Dakota Thorpe.
+#
+# Local stand-in for the PonyGuessr API, for load testing and benchmarking the
+# networking code without the real service. Only needs Python 3.
+#
+#   python3 tools/mockserver.py --port 8080 --latency 150 --bandwidth 256
+#
+# Then point the game at it:
+#   host build:  PONII_API_BASE=http://127.0.0.1:8080/api build-host/poniiguesser
+#   Wii:         put "http://<pc ip>:8080/api" in sd:/ponii/api.txt
+#
+# With --cert/--key it serves HTTPS instead, so TLS session reuse can be measured too:
+#   openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=127.0.0.1 \
+#       -addext subjectAltName=IP:127.0.0.1 -keyout mock.key -out mock.crt
+#   python3 tools/mockserver.py --cert mock.crt --key mock.key
+#
+# Endpoints (same as the real thing):
+#   GET /api/resource/gen?...                      {"id": "<uuid>"}
+#   GET /api/resource/get/{id}.png                 the frame
+#   GET /api/resource/{id}/check?season=&episode=  {"season","episode","seekTime","expiryTs","correct"}
+#
+# Frames come from --frames (a folder of PNGs), otherwise a noise PNG of
+# --frame-size gets generated (noise, so it doesn't compress to nothing).
+
+import argparse
+import json
+import os
+import random
+import socket
+import ssl
+import struct
+import sys
+import threading
+import time
+import uuid
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+ERROR_KINDS = ("500", "reset", "truncate", "badjson")
+
+
+def make_png(width, height, rng):
+    """Random RGB noise as a PNG."""
+    raw = bytearray()
+    row = width * 3
+    for _ in range(height):
+        raw.append(0)  # Filter: none.
+        raw += rng.randbytes(row) if hasattr(rng, "randbytes") else bytes(rng.getrandbits(8) for _ in range(row))
+
+    def chunk(kind, data):
+        body = kind + data
+        return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body) & 0xFFFFFFFF)
+
+    ihdr = struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)
+    return b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", ihdr) + chunk(b"IDAT", zlib.compress(bytes(raw), 6)) + chunk(b"IEND", b"")
+
+
+class Rounds:
+    """Remembers the answer for every image ID handed out."""
+
+    def __init__(self, args):
+        self.lock = threading.Lock()
+        self.rng = random.Random(args.seed)
+        self.answers = {}
+        self.frames = []
+        if args.frames:
+            for name in sorted(os.listdir(args.frames)):
+                if name.lower().endswith(".png"):
+                    with open(os.path.join(args.frames, name), "rb") as fp:
+                        self.frames.append(fp.read())
+            if not self.frames:
+                sys.exit("mockserver: no PNGs in %s" % args.frames)
+        else:
+            width, height = (int(v) for v in args.frame_size.lower().split("x"))
+            self.frames.append(make_png(width, height, random.Random(args.seed)))
+
+    def new_round(self):
+        with self.lock:
+            iid = str(uuid.UUID(int=self.rng.getrandbits(128), version=4))
+            self.answers[iid] = {
+                "season": self.rng.randint(1, 9),
+                "episode": self.rng.randint(1, 26),
+                "seekTime": self.rng.uniform(0, 1300),
+                "frame": self.rng.randrange(len(self.frames)),
+            }
+            return iid
+
+    def get(self, iid):
+        with self.lock:
+            return self.answers.get(iid)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # Keep-alive, like the real server.
+    server_version = "PonyGuessrMock/1.0"
+    disable_nagle_algorithm = True  # Headers and body go out as separate writes, don't add 40ms delayed ACKs to every request.
+
+    def log_message(self, fmt, *args):
+        if not self.server.args.quiet:
+            sys.stderr.write("%s %s\n" % (self.address_string(), fmt % args))
+
+    def do_GET(self):
+        args = self.server.args
+        url = urlparse(self.path)
+        parts = [p for p in url.path.split("/") if p]
+
+        if args.latency or args.jitter:
+            time.sleep(max(0.0, args.latency + random.uniform(-args.jitter, args.jitter)) / 1000.0)
+
+        # Route.
+        if parts[:3] == ["api", "resource", "gen"]:
+            iid = self.server.rounds.new_round()
+            self.send_body(200, "application/json", json.dumps({"id": iid}).encode())
+        elif parts[:3] == ["api", "resource", "get"] and len(parts) == 4 and parts[3].endswith(".png"):
+            answer = self.server.rounds.get(parts[3][:-4])
+            if answer is None:
+                self.send_body(404, "application/json", b'{"error":"unknown id"}')
+            else:
+                self.send_body(200, "image/png", self.server.rounds.frames[answer["frame"]])
+        elif len(parts) == 4 and parts[:2] == ["api", "resource"] and parts[3] == "check":
+            answer = self.server.rounds.get(parts[2])
+            query = parse_qs(url.query)
+            if answer is None:
+                self.send_body(404, "application/json", b'{"error":"unknown id"}')
+                return
+            try:
+                season = int(query.get("season", ["0"])[0])
+                episode = int(query.get("episode", ["0"])[0])
+            except ValueError:
+                self.send_body(400, "application/json", b'{"error":"bad guess"}')
+                return
+            body = {
+                "season": answer["season"],
+                "episode": answer["episode"],
+                "seekTime": answer["seekTime"],
+                "expiryTs": int(time.time() * 1000) + 3600 * 1000,
+                "correct": season == answer["season"] and episode == answer["episode"],
+            }
+            self.send_body(200, "application/json", json.dumps(body).encode())
+        else:
+            self.send_body(404, "application/json", b'{"error":"not found"}')
+
+    def send_body(self, status, content_type, body):
+        args = self.server.args
+
+        # Injected failures.
+        if status == 200 and args.error_rate > 0 and random.random() < args.error_rate:
+            kind = random.choice(args.error_kinds)
+            if kind == "500":
+                status, content_type, body = 500, "application/json", b'{"error":"injected"}'
+            elif kind == "reset":
+                self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+                self.close_connection = True
+                return
+            elif kind == "badjson" and content_type == "application/json":
+                body = body[: len(body) // 2]
+            elif kind == "truncate":
+                self.send_response(status)
+                self.send_header("Content-Type", content_type)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.write_shaped(body[: len(body) // 2])
+                self.close_connection = True
+                return
+
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.write_shaped(body)
+
+    def write_shaped(self, body):
+        """Writes the body under the bandwidth cap, or as a slow drip."""
+        args = self.server.args
+        if args.drip_bytes > 0:
+            chunk, delay = args.drip_bytes, args.drip_interval / 1000.0
+        elif args.bandwidth > 0:
+            # ~20 writes a second at the capped rate.
+            chunk = max(1, int(args.bandwidth * 1024 / 20))
+            delay = chunk / (args.bandwidth * 1024.0)
+        else:
+            self.wfile.write(body)
+            return
+
+        for pos in range(0, len(body), chunk):
+            started = time.monotonic()
+            self.wfile.write(body[pos : pos + chunk])
+            self.wfile.flush()
+            left = delay - (time.monotonic() - started)
+            if left > 0 and pos + chunk < len(body):
+                time.sleep(left)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local mock of the PonyGuessr API.")
+    parser.add_argument("--bind", default="0.0.0.0", help="address to listen on (default: all)")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--frames", help="folder of PNGs to serve as frames")
+    parser.add_argument("--frame-size", default="1280x720", help="size of the generated frame (default: 1280x720)")
+    parser.add_argument("--latency", type=float, default=0, help="ms added before every response")
+    parser.add_argument("--jitter", type=float, default=0, help="+/- ms of random latency on top")
+    parser.add_argument("--bandwidth", type=float, default=0, help="KB/s cap per response (0 = unlimited)")
+    parser.add_argument("--drip-bytes", type=int, default=0, help="slow drip: send bodies this many bytes at a time")
+    parser.add_argument("--drip-interval", type=float, default=100, help="slow drip: ms between pieces (default: 100)")
+    parser.add_argument("--error-rate", type=float, default=0, help="chance (0-1) a response fails")
+    parser.add_argument("--error-kinds", default=",".join(ERROR_KINDS),
+                        help="comma separated failures to pick from: %s" % ", ".join(ERROR_KINDS))
+    parser.add_argument("--seed", type=int, default=1, help="seed for ids, answers and frames")
+    parser.add_argument("--quiet", action="store_true", help="don't log requests")
+    parser.add_argument("--cert", help="PEM certificate, serve HTTPS instead of HTTP (needs --key)")
+    parser.add_argument("--key", help="PEM private key for --cert")
+    args = parser.parse_args()
+
+    if bool(args.cert) != bool(args.key):
+        parser.error("--cert and --key go together")
+
+    args.error_kinds = [k.strip() for k in args.error_kinds.split(",") if k.strip()]
+    for kind in args.error_kinds:
+        if kind not in ERROR_KINDS:
+            parser.error("unknown error kind '%s'" % kind)
+    random.seed(args.seed)
+
+    server = ThreadingHTTPServer((args.bind, args.port), Handler)
+    server.daemon_threads = True
+    server.args = args
+    server.rounds = Rounds(args)
+    scheme = "http"
+    if args.cert:
+        # Handshakes happen per connection in the handler threads, not in accept().
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True, do_handshake_on_connect=False)
+        scheme = "https"
+    print("Mock PonyGuessr API on %s://%s:%d/api" % (scheme, args.bind, args.port), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,259 @@
+/**
+ * @file numbench.c
+ * @author Dakota Thorpe
+ * Checks and times the number fast paths in cJSON (parse_number_fast, format_number_fast) on a PC.
+ *
+ * Usage:
+ *   numbench [count]   Check a corpus of count number strings and doubles (default 1M each),
+ *                      then time parsing and printing 200k mixed numbers.
+ *
+ * Parsing is checked against the strtod path cJSON falls back on (value, validity and how
+ * much it reads), printing against strtod (every number reads back exactly) and sprintf
+ * (the fast text is what %1.15g prints, and nothing is longer than what the old
+ * %d/%1.15g/%1.17g printing gave, unless that didn't read back).
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Pulls in the whole of cJSON, so the number code (static in there) can be called directly.
+#include "../core/libcjson/cJSON.c"
+
+#define BENCH_NUMBERS 200000
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long seed = 1;
+static unsigned int next() {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned int)(seed >> 33);
+}
+
+// What parse_number does without the fast path: strtod on up to 63 number-ish bytes.
+static bool strtodParse(const char* text, size_t length, double* number, size_t* consumed) {
+    char window[64];
+    size_t i;
+    for(i = 0; i < sizeof(window) - 1 && i < length && strchr("0123456789+-eE.", text[i]) != NULL && text[i] != '\0'; i++) {
+        window[i] = text[i];
+    }
+    window[i] = '\0';
+
+    char* after = NULL;
+    *number = strtod(window, &after);
+    *consumed = (size_t)(after - window);
+    return after != window;
+}
+
+// Through the real parse_number, fast path and all.
+static bool cjsonParse(const char* text, size_t length, double* number, size_t* consumed) {
+    parse_buffer buffer;
+    cJSON item;
+    memset(&buffer, 0, sizeof(buffer));
+    memset(&item, 0, sizeof(item));
+    buffer.content = (const unsigned char*)text;
+    buffer.length = length;
+    if(!parse_number(&item, &buffer)) {
+        return false;
+    }
+    *number = item.valuedouble;
+    *consumed = buffer.offset;
+    return true;
+}
+
+// The number printing before the fast paths: %d for whole numbers, else %1.15g or %1.17g.
+static int sprintfFormat(double d, int valueint, char* out) {
+    double test = 0;
+    if(isnan(d) || isinf(d)) {
+        return sprintf(out, "null");
+    }
+    if(d == (double)valueint) {
+        return sprintf(out, "%d", valueint);
+    }
+    int length = sprintf(out, "%1.15g", d);
+    if((sscanf(out, "%lg", &test) != 1) || !compare_double(test, d)) {
+        length = sprintf(out, "%1.17g", d);
+    }
+    return length;
+}
+
+static int saturate(double d) {
+    if(d >= INT_MAX) return INT_MAX;
+    if(d <= (double)INT_MIN) return INT_MIN;
+    return (int)d;
+}
+
+static void appendDigits(char* text, size_t* length, int count) {
+    for(int i = 0; i < count; i++) {
+        text[(*length)++] = (char)('0' + next() % 10);
+    }
+}
+
+// A random number string: mostly valid JSON, some short and long, some broken.
+static size_t randomNumber(char* text) {
+    size_t length = 0;
+    unsigned int shape = next() % 16;
+
+    if(next() % 4 == 0) text[length++] = '-';
+    if(shape == 0) {
+        // Broken or odd ones strtod still takes a part of.
+        static const char* odd[] = { "", "-", "+1", ".5", "1.", "1e", "1e+", "01", "00.5", "1.e5", "1..2", "1ee2", "--1", "e5", "1E-", "0x10" };
+        length += (size_t)sprintf(text + length, "%s", odd[next() % 16]);
+    } else {
+        appendDigits(text, &length, 1 + next() % (shape < 12 ? 8 : 20));
+        if(next() % 2) {
+            text[length++] = '.';
+            // Now and then a fraction run longer than the 63 byte window.
+            appendDigits(text, &length, 1 + next() % (next() % 32 == 0 ? 80 : 12));
+        }
+        if(next() % 4 == 0) {
+            text[length++] = (next() & 1) ? 'e' : 'E';
+            if(next() % 2) text[length++] = (next() & 1) ? '+' : '-';
+            appendDigits(text, &length, 1 + next() % 3);
+        }
+    }
+    // Something after it, like in a document.
+    static const char* after = ",]} x";
+    text[length++] = after[next() % 5];
+    text[length] = '\0';
+    return length;
+}
+
+// A random double: short decimals, ms timestamps, whole numbers and raw bit patterns.
+static double randomDouble() {
+    switch(next() % 5) {
+        case 0: return (double)(int)next() / 1000.0;
+        case 1: return (double)(next() % 100000) / (double)exact_powers_of_ten[next() % 8];
+        case 2: return 1.7e12 + (double)next();
+        case 3: return (double)(int)next() * ((next() & 1) ? 1 : -1);
+        default: {
+            double d;
+            unsigned long long bits = ((unsigned long long)next() << 32) ^ next();
+            memcpy(&d, &bits, sizeof(d));
+            return (isnan(d) || isinf(d)) ? 0.5 : d;
+        }
+    }
+}
+
+static bool sameDouble(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static int checkParse(int count) {
+    char text[160];
+    int bad = 0;
+    for(int i = 0; i < count; i++) {
+        size_t length = randomNumber(text);
+        double want = 0, got = 0;
+        size_t wantLength = 0, gotLength = 0;
+        bool wantOk = strtodParse(text, length, &want, &wantLength);
+        bool gotOk = cjsonParse(text, length, &got, &gotLength);
+        if(wantOk != gotOk || (wantOk && (!sameDouble(want, got) || wantLength != gotLength))) {
+            if(bad++ < 10) {
+                printf("parse \"%s\": got %d %.17g (%zu bytes), strtod %d %.17g (%zu bytes)\n",
+                    text, gotOk, got, gotLength, wantOk, want, wantLength);
+            }
+        }
+    }
+    return bad;
+}
+
+static int checkPrint(int count) {
+    unsigned char text[26];
+    char wide[64];
+    int bad = 0;
+    for(int i = 0; i < count; i++) {
+        double d = randomDouble();
+        int length = format_number(d, saturate(d), text);
+        double back = strtod((const char*)text, NULL);
+
+        // No longer than the old formatter, unless what that printed didn't read back exactly.
+        int old = sprintfFormat(d, saturate(d), wide);
+        bool oldExact = sameDouble(strtod(wide, NULL), d);
+
+        bool ok = length > 0 && (d == 0 ? back == 0 : sameDouble(back, d)) && (!oldExact || length <= old);
+        int fast = format_number_fast(d, text);
+        if(ok && fast > 0) {
+            sprintf(wide, "%1.15g", d);
+            ok = strcmp((const char*)text, wide) == 0;
+        }
+        if(!ok && bad++ < 10) {
+            printf("print %.17g: got \"%s\" (fast %d), reads back %.17g\n", d, text, fast, back);
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    int bad = checkParse(count) + checkPrint(count);
+    if(bad) {
+        printf("%d mismatches\n", bad);
+        return 1;
+    }
+    printf("%d number strings parse like strtod, %d doubles print exactly\n", count, count);
+
+    // Number heavy data, the kind the API sends: ids, ms timestamps, short decimals.
+    double* numbers = malloc(BENCH_NUMBERS * sizeof(double));
+    char* texts = malloc(BENCH_NUMBERS * 32);
+    if(numbers == NULL || texts == NULL) {
+        return 1;
+    }
+    for(int i = 0; i < BENCH_NUMBERS; i++) {
+        switch(i % 3) {
+            case 0: numbers[i] = next() % 100000; break;
+            case 1: numbers[i] = 1.7e12 + next(); break;
+            default: numbers[i] = (double)(next() % 1000000) / 1000.0; break;
+        }
+        format_number(numbers[i], saturate(numbers[i]), (unsigned char*)texts + i * 32);
+    }
+
+    volatile double sink = 0;  // Keeps the loops from being thrown away.
+    double start, elapsed;
+    size_t used;
+
+    start = now();
+    for(int i = 0; i < BENCH_NUMBERS; i++) {
+        const char* text = texts + i * 32;
+        double d = 0;
+        strtodParse(text, strlen(text), &d, &used);
+        sink += d;
+    }
+    elapsed = now() - start;
+    printf("parse, strtod         %7.1f ns/number\n", elapsed / BENCH_NUMBERS * 1e9);
+
+    start = now();
+    for(int i = 0; i < BENCH_NUMBERS; i++) {
+        const char* text = texts + i * 32;
+        double d = 0;
+        cjsonParse(text, strlen(text), &d, &used);
+        sink += d;
+    }
+    elapsed = now() - start;
+    printf("parse, parse_number   %7.1f ns/number\n", elapsed / BENCH_NUMBERS * 1e9);
+
+    char out[64];
+    start = now();
+    for(int i = 0; i < BENCH_NUMBERS; i++) {
+        sink += sprintfFormat(numbers[i], saturate(numbers[i]), out);
+    }
+    elapsed = now() - start;
+    printf("print, sprintf        %7.1f ns/number\n", elapsed / BENCH_NUMBERS * 1e9);
+
+    start = now();
+    for(int i = 0; i < BENCH_NUMBERS; i++) {
+        sink += format_number(numbers[i], saturate(numbers[i]), (unsigned char*)out);
+    }
+    elapsed = now() - start;
+    printf("print, format_number  %7.1f ns/number\n", elapsed / BENCH_NUMBERS * 1e9);
+
+    free(numbers);
+    free(texts);
+    return 0;
+}
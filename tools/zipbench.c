@@ -0,0 +1,149 @@
+/**
+ * @file zipbench.c
+ * @author Dakota Thorpe
+ * Checks and times the entry name index in zip.c on a PC.
+ *
+ * Usage:
+ *   zipbench [entries]   Build an archive with that many entries (default 10000) and time
+ *                        opening every entry by name with the index and without it.
+ *
+ * Without the index zip_entry_open goes to miniz's mz_zip_reader_locate_file, which is a
+ * linear search here (zip.c keeps the central directory unsorted). Both have to find the
+ * same entry for every name, in both cases.
+*/
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Pulls in the whole of zip.c, so the index can be switched off on an open archive.
+#include "../core/zip.c"
+
+#define ZIPBENCH_ARCHIVE "zipbench.zip"
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Round pack style names, so they share long prefixes like real ones do.
+static void entryName(char* name, size_t size, int i) {
+    snprintf(name, size, "frames/s%02d/e%02d/%05d-Frame.png", i % 9 + 1, i / 9 % 26 + 1, i);
+}
+
+static bool build(const char* path, int entries) {
+    struct zip_t* zip = zip_open(path, 0, 'w');
+    if(zip == NULL) {
+        return false;
+    }
+    char name[64];
+    for(int i = 0; i < entries; i++) {
+        entryName(name, sizeof(name), i);
+        if(zip_entry_open(zip, name) < 0 || zip_entry_write(zip, name, strlen(name)) < 0 || zip_entry_close(zip) < 0) {
+            zip_close(zip);
+            return false;
+        }
+    }
+    zip_close(zip);
+    return true;
+}
+
+// Opens every name in order, returns the entry indexes in found (-1 for not found).
+static void openAll(struct zip_t* zip, char (*names)[64], const int* order, int entries, bool caseSensitive, ssize_t* found) {
+    for(int i = 0; i < entries; i++) {
+        const char* name = names[order[i]];
+        int err = caseSensitive ? zip_entry_opencasesensitive(zip, name) : zip_entry_open(zip, name);
+        found[order[i]] = err < 0 ? -1 : zip_entry_index(zip);
+        zip_entry_close(zip);
+    }
+}
+
+int main(int argc, char** argv) {
+    int entries = argc > 1 ? atoi(argv[1]) : 10000;
+    if(entries < 1) {
+        fprintf(stderr, "usage: %s [entries]\n", argv[0]);
+        return 1;
+    }
+
+    if(!build(ZIPBENCH_ARCHIVE, entries)) {
+        fprintf(stderr, "Could not write %s\n", ZIPBENCH_ARCHIVE);
+        return 1;
+    }
+
+    // Looked up shuffled, and with the case changed for the case insensitive lookups.
+    char (*names)[64] = malloc(entries * sizeof(*names));
+    char (*upper)[64] = malloc(entries * sizeof(*upper));
+    int* order = malloc(entries * sizeof(int));
+    ssize_t* indexed = malloc(entries * sizeof(ssize_t));
+    ssize_t* linear = malloc(entries * sizeof(ssize_t));
+    if(names == NULL || upper == NULL || order == NULL || indexed == NULL || linear == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    srand(1);
+    for(int i = 0; i < entries; i++) {
+        entryName(names[i], sizeof(names[i]), i);
+        for(size_t c = 0; c < sizeof(upper[i]); c++) {
+            upper[i][c] = (char)toupper((unsigned char)names[i][c]);
+        }
+        order[i] = i;
+    }
+    for(int i = entries - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    struct zip_t* zip = zip_open(ZIPBENCH_ARCHIVE, 0, 'r');
+    if(zip == NULL || zip->name_index == NULL) {
+        fprintf(stderr, "Could not open %s with an index\n", ZIPBENCH_ARCHIVE);
+        return 1;
+    }
+    mz_uint32* index = zip->name_index;
+    printf("%d entries\n", entries);
+
+    int bad = 0;
+    for(int pass = 0; pass < 2; pass++) {
+        bool caseSensitive = pass == 0;
+        char (*lookup)[64] = caseSensitive ? names : upper;
+
+        zip->name_index = index;
+        double start = now();
+        openAll(zip, lookup, order, entries, caseSensitive, indexed);
+        double withIndex = now() - start;
+
+        zip->name_index = NULL;     // zip_entry_open goes to miniz now.
+        start = now();
+        openAll(zip, lookup, order, entries, caseSensitive, linear);
+        double without = now() - start;
+
+        for(int i = 0; i < entries; i++) {
+            if(indexed[i] != i || linear[i] != i) {
+                if(bad++ < 10) {
+                    printf("%s: index found %d, miniz %d, want %d\n", lookup[i], (int)indexed[i], (int)linear[i], i);
+                }
+            }
+        }
+        printf("%-16s index %8.1f ns/open   locate_file %10.1f ns/open   (%.0fx)\n",
+            caseSensitive ? "case sensitive" : "case insensitive",
+            withIndex / entries * 1e9, without / entries * 1e9, without / withIndex);
+    }
+
+    zip->name_index = index;
+    zip_close(zip);
+    remove(ZIPBENCH_ARCHIVE);
+    free(names);
+    free(upper);
+    free(order);
+    free(indexed);
+    free(linear);
+    if(bad) {
+        printf("%d mismatches\n", bad);
+        return 1;
+    }
+    return 0;
+}